@@ -54,6 +54,7 @@ typedef struct ALARM_INFO_TAG
 } ALARM_INFO;
 
 #define MIN_ID_VALUE                100
+#define ALARM_NO_TRIGGER            UINT32_MAX
 
 typedef struct ALARM_SCHEDULER_TAG* SCHEDULER_HANDLE;
 
@@ -62,6 +63,7 @@ MOCKABLE_FUNCTION(, void, alarm_scheduler_destroy, SCHEDULER_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, int, alarm_scheduler_add_alarm, SCHEDULER_HANDLE, handle, const char*, alarm_text, const TIME_INFO*, time, uint32_t, trigger_days, const char*, sound_file, uint8_t, snooze_min, uint8_t*, alarm_id);
 MOCKABLE_FUNCTION(, int, alarm_scheduler_add_alarm_info, SCHEDULER_HANDLE, handle, ALARM_INFO*, alarm_info);
+MOCKABLE_FUNCTION(, int, alarm_scheduler_add_alarms, SCHEDULER_HANDLE, handle, const ALARM_INFO*, alarm_list, size_t, alarm_count);
 MOCKABLE_FUNCTION(, int, alarm_scheduler_remove_alarm, SCHEDULER_HANDLE, handle, size_t, alarm_index);
 MOCKABLE_FUNCTION(, int, alarm_scheduler_delete_alarm, SCHEDULER_HANDLE, handle, uint8_t, alarm_id);
 
@@ -71,9 +73,30 @@ MOCKABLE_FUNCTION(, const ALARM_INFO*, alarm_scheduler_get_alarm, SCHEDULER_HAND
 MOCKABLE_FUNCTION(, const ALARM_INFO*, alarm_scheduler_get_alarm_by_id, SCHEDULER_HANDLE, handle, size_t, id);
 
 MOCKABLE_FUNCTION(, const ALARM_INFO*, alarm_scheduler_get_next_alarm, SCHEDULER_HANDLE, handle);
+// Changes each time alarm_scheduler_get_next_alarm recalculates the next alarm
+MOCKABLE_FUNCTION(, uint32_t, alarm_scheduler_get_next_alarm_generation, SCHEDULER_HANDLE, handle);
 MOCKABLE_FUNCTION(, const ALARM_INFO*, alarm_scheduler_is_triggered, SCHEDULER_HANDLE, handle, const struct tm*, curr_time);
+// Fills triggered_list with up to list_size alarms firing at curr_time and returns the count.
+// Alarms that did not fit are returned by the next call for the same minute.
+MOCKABLE_FUNCTION(, size_t, alarm_scheduler_get_triggered_alarms, SCHEDULER_HANDLE, handle, const struct tm*, curr_time, const ALARM_INFO**, triggered_list, size_t, list_size);
+// Same as alarm_scheduler_get_triggered_alarms on absolute time.  Each alarm is given its
+// next fire instant in local time once and only rescheduled after it fires, so DST
+// changes neither skip nor repeat an alarm.
+MOCKABLE_FUNCTION(, size_t, alarm_scheduler_get_due_alarms, SCHEDULER_HANDLE, handle, time_t, now, const ALARM_INFO**, triggered_list, size_t, list_size);
+// Recomputes every fire instant on the next alarm_scheduler_get_due_alarms call
+MOCKABLE_FUNCTION(, void, alarm_scheduler_timezone_changed, SCHEDULER_HANDLE, handle);
+// Next instant alarm_scheduler_get_due_alarms has work to do, 0 when it should be called right away
+MOCKABLE_FUNCTION(, time_t, alarm_scheduler_get_next_due_time, SCHEDULER_HANDLE, handle);
+// Alarm alarm_scheduler_get_due_alarms returns next and the instant it fires at
+MOCKABLE_FUNCTION(, const ALARM_INFO*, alarm_scheduler_get_next_due_alarm, SCHEDULER_HANDLE, handle, time_t*, fire_time);
+// Instant an alarm returned by alarm_scheduler_get_due_alarms was scheduled to fire at
+MOCKABLE_FUNCTION(, time_t, alarm_scheduler_get_fire_time, SCHEDULER_HANDLE, handle, const ALARM_INFO*, alarm_info);
+// Hands back an alarm returned by alarm_scheduler_get_due_alarms.  A fired snooze or one
+// time alarm is kept past midnight until it is released, the pointer is invalid afterwards.
+MOCKABLE_FUNCTION(, void, alarm_scheduler_release_alarm, SCHEDULER_HANDLE, handle, const ALARM_INFO*, alarm_info);
 MOCKABLE_FUNCTION(, int, alarm_scheduler_snooze_alarm, SCHEDULER_HANDLE, handle, const ALARM_INFO*, alarm_info);
 MOCKABLE_FUNCTION(, int, alarm_scheduler_get_next_day, const ALARM_INFO*, alarm_info);
+MOCKABLE_FUNCTION(, uint32_t, alarm_scheduler_get_minutes_till_trigger, const ALARM_INFO*, alarm_info, const struct tm*, curr_time);
 
 MOCKABLE_FUNCTION(, bool, alarm_scheduler_is_morning, const TIME_INFO*, time_info);
 
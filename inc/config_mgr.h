@@ -41,6 +41,8 @@ MOCKABLE_FUNCTION(, void, config_mgr_destroy,  CONFIG_MGR_HANDLE, handle);
 MOCKABLE_FUNCTION(, bool, config_mgr_save, CONFIG_MGR_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, const char*, config_mgr_get_ntp_address, CONFIG_MGR_HANDLE, handle);
+// Fills server_list with up to list_count servers from ntpServers, or ntpAddress when that is missing
+MOCKABLE_FUNCTION(, size_t, config_mgr_get_ntp_servers, CONFIG_MGR_HANDLE, handle, const char**, server_list, size_t, list_count);
 MOCKABLE_FUNCTION(, const char*, config_mgr_get_zipcode, CONFIG_MGR_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, config_mgr_set_zipcode, CONFIG_MGR_HANDLE, handle, const char*, zipecode);
 MOCKABLE_FUNCTION(, const char*, config_mgr_get_audio_dir, CONFIG_MGR_HANDLE, handle);
@@ -60,6 +62,12 @@ MOCKABLE_FUNCTION(, int, config_mgr_store_alarm, CONFIG_MGR_HANDLE, handle, cons
 
 MOCKABLE_FUNCTION(, uint8_t, config_mgr_format_hour, CONFIG_MGR_HANDLE, handle, int, hour);
 MOCKABLE_FUNCTION(, bool, config_mgr_show_seconds, CONFIG_MGR_HANDLE, handle);
+// Seconds before an alarm fires that its sound gets loaded
+MOCKABLE_FUNCTION(, uint32_t, config_mgr_get_alarm_prepare_time, CONFIG_MGR_HANDLE, handle);
+// Kilobytes of decoded alarm sounds kept in memory between plays
+MOCKABLE_FUNCTION(, uint32_t, config_mgr_get_sound_cache_size, CONFIG_MGR_HANDLE, handle);
+// Seconds an alarm takes to ramp up to full volume, 0 when alarms start at full volume
+MOCKABLE_FUNCTION(, uint32_t, config_mgr_get_crescendo_time, CONFIG_MGR_HANDLE, handle);
 
 
 #ifdef __cplusplus
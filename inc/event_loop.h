@@ -0,0 +1,38 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include <time.h>
+
+#include "umock_c/umock_c_prod.h"
+
+#define EVENT_LOOP_WAIT_FOREVER     SIZE_MAX
+
+typedef struct EVENT_LOOP_INFO_TAG* EVENT_LOOP_HANDLE;
+
+MOCKABLE_FUNCTION(, EVENT_LOOP_HANDLE, event_loop_create);
+MOCKABLE_FUNCTION(, void, event_loop_destroy, EVENT_LOOP_HANDLE, handle);
+
+// Wakes event_loop_wait whenever fd becomes readable
+MOCKABLE_FUNCTION(, int, event_loop_add_fd, EVENT_LOOP_HANDLE, handle, int, fd);
+MOCKABLE_FUNCTION(, int, event_loop_remove_fd, EVENT_LOOP_HANDLE, handle, int, fd);
+
+// Sleeps until a registered fd is readable, the wall clock reaches wake_time, the wall
+// clock is set or max_wait_ms elapses.  A wake_time of 0 only waits on the fds.
+MOCKABLE_FUNCTION(, int, event_loop_wait, EVENT_LOOP_HANDLE, handle, time_t, wake_time, size_t, max_wait_ms);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // EVENT_LOOP_H
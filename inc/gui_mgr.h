@@ -53,6 +53,8 @@ MOCKABLE_FUNCTION(, GUI_MGR_HANDLE, gui_mgr_create, CONFIG_MGR_HANDLE, config_mg
 MOCKABLE_FUNCTION(, void, gui_mgr_destroy, GUI_MGR_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, size_t, gui_mgr_get_refresh_resolution);
+// fd that becomes readable on user input, -1 when the gui has to be polled every refresh resolution
+MOCKABLE_FUNCTION(, int, gui_mgr_get_input_fd, GUI_MGR_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, gui_mgr_create_win, GUI_MGR_HANDLE, handle);
 MOCKABLE_FUNCTION(, void, gui_mgr_process_items, GUI_MGR_HANDLE, handle);
 
@@ -0,0 +1,46 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#include "umock_c/umock_c_prod.h"
+
+// Each power of two microseconds is split into 8 linear buckets, so any
+// percentile is within 12.5% of the real value
+#define LATENCY_SUB_BUCKET_BITS     3
+#define LATENCY_SUB_BUCKET_COUNT    (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_MAGNITUDE       40
+#define LATENCY_MAX_USEC            ((UINT64_C(1) << LATENCY_MAX_MAGNITUDE) - 1)
+#define LATENCY_BUCKET_COUNT        ((LATENCY_MAX_MAGNITUDE - LATENCY_SUB_BUCKET_BITS + 1)*LATENCY_SUB_BUCKET_COUNT)
+
+typedef struct LATENCY_HISTOGRAM_TAG
+{
+    uint32_t buckets[LATENCY_BUCKET_COUNT];
+    uint32_t count;
+    uint64_t total_usec;
+    uint64_t max_usec;
+} LATENCY_HISTOGRAM;
+
+MOCKABLE_FUNCTION(, void, latency_stats_init, LATENCY_HISTOGRAM*, histogram);
+MOCKABLE_FUNCTION(, void, latency_stats_add, LATENCY_HISTOGRAM*, histogram, uint64_t, latency_usec);
+
+MOCKABLE_FUNCTION(, uint32_t, latency_stats_get_count, const LATENCY_HISTOGRAM*, histogram);
+MOCKABLE_FUNCTION(, uint64_t, latency_stats_get_mean, const LATENCY_HISTOGRAM*, histogram);
+MOCKABLE_FUNCTION(, uint64_t, latency_stats_get_max, const LATENCY_HISTOGRAM*, histogram);
+// Upper bound of the bucket holding the requested percentile (1 - 100) in microseconds
+MOCKABLE_FUNCTION(, uint64_t, latency_stats_get_percentile, const LATENCY_HISTOGRAM*, histogram, uint32_t, percentile);
+
+MOCKABLE_FUNCTION(, void, latency_stats_log, const LATENCY_HISTOGRAM*, histogram, const char*, name);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // LATENCY_STATS_H
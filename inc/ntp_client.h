@@ -13,6 +13,12 @@ extern "C" {
 
 #include "umock_c/umock_c_prod.h"
 
+// Most servers a single time query asks in parallel
+#define NTP_CLIENT_MAX_SERVERS      4
+// Bounds of the interval ntp_client_get_poll_interval hands out
+#define NTP_CLIENT_MIN_POLL_SEC     64
+#define NTP_CLIENT_MAX_POLL_SEC     (36*60*60)
+
 typedef struct NTP_CLIENT_INFO_TAG* NTP_CLIENT_HANDLE;
 
 typedef enum NTP_OPERATION_RESULT_TAG
@@ -24,12 +30,24 @@ typedef enum NTP_OPERATION_RESULT_TAG
 } NTP_OPERATION_RESULT;
 
 typedef void(*NTP_TIME_CALLBACK)(void* user_ctx, NTP_OPERATION_RESULT ntp_result, time_t current_time);
+// offset is what has to be added to the local clock to match the server and
+// delay is the round trip network delay, both are NULL on failure. tv_nsec
+// is always positive so a negative offset has a negative tv_sec
+typedef void(*NTP_OFFSET_CALLBACK)(void* user_ctx, NTP_OPERATION_RESULT ntp_result, const struct timespec* offset, const struct timespec* delay);
 
 MOCKABLE_FUNCTION(, NTP_CLIENT_HANDLE, ntp_client_create);
 MOCKABLE_FUNCTION(, void, ntp_client_destroy, NTP_CLIENT_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, int, ntp_client_get_time, NTP_CLIENT_HANDLE, handle, const char*, time_server, size_t, timeout_sec, NTP_TIME_CALLBACK, ntp_callback, void*, user_ctx);
+// Queries every server at once and reports the reply with the lowest network delay
+MOCKABLE_FUNCTION(, int, ntp_client_get_time_multi, NTP_CLIENT_HANDLE, handle, const char**, server_list, size_t, server_count, size_t, timeout_sec, NTP_TIME_CALLBACK, ntp_callback, void*, user_ctx);
+// Same query as ntp_client_get_time_multi reporting the sub-second clock offset
+MOCKABLE_FUNCTION(, int, ntp_client_get_offset, NTP_CLIENT_HANDLE, handle, const char**, server_list, size_t, server_count, size_t, timeout_sec, NTP_OFFSET_CALLBACK, offset_callback, void*, user_ctx);
 MOCKABLE_FUNCTION(, void, ntp_client_process, NTP_CLIENT_HANDLE, handle);
+// Seconds until the next query is due. The interval grows while the offsets
+// stay inside the measured jitter, shrinks when they do not and backs off
+// after failed queries, each call adds a little randomness
+MOCKABLE_FUNCTION(, size_t, ntp_client_get_poll_interval, NTP_CLIENT_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, int, ntp_client_set_time, const char*, time_server, size_t, timeout_sec);
 
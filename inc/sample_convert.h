@@ -0,0 +1,45 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "umock_c/umock_c_prod.h"
+
+#define SAMPLE_CONVERT_IMPL_VALUES  \
+    SAMPLE_CONVERT_SCALAR,          \
+    SAMPLE_CONVERT_SSSE3,           \
+    SAMPLE_CONVERT_AVX2
+
+typedef enum SAMPLE_CONVERT_IMPL_TAG
+{
+    SAMPLE_CONVERT_IMPL_VALUES
+} SAMPLE_CONVERT_IMPL;
+
+// The fastest kernel the cpu supports is picked on first use, forcing one
+// is meant for tests and benchmarks
+MOCKABLE_FUNCTION(, int, sample_convert_set_impl, SAMPLE_CONVERT_IMPL, impl);
+MOCKABLE_FUNCTION(, SAMPLE_CONVERT_IMPL, sample_convert_get_impl);
+
+// Reverses the byte order of each 16 bit sample in place
+MOCKABLE_FUNCTION(, void, sample_convert_swap_16, int16_t*, samples, size_t, count);
+// Unsigned 8 bit PCM to signed 16 bit PCM
+MOCKABLE_FUNCTION(, void, sample_convert_widen_8, const uint8_t*, source, int16_t*, target, size_t, count);
+// Averages each left/right pair into one sample, target may be source
+MOCKABLE_FUNCTION(, void, sample_convert_downmix_stereo, const int16_t*, source, int16_t*, target, size_t, frames);
+// Scales samples in place by gain, clamped to 0.0 - 1.0
+MOCKABLE_FUNCTION(, void, sample_convert_apply_gain, int16_t*, samples, size_t, count, float, gain);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // SAMPLE_CONVERT_H
@@ -10,7 +10,25 @@ extern "C" {
 #include <stdbool.h>
 #endif /* __cplusplus */
 
+#include "latency_stats.h"
+
+// Each stage is measured from the instant the alarm was scheduled to fire
+typedef enum ALARM_LATENCY_STAGE_TAG
+{
+    // The scheduler reported the alarm due
+    ALARM_LATENCY_DETECTED,
+    // The gui shows the alarm
+    ALARM_LATENCY_DISPLAYED,
+    // The first audio buffer is queued
+    ALARM_LATENCY_AUDIBLE,
+    // The gui shows an alarm that waited for another one to stop ringing,
+    // these skip the displayed and audible stages
+    ALARM_LATENCY_QUEUED,
+    ALARM_LATENCY_STAGE_COUNT
+} ALARM_LATENCY_STAGE;
+
 extern int run_application(int argc, char* argv[]);
+extern const LATENCY_HISTOGRAM* smartclock_get_alarm_latency(ALARM_LATENCY_STAGE stage);
 
 #ifdef __cplusplus
 }
@@ -6,9 +6,11 @@
 #ifdef __cplusplus
 extern "C" {
 #include <cstdint>
+#include <cstddef>
 #else
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #endif /* __cplusplus */
 
 #include "umock_c/umock_c_prod.h"
@@ -21,13 +23,30 @@ typedef enum SOUND_MGR_STATE_TAG
     SOUND_STATE_ERROR
 } SOUND_MGR_STATE;
 
+typedef enum SOUND_CRESCENDO_CURVE_TAG
+{
+    SOUND_CRESCENDO_LINEAR,
+    SOUND_CRESCENDO_LOUDNESS,
+    SOUND_CRESCENDO_S_CURVE
+} SOUND_CRESCENDO_CURVE;
+
 typedef struct SOUND_MGR_INFO_TAG* SOUND_MGR_HANDLE;
 
 MOCKABLE_FUNCTION(, SOUND_MGR_HANDLE, sound_mgr_create);
 MOCKABLE_FUNCTION(, void, sound_mgr_destroy, SOUND_MGR_HANDLE, handle);
 
+// Loads and uploads sound_file ahead of time so the next sound_mgr_play of it only starts the source
+MOCKABLE_FUNCTION(, int, sound_mgr_prepare, SOUND_MGR_HANDLE, handle, const char*, sound_file);
+// Bytes of decoded audio kept for replays once a sound stops
+MOCKABLE_FUNCTION(, int, sound_mgr_set_cache_limit, SOUND_MGR_HANDLE, handle, size_t, cache_limit);
+// Shape and length in milliseconds of the volume ramp a crescendo play runs
+// in the background, a time under 50 milliseconds plays at full volume
+MOCKABLE_FUNCTION(, int, sound_mgr_set_crescendo, SOUND_MGR_HANDLE, handle, SOUND_CRESCENDO_CURVE, curve, uint32_t, crescendo_time);
 MOCKABLE_FUNCTION(, int, sound_mgr_play, SOUND_MGR_HANDLE, handle, const char*, sound_file, bool, set_repeat, bool, crescendo);
 MOCKABLE_FUNCTION(, int, sound_mgr_stop, SOUND_MGR_HANDLE, handle);
+// Keeps a streamed sound fed and goes back to idle once a stream that doesn't
+// repeat has played out, call it at least every few hundred milliseconds while playing
+MOCKABLE_FUNCTION(, int, sound_mgr_process, SOUND_MGR_HANDLE, handle);
 MOCKABLE_FUNCTION(, SOUND_MGR_STATE, sound_mgr_get_current_state, SOUND_MGR_HANDLE, handle);
 
 MOCKABLE_FUNCTION(, float, sound_mgr_get_volume, SOUND_MGR_HANDLE, handle);
@@ -6,6 +6,7 @@
 extern "C" {
 #include <cstdint>
 #else
+#include <stdint.h>
 #include <time.h>
 #endif /* __cplusplus */
 
@@ -13,5 +14,11 @@ extern "C" {
 
 MOCKABLE_FUNCTION(, time_t, get_time);
 MOCKABLE_FUNCTION(, struct tm*, get_time_value);
+// Wall clock time in microseconds since the epoch
+MOCKABLE_FUNCTION(, int64_t, get_time_usec);
 
 MOCKABLE_FUNCTION(, int, set_machine_time, time_t*, set_time);
+// Brings the clock in line with an NTP offset. Sub-second offsets are slewed
+// and trim the clock frequency by the drift seen since the last sample,
+// larger ones step the clock
+MOCKABLE_FUNCTION(, int, discipline_machine_time, const struct timespec*, offset);
@@ -0,0 +1,558 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "alarm_scheduler.h"
+
+#define MINUTES_IN_HOUR     60
+#define MINUTES_IN_DAY      (24*MINUTES_IN_HOUR)
+#define MINUTES_IN_WEEK     (7*MINUTES_IN_DAY)
+
+static const size_t ALARM_COUNTS[] = { 10, 100, 1000, 10000, 100000 };
+static const size_t LOAD_ALARM_COUNT = 50000;
+static const size_t SCAN_ITERATIONS = 200;
+static const char* SOUND_FILES[] = { "beep.wav", "birds.wav", "radio.wav", "chimes.wav" };
+
+#if defined(__GLIBC__)
+// Count the heap traffic of the scheduler by interposing malloc/realloc.
+// Bytes include the allocator's chunk header and rounding.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static size_t g_alloc_count;
+static size_t g_alloc_bytes;
+
+void* malloc(size_t size)
+{
+    void* result = __libc_malloc(size);
+    if (result != NULL)
+    {
+        g_alloc_count++;
+        g_alloc_bytes += malloc_usable_size(result) + sizeof(size_t);
+    }
+    return result;
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    size_t prev_size = ptr == NULL ? 0 : malloc_usable_size(ptr) + sizeof(size_t);
+    void* result = __libc_realloc(ptr, size);
+    if (result != NULL)
+    {
+        g_alloc_count++;
+        g_alloc_bytes += malloc_usable_size(result) + sizeof(size_t) - prev_size;
+    }
+    return result;
+}
+#endif
+
+#if defined(__linux__)
+// Hardware cache miss counter for the calling thread, -1 when the kernel or
+// the machine does not expose one (containers, VMs, perf_event_paranoid)
+static int open_cache_miss_counter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void start_counter(int counter)
+{
+    if (counter >= 0)
+    {
+        (void)ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        (void)ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static bool stop_counter(int counter, uint64_t* value)
+{
+    bool result = false;
+    if (counter >= 0)
+    {
+        (void)ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        result = read(counter, value, sizeof(*value)) == sizeof(*value);
+    }
+    return result;
+}
+#endif
+
+static uint32_t g_random_seed = 2463534242u;
+
+static uint32_t next_random(void)
+{
+    // xorshift keeps the run reproducible across platforms
+    g_random_seed ^= g_random_seed << 13;
+    g_random_seed ^= g_random_seed >> 17;
+    g_random_seed ^= g_random_seed << 5;
+    return g_random_seed;
+}
+
+static uint64_t get_elapsed_ns(const struct timespec* start, const struct timespec* end)
+{
+    return (uint64_t)(end->tv_sec - start->tv_sec)*1000000000ull + (uint64_t)end->tv_nsec - (uint64_t)start->tv_nsec;
+}
+
+// The day walking comparator the scheduler used before the closed form
+// minutes till trigger calculation, kept here as the baseline
+static uint32_t legacy_day_value(int wday)
+{
+    static const uint32_t DAY_VALUES[] = { Sunday, Monday, Tuesday, Wednesday, Thursday, Friday, Saturday };
+    return DAY_VALUES[wday];
+}
+
+static int legacy_days_till_trigger(const ALARM_INFO* alarm_info, const struct tm* curr_time)
+{
+    int result = 0;
+    int target_day = curr_time->tm_wday;
+    do
+    {
+        if (legacy_day_value(target_day) & alarm_info->trigger_days)
+        {
+            if (result >= 7)
+            {
+                break;
+            }
+            else if (target_day != curr_time->tm_wday)
+            {
+                break;
+            }
+            else if (alarm_info->trigger_time.hour == curr_time->tm_hour)
+            {
+                if (alarm_info->trigger_time.min > curr_time->tm_min)
+                {
+                    break;
+                }
+            }
+            else if (alarm_info->trigger_time.hour > curr_time->tm_hour)
+            {
+                break;
+            }
+        }
+        target_day = target_day == 6 ? 0 : target_day+1;
+        result++;
+    } while (true);
+    return result;
+}
+
+static bool legacy_is_alarm_initial_sooner(const ALARM_INFO* ai_initial, const ALARM_INFO* ai_compare, const struct tm* curr_time)
+{
+    bool result;
+    int init_val_delta = legacy_days_till_trigger(ai_initial, curr_time);
+    int cmp_val_delta = legacy_days_till_trigger(ai_compare, curr_time);
+    if (init_val_delta != cmp_val_delta)
+    {
+        result = cmp_val_delta < init_val_delta;
+    }
+    else if (ai_initial->trigger_time.hour == ai_compare->trigger_time.hour)
+    {
+        result = ai_initial->trigger_time.min > ai_compare->trigger_time.min;
+    }
+    else if ((ai_initial->trigger_time.hour >= curr_time->tm_hour && ai_compare->trigger_time.hour >= curr_time->tm_hour) ||
+        (ai_initial->trigger_time.hour <= curr_time->tm_hour && ai_compare->trigger_time.hour <= curr_time->tm_hour))
+    {
+        result = ai_initial->trigger_time.hour > ai_compare->trigger_time.hour;
+    }
+    else
+    {
+        result = !(ai_initial->trigger_time.hour >= curr_time->tm_hour && ai_compare->trigger_time.hour < curr_time->tm_hour);
+    }
+    return result;
+}
+
+static int load_alarms(SCHEDULER_HANDLE scheduler, size_t alarm_count)
+{
+    int result = 0;
+    for (size_t index = 0; index < alarm_count; index++)
+    {
+        TIME_INFO time_info = { 0 };
+        time_info.hour = next_random() % 24;
+        time_info.min = next_random() % 60;
+        uint32_t trigger_days = (next_random() % Everyday) + 1;
+        if (alarm_scheduler_add_alarm(scheduler, "perf alarm", &time_info, trigger_days, "perf.wav", 5, NULL) != 0)
+        {
+            printf("Failure adding alarm %zu\r\n", index);
+            result = __LINE__;
+            break;
+        }
+    }
+    return result;
+}
+
+// Loads alarms the way the config does, a handful of shared sound files and
+// a text per alarm, and reports the time and heap traffic per alarm
+static void run_load_benchmark(size_t alarm_count)
+{
+    struct timespec start, end;
+#if defined(__GLIBC__)
+    g_alloc_count = 0;
+    g_alloc_bytes = 0;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    SCHEDULER_HANDLE scheduler;
+    if ((scheduler = alarm_scheduler_create()) == NULL)
+    {
+        printf("Failure creating alarm scheduler\r\n");
+    }
+    else
+    {
+        size_t index;
+        for (index = 0; index < alarm_count; index++)
+        {
+            char alarm_text[32];
+            TIME_INFO time_info = { 0 };
+            time_info.hour = next_random() % 24;
+            time_info.min = next_random() % 60;
+            sprintf(alarm_text, "Alarm %zu", index % 64);
+            if (alarm_scheduler_add_alarm(scheduler, alarm_text, &time_info, Monday|Tuesday|Wednesday|Thursday|Friday, SOUND_FILES[index % 4], 5, NULL) != 0)
+            {
+                printf("Failure adding alarm %zu\r\n", index);
+                break;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+#if defined(__GLIBC__)
+        printf("%8zu alarms: %8.1f ns, %zu allocations, %.1f bytes per alarm\r\n", index, (double)get_elapsed_ns(&start, &end)/alarm_count,
+            g_alloc_count, (double)g_alloc_bytes/alarm_count);
+#else
+        printf("%8zu alarms: %8.1f ns per alarm\r\n", index, (double)get_elapsed_ns(&start, &end)/alarm_count);
+#endif
+        alarm_scheduler_destroy(scheduler);
+    }
+}
+
+// Compares adding a config's worth of alarms one at a time with handing the
+// scheduler the whole list, the way smartclock loads them at startup
+static void run_startup_benchmark(size_t alarm_count)
+{
+    ALARM_INFO* alarm_list;
+    if ((alarm_list = (ALARM_INFO*)calloc(alarm_count, sizeof(ALARM_INFO))) == NULL)
+    {
+        printf("Failure allocating alarm list\r\n");
+    }
+    else
+    {
+        uint64_t single_elapsed = 0;
+        uint64_t batch_elapsed = 0;
+        struct timespec start, end;
+        for (size_t index = 0; index < alarm_count; index++)
+        {
+            alarm_list[index].trigger_time.hour = next_random() % 24;
+            alarm_list[index].trigger_time.min = next_random() % 60;
+            alarm_list[index].trigger_days = (next_random() % Everyday) + 1;
+            alarm_list[index].alarm_text = "startup alarm";
+            alarm_list[index].sound_file = (char*)SOUND_FILES[index % 4];
+            alarm_list[index].snooze_min = 5;
+        }
+
+        SCHEDULER_HANDLE scheduler;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if ((scheduler = alarm_scheduler_create()) != NULL)
+        {
+            for (size_t index = 0; index < alarm_count; index++)
+            {
+                ALARM_INFO alarm_info = alarm_list[index];
+                (void)alarm_scheduler_add_alarm_info(scheduler, &alarm_info);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            single_elapsed = get_elapsed_ns(&start, &end);
+            alarm_scheduler_destroy(scheduler);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if ((scheduler = alarm_scheduler_create()) != NULL)
+        {
+            (void)alarm_scheduler_add_alarms(scheduler, alarm_list, alarm_count);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            batch_elapsed = get_elapsed_ns(&start, &end);
+            alarm_scheduler_destroy(scheduler);
+        }
+        printf("%8zu alarms: one at a time %8.1f ns, batch %8.1f ns per alarm\r\n", alarm_count,
+            (double)single_elapsed/alarm_count, (double)batch_elapsed/alarm_count);
+        free(alarm_list);
+    }
+}
+
+// Walks every minute of the week the way the clock does on each minute
+// rollover and reports the average cost of a single trigger check
+static void run_trigger_benchmark(size_t alarm_count)
+{
+    SCHEDULER_HANDLE scheduler;
+    if ((scheduler = alarm_scheduler_create()) == NULL)
+    {
+        printf("Failure creating alarm scheduler\r\n");
+    }
+    else
+    {
+        if (load_alarms(scheduler, alarm_count) == 0)
+        {
+            size_t triggered = 0;
+            struct tm curr_time = { 0 };
+            struct timespec start, end;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int minute = 0; minute < MINUTES_IN_WEEK; minute++)
+            {
+                curr_time.tm_wday = minute / MINUTES_IN_DAY;
+                curr_time.tm_yday = curr_time.tm_wday;
+                curr_time.tm_hour = (minute % MINUTES_IN_DAY) / 60;
+                curr_time.tm_min = minute % 60;
+                if (alarm_scheduler_is_triggered(scheduler, &curr_time) != NULL)
+                {
+                    triggered++;
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            uint64_t elapsed = get_elapsed_ns(&start, &end);
+            printf("%8zu alarms: %8.1f ns per tick (%zu triggered)\r\n", alarm_count, (double)elapsed/MINUTES_IN_WEEK, triggered);
+        }
+        alarm_scheduler_destroy(scheduler);
+    }
+}
+
+// Finds the soonest of a set of alarms from every 15th minute of the week
+// with the legacy comparator and with the closed form key
+static void run_next_alarm_benchmark(size_t alarm_count)
+{
+    ALARM_INFO* alarm_list;
+    if ((alarm_list = (ALARM_INFO*)calloc(alarm_count, sizeof(ALARM_INFO))) == NULL)
+    {
+        printf("Failure allocating alarm list\r\n");
+    }
+    else
+    {
+        for (size_t index = 0; index < alarm_count; index++)
+        {
+            alarm_list[index].trigger_time.hour = next_random() % 24;
+            alarm_list[index].trigger_time.min = next_random() % 60;
+            alarm_list[index].trigger_days = (next_random() % Everyday) + 1;
+        }
+
+        size_t legacy_sum = 0;
+        size_t closed_sum = 0;
+        uint64_t legacy_elapsed = 0;
+        uint64_t closed_elapsed = 0;
+        int sample_count = 0;
+        struct timespec start, end;
+        for (int minute = 0; minute < MINUTES_IN_WEEK; minute += 15)
+        {
+            struct tm curr_time = { 0 };
+            curr_time.tm_wday = minute / MINUTES_IN_DAY;
+            curr_time.tm_hour = (minute % MINUTES_IN_DAY) / 60;
+            curr_time.tm_min = minute % 60;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            size_t legacy_next = 0;
+            for (size_t index = 1; index < alarm_count; index++)
+            {
+                if (legacy_is_alarm_initial_sooner(&alarm_list[legacy_next], &alarm_list[index], &curr_time))
+                {
+                    legacy_next = index;
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            legacy_elapsed += get_elapsed_ns(&start, &end);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            size_t closed_next = 0;
+            uint32_t next_minutes = ALARM_NO_TRIGGER;
+            for (size_t index = 0; index < alarm_count; index++)
+            {
+                uint32_t minutes = alarm_scheduler_get_minutes_till_trigger(&alarm_list[index], &curr_time);
+                if (minutes < next_minutes)
+                {
+                    next_minutes = minutes;
+                    closed_next = index;
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            closed_elapsed += get_elapsed_ns(&start, &end);
+
+            legacy_sum += legacy_next;
+            closed_sum += closed_next;
+            sample_count++;
+        }
+        printf("%8zu alarms: legacy %8.1f ns, closed form %8.1f ns per alarm (selected index sums %zu/%zu)\r\n", alarm_count,
+            (double)legacy_elapsed/((double)sample_count*alarm_count), (double)closed_elapsed/((double)sample_count*alarm_count), legacy_sum, closed_sum);
+        free(alarm_list);
+    }
+}
+
+// Forces a full next alarm recalculation by replacing one alarm per pass and
+// reports the time and cache misses of the scan scaled to 10k alarms
+static void run_next_alarm_scan_benchmark(size_t alarm_count)
+{
+    SCHEDULER_HANDLE scheduler;
+    if ((scheduler = alarm_scheduler_create()) == NULL)
+    {
+        printf("Failure creating alarm scheduler\r\n");
+    }
+    else
+    {
+        if (load_alarms(scheduler, alarm_count) == 0)
+        {
+            uint64_t elapsed = 0;
+            uint64_t misses = 0;
+            bool have_misses = false;
+            struct timespec start, end;
+#if defined(__linux__)
+            int counter = open_cache_miss_counter();
+#endif
+            for (size_t iteration = 0; iteration < SCAN_ITERATIONS; iteration++)
+            {
+                TIME_INFO time_info = { 0 };
+                time_info.hour = next_random() % 24;
+                time_info.min = next_random() % 60;
+                (void)alarm_scheduler_remove_alarm(scheduler, alarm_count-1);
+                (void)alarm_scheduler_add_alarm(scheduler, "perf alarm", &time_info, Everyday, "perf.wav", 5, NULL);
+
+                clock_gettime(CLOCK_MONOTONIC, &start);
+#if defined(__linux__)
+                uint64_t iteration_misses;
+                start_counter(counter);
+#endif
+                (void)alarm_scheduler_get_next_alarm(scheduler);
+#if defined(__linux__)
+                if (stop_counter(counter, &iteration_misses))
+                {
+                    misses += iteration_misses;
+                    have_misses = true;
+                }
+#endif
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                elapsed += get_elapsed_ns(&start, &end);
+            }
+#if defined(__linux__)
+            if (counter >= 0)
+            {
+                (void)close(counter);
+            }
+#endif
+            double scale = 10000.0/((double)alarm_count*SCAN_ITERATIONS);
+            if (have_misses)
+            {
+                printf("%8zu alarms: %8.1f ns per alarm, %10.1f cache misses per 10k alarms\r\n", alarm_count,
+                    (double)elapsed/((double)alarm_count*SCAN_ITERATIONS), (double)misses*scale);
+            }
+            else
+            {
+                printf("%8zu alarms: %8.1f ns per alarm, cache misses n/a\r\n", alarm_count,
+                    (double)elapsed/((double)alarm_count*SCAN_ITERATIONS));
+            }
+        }
+        alarm_scheduler_destroy(scheduler);
+    }
+}
+
+// Snoozes snooze_count alarms at once on top of a regular schedule, fires
+// them and reports the trigger check that expires them the next day and the
+// checks after it
+static void run_snooze_expiry_benchmark(size_t snooze_count)
+{
+    SCHEDULER_HANDLE scheduler;
+    if ((scheduler = alarm_scheduler_create()) == NULL)
+    {
+        printf("Failure creating alarm scheduler\r\n");
+    }
+    else
+    {
+        if (load_alarms(scheduler, LOAD_ALARM_COUNT/5) == 0)
+        {
+            struct tm curr_time = { 0 };
+            struct timespec start, end;
+            ALARM_INFO snooze_info = *alarm_scheduler_get_alarm(scheduler, 0);
+            snooze_info.trigger_time.hour = 6;
+            snooze_info.snooze_min = 5;
+            for (size_t index = 0; index < snooze_count; index++)
+            {
+                snooze_info.trigger_time.min = (uint8_t)(index % 50);
+                (void)alarm_scheduler_snooze_alarm(scheduler, &snooze_info);
+            }
+            const ALARM_INFO* triggered_list[64];
+            curr_time.tm_wday = 1;
+            curr_time.tm_yday = 1;
+            curr_time.tm_hour = 6;
+            for (int minute = 0; minute < MINUTES_IN_HOUR; minute++)
+            {
+                curr_time.tm_min = minute;
+                while (alarm_scheduler_get_triggered_alarms(scheduler, &curr_time, triggered_list, 64) == 64)
+                {
+                }
+            }
+
+            curr_time.tm_wday = 2;
+            curr_time.tm_yday = 2;
+            curr_time.tm_hour = 0;
+            curr_time.tm_min = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            (void)alarm_scheduler_is_triggered(scheduler, &curr_time);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            uint64_t expire_elapsed = get_elapsed_ns(&start, &end);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int minute = 1; minute < MINUTES_IN_DAY; minute++)
+            {
+                curr_time.tm_hour = minute / MINUTES_IN_HOUR;
+                curr_time.tm_min = minute % MINUTES_IN_HOUR;
+                (void)alarm_scheduler_is_triggered(scheduler, &curr_time);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            printf("%8zu snoozes: expiry tick %10.1f ns, %8.1f ns per tick after, %zu alarms left\r\n", snooze_count,
+                (double)expire_elapsed, (double)get_elapsed_ns(&start, &end)/(MINUTES_IN_DAY-1), alarm_scheduler_get_alarm_count(scheduler));
+        }
+        alarm_scheduler_destroy(scheduler);
+    }
+}
+
+int main(void)
+{
+    printf("Trigger check\r\n");
+    for (size_t index = 0; index < sizeof(ALARM_COUNTS)/sizeof(ALARM_COUNTS[0]); index++)
+    {
+        run_trigger_benchmark(ALARM_COUNTS[index]);
+    }
+    printf("Alarm load\r\n");
+    run_load_benchmark(LOAD_ALARM_COUNT);
+    printf("Startup load\r\n");
+    for (size_t index = 0; index < sizeof(ALARM_COUNTS)/sizeof(ALARM_COUNTS[0]); index++)
+    {
+        run_startup_benchmark(ALARM_COUNTS[index]);
+    }
+    printf("Next alarm search\r\n");
+    for (size_t index = 0; index < sizeof(ALARM_COUNTS)/sizeof(ALARM_COUNTS[0]); index++)
+    {
+        run_next_alarm_benchmark(ALARM_COUNTS[index]);
+    }
+    printf("Next alarm scan\r\n");
+    for (size_t index = 0; index < sizeof(ALARM_COUNTS)/sizeof(ALARM_COUNTS[0]); index++)
+    {
+        run_next_alarm_scan_benchmark(ALARM_COUNTS[index]);
+    }
+    printf("Snooze expiry\r\n");
+    for (size_t index = 0; index < sizeof(ALARM_COUNTS)/sizeof(ALARM_COUNTS[0]); index++)
+    {
+        run_snooze_expiry_benchmark(ALARM_COUNTS[index]);
+    }
+    return 0;
+}
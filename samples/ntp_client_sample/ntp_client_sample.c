@@ -1,15 +1,100 @@
-
 #include "stdio.h"
+#include "string.h"
 #include "ntp_client.h"
 
-static void ntp_timer_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result, time_t current_time)
+#ifndef WIN32
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define FAKE_SERVER_COUNT       3
+#define FAKE_SERVER_PORT        12300
+#define NTP_TIMESTAMP_DELTA     2208988800ull
+// The fake servers run this far ahead of the local clock
+#define FAKE_CLOCK_OFFSET_NS    1500000000ll
+
+typedef struct FAKE_SERVER_TAG
+{
+    pthread_t thread;
+    int socket_fd;
+    uint16_t port;
+    // How long the server sits on a request, standing in for a slow path
+    uint32_t reply_delay_ms;
+} FAKE_SERVER;
+
+static const char* FAKE_SERVER_LIST[FAKE_SERVER_COUNT] = { "127.0.0.1:12300", "127.0.0.1:12301", "127.0.0.1:12302" };
+static const uint32_t FAKE_REPLY_DELAYS[FAKE_SERVER_COUNT] = { 40, 5, 80 };
+
+static void set_ntp_timestamp(unsigned char* packet, size_t offset)
+{
+    struct timespec now;
+    uint32_t value[2];
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t server_ns = (int64_t)now.tv_sec*1000000000 + now.tv_nsec + FAKE_CLOCK_OFFSET_NS;
+    value[0] = htonl((uint32_t)(server_ns/1000000000 + NTP_TIMESTAMP_DELTA));
+    value[1] = htonl((uint32_t)(((uint64_t)(server_ns % 1000000000) << 32)/1000000000));
+    memcpy(packet + offset, value, sizeof(value));
+}
+
+// Answers a single request the way a stratum 2 server would
+static void* fake_server_thread(void* context)
+{
+    FAKE_SERVER* server = (FAKE_SERVER*)context;
+    unsigned char packet[48];
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    if (recvfrom(server->socket_fd, packet, sizeof(packet), 0, (struct sockaddr*)&client_addr, &addr_len) == (ssize_t)sizeof(packet))
+    {
+        usleep(server->reply_delay_ms*1000);
+        set_ntp_timestamp(packet, 32);
+        // Originate is the client's transmit time
+        memcpy(packet + 24, packet + 40, 8);
+        packet[0] = 0x24;
+        packet[1] = 2;
+        set_ntp_timestamp(packet, 40);
+        (void)sendto(server->socket_fd, packet, sizeof(packet), 0, (struct sockaddr*)&client_addr, addr_len);
+    }
+    return NULL;
+}
+
+static int start_fake_server(FAKE_SERVER* server)
+{
+    int result;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((server->socket_fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+    {
+        result = __LINE__;
+    }
+    else if (bind(server->socket_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        pthread_create(&server->thread, NULL, fake_server_thread, server) != 0)
+    {
+        close(server->socket_fd);
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+#endif
+
+static void ntp_offset_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result, const struct timespec* offset, const struct timespec* delay)
 {
     bool* connection_complete = (bool*)user_ctx;
 
     *connection_complete = true;
     if (ntp_result == NTP_OP_RESULT_SUCCESS)
     {
+        time_t current_time = time(NULL) + offset->tv_sec;
         printf("Time from time server: %s\r\n", ctime(&current_time));
+        printf("Clock offset %+.3f ms, round trip delay %.3f ms\r\n", offset->tv_sec*1000.0 + offset->tv_nsec/1000000.0,
+            delay->tv_sec*1000.0 + delay->tv_nsec/1000000.0);
     }
     else
     {
@@ -17,26 +102,79 @@ static void ntp_timer_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result,
     }
 }
 
-int main()
+static void query_time_servers(NTP_CLIENT_HANDLE ntp_handle, const char** server_list, size_t server_count)
+{
+    bool conn_complete = false;
+#ifndef WIN32
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+    if (ntp_client_get_offset(ntp_handle, server_list, server_count, 60, ntp_offset_callback, &conn_complete) == 0)
+    {
+        do
+        {
+            ntp_client_process(ntp_handle);
+        } while (!conn_complete);
+#ifndef WIN32
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("%zu servers answered in %.1f ms\r\n", server_count, (end.tv_sec - start.tv_sec)*1000.0 + (end.tv_nsec - start.tv_nsec)/1000000.0);
+#endif
+        printf("Next query due in %zu s\r\n", ntp_client_get_poll_interval(ntp_handle));
+    }
+}
+
+int main(int argc, char* argv[])
 {
     NTP_CLIENT_HANDLE ntp_handle;
     if ((ntp_handle = ntp_client_create()) == NULL)
     {
         printf("Failure creating ntp client\r\n");
     }
-    else
+#ifndef WIN32
+    // Local responders with known delays, the fastest one should win
+    else if (argc > 1 && strcmp(argv[1], "--fake") == 0)
     {
-        bool conn_complete = false;
-        if (ntp_client_get_time(ntp_handle, "time.nist.gov", 60, ntp_timer_callback, &conn_complete) == 0)
+        FAKE_SERVER server_list[FAKE_SERVER_COUNT];
+        size_t started = 0;
+        for (; started < FAKE_SERVER_COUNT; started++)
         {
-            do
+            server_list[started].port = (uint16_t)(FAKE_SERVER_PORT + started);
+            server_list[started].reply_delay_ms = FAKE_REPLY_DELAYS[started];
+            if (start_fake_server(&server_list[started]) != 0)
             {
-                ntp_client_process(ntp_handle);
-            } while (!conn_complete);
+                printf("Failure starting fake ntp server on port %d\r\n", server_list[started].port);
+                break;
+            }
+        }
+        if (started == FAKE_SERVER_COUNT)
+        {
+            query_time_servers(ntp_handle, FAKE_SERVER_LIST, FAKE_SERVER_COUNT);
+        }
+        for (size_t index = 0; index < started; index++)
+        {
+            // Unblocks the servers that were never asked
+            shutdown(server_list[index].socket_fd, SHUT_RDWR);
+            pthread_join(server_list[index].thread, NULL);
+            close(server_list[index].socket_fd);
+        }
+        ntp_client_destroy(ntp_handle);
+    }
+#endif
+    else
+    {
+        if (argc > 1)
+        {
+            size_t server_count = (size_t)(argc - 1) < NTP_CLIENT_MAX_SERVERS ? (size_t)(argc - 1) : NTP_CLIENT_MAX_SERVERS;
+            query_time_servers(ntp_handle, (const char**)&argv[1], server_count);
+        }
+        else
+        {
+            const char* time_server = "time.nist.gov";
+            query_time_servers(ntp_handle, &time_server, 1);
         }
         ntp_client_destroy(ntp_handle);
     }
 
     printf("Press any key to exit\r\n");
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,154 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "sample_convert.h"
+
+// About 45 seconds of 48kHz stereo, well past the last level cache
+#define SAMPLE_COUNT        (4*1024*1024)
+#define PASS_COUNT          20
+#define TEST_GAIN           0.35f
+
+typedef void (*CONVERT_PASS)(int16_t* samples, const uint8_t* bytes, int16_t* target);
+
+typedef struct CONVERT_BENCHMARK_TAG
+{
+    const char* name;
+    CONVERT_PASS pass;
+    size_t pass_bytes;
+} CONVERT_BENCHMARK;
+
+static const SAMPLE_CONVERT_IMPL IMPL_LIST[] = { SAMPLE_CONVERT_SCALAR, SAMPLE_CONVERT_SSSE3, SAMPLE_CONVERT_AVX2 };
+static const char* IMPL_NAMES[] = { "scalar", "ssse3", "avx2" };
+
+static uint32_t g_random_seed = 2463534242u;
+
+static uint32_t next_random(void)
+{
+    // xorshift keeps the run reproducible across platforms
+    g_random_seed ^= g_random_seed << 13;
+    g_random_seed ^= g_random_seed >> 17;
+    g_random_seed ^= g_random_seed << 5;
+    return g_random_seed;
+}
+
+static uint64_t get_elapsed_ns(const struct timespec* start, const struct timespec* end)
+{
+    return (uint64_t)(end->tv_sec - start->tv_sec)*1000000000ull + (uint64_t)end->tv_nsec - (uint64_t)start->tv_nsec;
+}
+
+// The pointer walking swap the sound manager used before the conversion
+// kernels, kept here as the baseline
+static void legacy_swap_pass(int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    (void)bytes;
+    (void)target;
+    short* ptr = samples;
+    size_t words = SAMPLE_COUNT;
+    while (words--)
+    {
+        *ptr = (short)(((((unsigned short)*ptr)<<8) & 0xFF00) | ((((unsigned short)*ptr)>>8) & 0x00FF));
+        ++ptr;
+    }
+}
+
+static void swap_pass(int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    (void)bytes;
+    (void)target;
+    sample_convert_swap_16(samples, SAMPLE_COUNT);
+}
+
+static void widen_pass(int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    (void)samples;
+    sample_convert_widen_8(bytes, target, SAMPLE_COUNT);
+}
+
+static void downmix_pass(int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    (void)bytes;
+    sample_convert_downmix_stereo(samples, target, SAMPLE_COUNT/2);
+}
+
+static void gain_pass(int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    (void)bytes;
+    (void)target;
+    sample_convert_apply_gain(samples, SAMPLE_COUNT, TEST_GAIN);
+}
+
+static const CONVERT_BENCHMARK BENCHMARK_LIST[] =
+{
+    { "endian swap", swap_pass, SAMPLE_COUNT*sizeof(int16_t) },
+    { "8 to 16 bit", widen_pass, SAMPLE_COUNT },
+    { "downmix", downmix_pass, SAMPLE_COUNT*sizeof(int16_t) },
+    { "gain", gain_pass, SAMPLE_COUNT*sizeof(int16_t) }
+};
+
+static double run_pass(CONVERT_PASS pass, size_t pass_bytes, int16_t* samples, const uint8_t* bytes, int16_t* target)
+{
+    struct timespec start, end;
+    // One warm up pass so page faults are not part of the timing
+    pass(samples, bytes, target);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t index = 0; index < PASS_COUNT; index++)
+    {
+        pass(samples, bytes, target);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    // Input bytes per microsecond is MB/s
+    return (double)pass_bytes*PASS_COUNT*1000.0/get_elapsed_ns(&start, &end);
+}
+
+int main(void)
+{
+    int16_t* samples = (int16_t*)malloc(SAMPLE_COUNT*sizeof(int16_t));
+    int16_t* target = (int16_t*)malloc(SAMPLE_COUNT*sizeof(int16_t));
+    uint8_t* bytes = (uint8_t*)malloc(SAMPLE_COUNT);
+    if (samples == NULL || target == NULL || bytes == NULL)
+    {
+        printf("Failure allocating sample buffers\r\n");
+    }
+    else
+    {
+        for (size_t index = 0; index < SAMPLE_COUNT; index++)
+        {
+            uint32_t value = next_random();
+            samples[index] = (int16_t)value;
+            bytes[index] = (uint8_t)(value >> 16);
+        }
+
+        printf("%zu samples, %d passes\r\n", (size_t)SAMPLE_COUNT, PASS_COUNT);
+        double legacy_rate = run_pass(legacy_swap_pass, SAMPLE_COUNT*sizeof(int16_t), samples, bytes, target);
+        printf("%-12s %-8s %10.1f MB/s\r\n", "endian swap", "legacy", legacy_rate);
+        for (size_t bench = 0; bench < sizeof(BENCHMARK_LIST)/sizeof(BENCHMARK_LIST[0]); bench++)
+        {
+            double scalar_rate = 0;
+            for (size_t impl = 0; impl < sizeof(IMPL_LIST)/sizeof(IMPL_LIST[0]); impl++)
+            {
+                if (sample_convert_set_impl(IMPL_LIST[impl]) != 0)
+                {
+                    printf("%-12s %-8s not supported\r\n", BENCHMARK_LIST[bench].name, IMPL_NAMES[impl]);
+                }
+                else
+                {
+                    double rate = run_pass(BENCHMARK_LIST[bench].pass, BENCHMARK_LIST[bench].pass_bytes, samples, bytes, target);
+                    if (IMPL_LIST[impl] == SAMPLE_CONVERT_SCALAR)
+                    {
+                        scalar_rate = rate;
+                    }
+                    printf("%-12s %-8s %10.1f MB/s, %5.2fx scalar\r\n", BENCHMARK_LIST[bench].name, IMPL_NAMES[impl], rate, rate/scalar_rate);
+                }
+            }
+        }
+    }
+    free(samples);
+    free(target);
+    free(bytes);
+    return 0;
+}
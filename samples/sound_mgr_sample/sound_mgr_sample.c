@@ -13,11 +13,13 @@ int main()
     {
         float volume = 0.1;
 
-        sound_mgr_play(handle, ALARM_AUDIO_FILENAME, true, false);
+        // Ramp up over the first 5 seconds
+        sound_mgr_set_crescendo(handle, SOUND_CRESCENDO_LOUDNESS, 5000);
+        sound_mgr_play(handle, ALARM_AUDIO_FILENAME, true, true);
         do
         {
             volume = sound_mgr_get_volume(handle);
-            if (volume == 1.0)
+            if (volume >= 0.95f)
             {
                 volume = 0.0;
             }
@@ -25,10 +27,15 @@ int main()
             {
                 volume += 0.1;
             }
-            //sound_mgr_set_volume(handle, volume);
+            sound_mgr_set_volume(handle, volume);
             printf("Setting the Volume to %f", volume);
 
-            thread_mgr_sleep(5*1000);
+            // Long files are streamed, keep them fed while waiting
+            for (size_t index = 0; index < 50; index++)
+            {
+                sound_mgr_process(handle);
+                thread_mgr_sleep(100);
+            }
 
             /*printf("Press enter to play again.  Press q to stop\n");
             int input = getchar();
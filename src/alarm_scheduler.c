@@ -3,19 +3,41 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
 
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define USE_SIMD_NEXT_ALARM_SCAN
+#include <immintrin.h>
+#endif
+
 #include "lib-util-c/sys_debug_shim.h"
 #include "lib-util-c/app_logging.h"
-#include "lib-util-c/item_list.h"
-#include "lib-util-c/crt_extensions.h"
 #include "alarm_scheduler.h"
 #include "time_mgr.h"
 
 #define INVALID_TRIGGERED_DATE      400
 #define SNOOZE_ID                   10
+#define ALARM_ID_TABLE_SIZE         (UINT8_MAX+1)
+#define INITIAL_STORE_CAPACITY      8
+#define DAYS_IN_WEEK                7
+#define MINUTES_IN_HOUR             60
+#define MINUTES_IN_DAY              (24*MINUTES_IN_HOUR)
+#define MINUTES_IN_WEEK             (DAYS_IN_WEEK*MINUTES_IN_DAY)
+#define ITEM_CHUNK_MIN_COUNT        16
+#define ITEM_CHUNK_MAX_COUNT        4096
+#define STRING_BLOCK_SIZE           4096
+#define STRING_TABLE_MIN_SIZE       64
+#define SCAN_NO_TRIGGER             INT32_MAX
+#define DAYS_IN_LEAP_YEAR           366
+#define HEAP_NOT_QUEUED             SIZE_MAX
+#define SECONDS_IN_MINUTE           60
+// Alarms detected later than this after their fire instant are skipped,
+// the same window the wall clock check gives late alarms
+#define MISSED_ALARM_WINDOW         (MINUTES_IN_HOUR*SECONDS_IN_MINUTE)
 
 typedef enum ALARM_TYPE_TAG
 {
@@ -25,29 +47,316 @@ typedef enum ALARM_TYPE_TAG
     ALARM_TYPE_ONE_TIME
 } ALARM_TYPE;
 
+// Links an alarm into the trigger wheel bucket for one of its days
+typedef struct WHEEL_NODE_TAG
+{
+    struct WHEEL_NODE_TAG* next;
+    struct WHEEL_NODE_TAG** prev_link;
+} WHEEL_NODE;
+
+typedef struct WHEEL_BUCKET_TAG
+{
+    WHEEL_NODE* head;
+    // Link to append the next node at, NULL while the bucket is empty
+    WHEEL_NODE** tail_link;
+} WHEEL_BUCKET;
+
+typedef enum ALARM_HEAP_ID_TAG
+{
+    // Fired snooze and one time alarms keyed by the day they expire on
+    ALARM_HEAP_EXPIRY,
+    // Scheduled alarms keyed by their next absolute fire instant
+    ALARM_HEAP_FIRE,
+    ALARM_HEAP_COUNT
+} ALARM_HEAP_ID;
+
+typedef struct ALARM_HEAP_TAG
+{
+    struct ALARM_STORAGE_ITEM_TAG** entries;
+    size_t count;
+} ALARM_HEAP;
+
 typedef struct ALARM_STORAGE_ITEM_TAG
 {
     ALARM_TYPE type;
     ALARM_INFO alarm_info;
-    uint16_t triggered_date;
+    // Position of the item in the alarm_slots array
+    size_t slot;
+    // Key and position of the item in each of the scheduler heaps
+    int64_t heap_key[ALARM_HEAP_COUNT];
+    size_t heap_pos[ALARM_HEAP_COUNT];
+    // Instant the alarm was last returned as due for
+    time_t fired_instant;
+    // A fired snooze or one time alarm the caller still holds, its expiry
+    // day waits in heap_key until it is released
+    bool is_held;
+    // Links the item into the unscheduled list until it has a fire instant
+    WHEEL_NODE schedule_node;
+    // Snooze alarms share an id, so the id table chains the duplicates.
+    // Links the free list while the item is in the pool.
+    struct ALARM_STORAGE_ITEM_TAG* next_same_id;
+    struct ALARM_STORAGE_ITEM_TAG** prev_same_id_link;
+    // Indexed by tm_wday, only the days in trigger_days are linked
+    WHEEL_NODE wheel_nodes[DAYS_IN_WEEK];
 } ALARM_STORAGE_ITEM;
 
+// Storage items are carved out of chunks that are only released when the
+// scheduler is destroyed, so item addresses stay stable
+typedef struct ITEM_CHUNK_TAG
+{
+    struct ITEM_CHUNK_TAG* next;
+    ALARM_STORAGE_ITEM items[];
+} ITEM_CHUNK;
+
+// Alarm text and sound files are interned into blocks owned by the
+// scheduler, most alarms share the same few sound files
+typedef struct STRING_BLOCK_TAG
+{
+    struct STRING_BLOCK_TAG* next;
+    size_t used;
+    size_t size;
+    char data[];
+} STRING_BLOCK;
+
 typedef struct ALARM_SCHEDULER_TAG
 {
-    ITEM_LIST_HANDLE sched_list;
+    // Alarms in the order they were added.  The fields checked on every
+    // scan are kept in packed arrays indexed by slot, apart from the rest
+    // of the alarm.  All the arrays share the alarm_slots allocation.
+    ALARM_STORAGE_ITEM** alarm_slots;
+    ALARM_HEAP heaps[ALARM_HEAP_COUNT];
+    uint16_t* slot_trigger_minute;
+    uint16_t* slot_fired_day;
+    uint8_t* slot_day_mask;
+    size_t alarm_count;
+    size_t slot_capacity;
+
+    ALARM_STORAGE_ITEM* id_table[ALARM_ID_TABLE_SIZE];
+    ALARM_STORAGE_ITEM** id_tail_links[ALARM_ID_TABLE_SIZE];
+
+    ITEM_CHUNK* item_chunks;
+    ALARM_STORAGE_ITEM* free_items;
+    size_t free_item_count;
+    size_t next_chunk_count;
+
+    // Open addressed hash set of the interned strings
+    const char** string_table;
+    size_t string_table_size;
+    size_t string_count;
+    STRING_BLOCK* string_blocks;
+
+    // One bucket per minute of the week holding the alarms that fire then
+    WHEEL_BUCKET* trigger_wheel;
+
+    // Absolute schedule, alarms wait here until the next tick gives them a
+    // fire instant.  The local day is only recomputed once it rolls over.
+    WHEEL_BUCKET unscheduled_alarms;
+    time_t next_day_start;
+    uint32_t current_day;
+    bool timezone_changed;
+
+    // Cached result of alarm_scheduler_get_next_alarm, recomputed when the
+    // alarms change or the cached alarm fires
+    const ALARM_INFO* next_alarm;
+    time_t next_alarm_time;
+    time_t next_alarm_calc_time;
+    bool next_alarm_valid;
+    uint32_t next_alarm_generation;
+
     uint8_t alarm_next_id;
 } ALARM_SCHEDULER;
 
-static void destroy_schedule_list_cb(void* user_ctx, void* item)
+static int add_item_chunk(ALARM_SCHEDULER* scheduler, size_t item_count)
+{
+    int result;
+    ITEM_CHUNK* chunk;
+    if ((chunk = (ITEM_CHUNK*)malloc(sizeof(ITEM_CHUNK) + item_count*sizeof(ALARM_STORAGE_ITEM))) == NULL)
+    {
+        log_error("Failure allocating alarm item chunk");
+        result = __LINE__;
+    }
+    else
+    {
+        chunk->next = scheduler->item_chunks;
+        scheduler->item_chunks = chunk;
+        for (size_t index = item_count; index > 0; index--)
+        {
+            chunk->items[index-1].next_same_id = scheduler->free_items;
+            scheduler->free_items = &chunk->items[index-1];
+        }
+        scheduler->free_item_count += item_count;
+        result = 0;
+    }
+    return result;
+}
+
+static int reserve_storage_items(ALARM_SCHEDULER* scheduler, size_t needed)
+{
+    int result;
+    if (needed <= scheduler->free_item_count)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t item_count = needed - scheduler->free_item_count;
+        if (item_count < scheduler->next_chunk_count)
+        {
+            item_count = scheduler->next_chunk_count;
+        }
+        if (add_item_chunk(scheduler, item_count) != 0)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            if (scheduler->next_chunk_count < ITEM_CHUNK_MAX_COUNT)
+            {
+                scheduler->next_chunk_count *= 2;
+            }
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static ALARM_STORAGE_ITEM* allocate_storage_item(ALARM_SCHEDULER* scheduler)
+{
+    ALARM_STORAGE_ITEM* result;
+    if (reserve_storage_items(scheduler, 1) != 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = scheduler->free_items;
+        scheduler->free_items = result->next_same_id;
+        scheduler->free_item_count--;
+        memset(result, 0, sizeof(ALARM_STORAGE_ITEM));
+    }
+    return result;
+}
+
+static void release_storage_item(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item)
+{
+    storage_item->next_same_id = scheduler->free_items;
+    scheduler->free_items = storage_item;
+    scheduler->free_item_count++;
+}
+
+static size_t get_string_hash(const char* value)
+{
+    // FNV-1a
+    uint32_t result = 2166136261u;
+    for (; *value != '\0'; value++)
+    {
+        result ^= (uint8_t)*value;
+        result *= 16777619u;
+    }
+    return result;
+}
+
+static const char** find_string_entry(const char** string_table, size_t table_size, const char* value)
+{
+    size_t index = get_string_hash(value) & (table_size - 1);
+    while (string_table[index] != NULL && strcmp(string_table[index], value) != 0)
+    {
+        index = (index + 1) & (table_size - 1);
+    }
+    return &string_table[index];
+}
+
+static int grow_string_table(ALARM_SCHEDULER* scheduler)
+{
+    int result;
+    size_t new_size = scheduler->string_table_size == 0 ? STRING_TABLE_MIN_SIZE : scheduler->string_table_size*2;
+    const char** new_table;
+    if ((new_table = (const char**)malloc(new_size*sizeof(const char*))) == NULL)
+    {
+        log_error("Failure allocating string table");
+        result = __LINE__;
+    }
+    else
+    {
+        memset(new_table, 0, new_size*sizeof(const char*));
+        if (scheduler->string_table != NULL)
+        {
+            for (size_t index = 0; index < scheduler->string_table_size; index++)
+            {
+                if (scheduler->string_table[index] != NULL)
+                {
+                    *find_string_entry(new_table, new_size, scheduler->string_table[index]) = scheduler->string_table[index];
+                }
+            }
+            free(scheduler->string_table);
+        }
+        scheduler->string_table = new_table;
+        scheduler->string_table_size = new_size;
+        result = 0;
+    }
+    return result;
+}
+
+static char* copy_to_string_block(ALARM_SCHEDULER* scheduler, const char* value)
+{
+    char* result;
+    size_t length = strlen(value) + 1;
+    STRING_BLOCK* block = scheduler->string_blocks;
+    if (block == NULL || block->size - block->used < length)
+    {
+        size_t block_size = length > STRING_BLOCK_SIZE ? length : STRING_BLOCK_SIZE;
+        if ((block = (STRING_BLOCK*)malloc(sizeof(STRING_BLOCK) + block_size)) != NULL)
+        {
+            block->size = block_size;
+            block->used = 0;
+            block->next = scheduler->string_blocks;
+            scheduler->string_blocks = block;
+        }
+    }
+    if (block == NULL)
+    {
+        log_error("Failure allocating string block");
+        result = NULL;
+    }
+    else
+    {
+        result = block->data + block->used;
+        memcpy(result, value, length);
+        block->used += length;
+    }
+    return result;
+}
+
+static int intern_string(ALARM_SCHEDULER* scheduler, char** target, const char* value)
 {
-    ALARM_SCHEDULER* alarm_sched = (ALARM_SCHEDULER*)user_ctx;
-    if (alarm_sched != NULL)
+    int result;
+    // Keep the table at most half full so probes stay short
+    if ((scheduler->string_count + 1)*2 > scheduler->string_table_size && grow_string_table(scheduler) != 0)
     {
-        ALARM_STORAGE_ITEM* alarm_info = (ALARM_STORAGE_ITEM*)item;
-        free(alarm_info->alarm_info.sound_file);
-        free(alarm_info->alarm_info.alarm_text);
-        free(alarm_info);
+        result = __LINE__;
+    }
+    else
+    {
+        const char** entry = find_string_entry(scheduler->string_table, scheduler->string_table_size, value);
+        if (*entry == NULL)
+        {
+            *entry = copy_to_string_block(scheduler, value);
+            if (*entry != NULL)
+            {
+                scheduler->string_count++;
+            }
+        }
+        if (*entry == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            *target = (char*)*entry;
+            result = 0;
+        }
     }
+    return result;
 }
 
 static uint16_t get_current_day_from_value(int wday)
@@ -83,181 +392,651 @@ static uint16_t get_current_day_from_value(int wday)
     return result;
 }
 
-static uint16_t get_current_day(const struct tm* curr_time)
+static uint32_t count_trailing_zeros(uint32_t value)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(value);
+#else
+    uint32_t result = 0;
+    while ((value & 0x1) == 0)
+    {
+        value >>= 1;
+        result++;
+    }
+    return result;
+#endif
+}
+
+// Moves Sunday from the top bit to bit 0 so bit n is tm_wday n
+static uint8_t get_wday_mask(uint32_t trigger_days)
 {
-    return get_current_day_from_value(curr_time->tm_wday);
+    uint32_t day_mask = trigger_days & Everyday;
+    return (uint8_t)(((day_mask << 1) | (day_mask >> (DAYS_IN_WEEK-1))) & Everyday);
 }
 
-static int get_next_trigger_day(const struct tm* current_tm, uint32_t trigger_day, const TIME_INFO* trigger_time)
+static uint16_t get_day_minute(const TIME_INFO* trigger_time)
 {
-    int result;
-    result = 7;
-    int target_day = current_tm->tm_wday;
-    for (uint16_t index = 0; index < 7; index++)
+    return (uint16_t)(trigger_time->hour*MINUTES_IN_HOUR + trigger_time->min);
+}
+
+// Minutes from the current minute of the week until the alarm next fires.
+// An alarm firing at the current minute is a full week away.
+static uint32_t get_minutes_till_trigger(uint32_t day_mask, uint32_t trigger_minute, uint32_t wday, uint32_t day_minute)
+{
+    uint32_t result;
+    if (day_mask == 0)
     {
-        uint16_t compare_value = get_current_day_from_value(target_day);
-        if (compare_value & trigger_day)
+        result = ALARM_NO_TRIGGER;
+    }
+    else
+    {
+        // Today only counts if the alarm time is still ahead
+        uint32_t start_day = trigger_minute <= day_minute;
+        // Doubling the mask turns the shift into a rotate by the current day
+        uint32_t rotated_mask = (day_mask | (day_mask << DAYS_IN_WEEK)) >> (wday + start_day);
+        uint32_t days_ahead = start_day + count_trailing_zeros(rotated_mask);
+        result = days_ahead*MINUTES_IN_DAY + trigger_minute - day_minute;
+    }
+    return result;
+}
+
+typedef struct NEXT_ALARM_SCAN_TAG
+{
+    uint32_t minutes;
+    size_t slot;
+} NEXT_ALARM_SCAN;
+
+static void scan_next_alarm_scalar(const ALARM_SCHEDULER* scheduler, size_t index, uint32_t wday, uint32_t day_minute, NEXT_ALARM_SCAN* scan)
+{
+    // Ties go to the alarm added first
+    for (; index < scheduler->alarm_count; index++)
+    {
+        uint32_t minutes = get_minutes_till_trigger(scheduler->slot_day_mask[index], scheduler->slot_trigger_minute[index], wday, day_minute);
+        if (minutes < scan->minutes)
         {
-            if (target_day == current_tm->tm_wday)
-            {
-                // If the current hour is greater than the trigger hour
-                // then it's too late
-                if (trigger_time->hour > current_tm->tm_hour)
-                {
-                    result = target_day;
-                    break;
-                }
-                else if ((trigger_time->hour == current_tm->tm_hour) && (trigger_time->min > current_tm->tm_min))
-                {
-                    result = target_day;
-                    break;
-                }
-            }
-            else
+            scan->minutes = minutes;
+            scan->slot = index;
+        }
+    }
+}
+
+#if defined(USE_SIMD_NEXT_ALARM_SCAN)
+// Folds the per lane results of the vector scan into scan, lanes left at
+// SCAN_NO_TRIGGER never fire.  Each lane already holds its earliest slot.
+static void reduce_scan_lanes(const int32_t* lane_minutes, const int32_t* lane_slots, size_t lane_count, NEXT_ALARM_SCAN* scan)
+{
+    for (size_t lane = 0; lane < lane_count; lane++)
+    {
+        if (lane_minutes[lane] != SCAN_NO_TRIGGER)
+        {
+            uint32_t minutes = (uint32_t)lane_minutes[lane];
+            size_t slot = (size_t)lane_slots[lane];
+            if (minutes < scan->minutes || (minutes == scan->minutes && slot < scan->slot))
             {
-                result = target_day;
-                break;
+                scan->minutes = minutes;
+                scan->slot = slot;
             }
         }
-        if (target_day == 6)
+    }
+}
+
+// get_minutes_till_trigger for 4 alarms at a time.  Clearing bit 0 of the
+// rotated mask when today has passed stands in for the start_day shift and
+// the float exponent of the lowest set bit gives the days ahead.
+static __m128i get_minutes_till_trigger_sse2(__m128i day_mask, __m128i trigger_minute, __m128i wday, __m128i day_minute)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i ahead_today = _mm_cmpgt_epi32(trigger_minute, day_minute);
+    __m128i rotated_mask = _mm_srl_epi32(_mm_or_si128(day_mask, _mm_slli_epi32(day_mask, DAYS_IN_WEEK)), wday);
+    rotated_mask = _mm_andnot_si128(_mm_andnot_si128(ahead_today, one), rotated_mask);
+    __m128i lowest_day = _mm_and_si128(rotated_mask, _mm_sub_epi32(_mm_setzero_si128(), rotated_mask));
+    __m128i days_ahead = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(lowest_day)), 23), _mm_set1_epi32(127));
+    // days_ahead*MINUTES_IN_DAY without SSE4.1's 32 bit multiply
+    __m128i result = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(days_ahead, 10), _mm_slli_epi32(days_ahead, 8)),
+        _mm_add_epi32(_mm_slli_epi32(days_ahead, 7), _mm_slli_epi32(days_ahead, 5)));
+    result = _mm_add_epi32(result, _mm_sub_epi32(trigger_minute, day_minute));
+    __m128i no_days = _mm_cmpeq_epi32(day_mask, _mm_setzero_si128());
+    return _mm_or_si128(_mm_andnot_si128(no_days, result), _mm_and_si128(no_days, _mm_set1_epi32(SCAN_NO_TRIGGER)));
+}
+
+static size_t scan_next_alarm_sse2(const ALARM_SCHEDULER* scheduler, uint32_t wday, uint32_t day_minute, NEXT_ALARM_SCAN* scan)
+{
+    size_t index = 0;
+    __m128i wday_count = _mm_cvtsi32_si128((int)wday);
+    __m128i day_minute_vec = _mm_set1_epi32((int)day_minute);
+    __m128i best_minutes = _mm_set1_epi32(SCAN_NO_TRIGGER);
+    __m128i best_slots = _mm_setzero_si128();
+    __m128i slots = _mm_set_epi32(3, 2, 1, 0);
+    for (; index + 4 <= scheduler->alarm_count && index + 4 <= INT32_MAX; index += 4)
+    {
+        int32_t packed_mask;
+        memcpy(&packed_mask, &scheduler->slot_day_mask[index], sizeof(packed_mask));
+        __m128i day_mask = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed_mask), _mm_setzero_si128()), _mm_setzero_si128());
+        __m128i trigger_minute = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)&scheduler->slot_trigger_minute[index]), _mm_setzero_si128());
+        __m128i minutes = get_minutes_till_trigger_sse2(day_mask, trigger_minute, wday_count, day_minute_vec);
+        __m128i sooner = _mm_cmplt_epi32(minutes, best_minutes);
+        best_minutes = _mm_or_si128(_mm_and_si128(sooner, minutes), _mm_andnot_si128(sooner, best_minutes));
+        best_slots = _mm_or_si128(_mm_and_si128(sooner, slots), _mm_andnot_si128(sooner, best_slots));
+        slots = _mm_add_epi32(slots, _mm_set1_epi32(4));
+    }
+    int32_t lane_minutes[4];
+    int32_t lane_slots[4];
+    _mm_storeu_si128((__m128i*)lane_minutes, best_minutes);
+    _mm_storeu_si128((__m128i*)lane_slots, best_slots);
+    reduce_scan_lanes(lane_minutes, lane_slots, 4, scan);
+    return index;
+}
+
+__attribute__((target("avx2"))) static size_t scan_next_alarm_avx2(const ALARM_SCHEDULER* scheduler, uint32_t wday, uint32_t day_minute, NEXT_ALARM_SCAN* scan)
+{
+    size_t index = 0;
+    const __m256i one = _mm256_set1_epi32(1);
+    __m128i wday_count = _mm_cvtsi32_si128((int)wday);
+    __m256i day_minute_vec = _mm256_set1_epi32((int)day_minute);
+    __m256i best_minutes = _mm256_set1_epi32(SCAN_NO_TRIGGER);
+    __m256i best_slots = _mm256_setzero_si256();
+    __m256i slots = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (; index + 8 <= scheduler->alarm_count && index + 8 <= INT32_MAX; index += 8)
+    {
+        __m256i day_mask = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&scheduler->slot_day_mask[index]));
+        __m256i trigger_minute = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)&scheduler->slot_trigger_minute[index]));
+        // Same steps as get_minutes_till_trigger_sse2 on 8 alarms
+        __m256i ahead_today = _mm256_cmpgt_epi32(trigger_minute, day_minute_vec);
+        __m256i rotated_mask = _mm256_srl_epi32(_mm256_or_si256(day_mask, _mm256_slli_epi32(day_mask, DAYS_IN_WEEK)), wday_count);
+        rotated_mask = _mm256_andnot_si256(_mm256_andnot_si256(ahead_today, one), rotated_mask);
+        __m256i lowest_day = _mm256_and_si256(rotated_mask, _mm256_sub_epi32(_mm256_setzero_si256(), rotated_mask));
+        __m256i days_ahead = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(lowest_day)), 23), _mm256_set1_epi32(127));
+        __m256i minutes = _mm256_add_epi32(_mm256_mullo_epi32(days_ahead, _mm256_set1_epi32(MINUTES_IN_DAY)), _mm256_sub_epi32(trigger_minute, day_minute_vec));
+        minutes = _mm256_blendv_epi8(minutes, _mm256_set1_epi32(SCAN_NO_TRIGGER), _mm256_cmpeq_epi32(day_mask, _mm256_setzero_si256()));
+        __m256i sooner = _mm256_cmpgt_epi32(best_minutes, minutes);
+        best_minutes = _mm256_blendv_epi8(best_minutes, minutes, sooner);
+        best_slots = _mm256_blendv_epi8(best_slots, slots, sooner);
+        slots = _mm256_add_epi32(slots, _mm256_set1_epi32(8));
+    }
+    int32_t lane_minutes[8];
+    int32_t lane_slots[8];
+    _mm256_storeu_si256((__m256i*)lane_minutes, best_minutes);
+    _mm256_storeu_si256((__m256i*)lane_slots, best_slots);
+    reduce_scan_lanes(lane_minutes, lane_slots, 8, scan);
+    return index;
+}
+#endif
+
+// Finds the slot of the alarm that fires soonest, the vector kernels cover
+// whole blocks of the hot arrays and the scalar loop picks up the rest
+static NEXT_ALARM_SCAN scan_next_alarm(const ALARM_SCHEDULER* scheduler, uint32_t wday, uint32_t day_minute)
+{
+    NEXT_ALARM_SCAN result = { ALARM_NO_TRIGGER, 0 };
+    size_t index = 0;
+#if defined(USE_SIMD_NEXT_ALARM_SCAN)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        index = scan_next_alarm_avx2(scheduler, wday, day_minute, &result);
+    }
+    else
+    {
+        index = scan_next_alarm_sse2(scheduler, wday, day_minute, &result);
+    }
+#endif
+    scan_next_alarm_scalar(scheduler, index, wday, day_minute, &result);
+    return result;
+}
+
+static int get_next_trigger_day(const struct tm* current_tm, uint32_t trigger_day, const TIME_INFO* trigger_time)
+{
+    int result;
+    uint32_t day_minute = current_tm->tm_hour*MINUTES_IN_HOUR + current_tm->tm_min;
+    uint32_t minutes = get_minutes_till_trigger(get_wday_mask(trigger_day), get_day_minute(trigger_time), current_tm->tm_wday, day_minute);
+    uint32_t days_ahead = (minutes + day_minute) / MINUTES_IN_DAY;
+    // The same day next week is reported as no day
+    if (minutes == ALARM_NO_TRIGGER || days_ahead >= DAYS_IN_WEEK)
+    {
+        result = DAYS_IN_WEEK;
+    }
+    else
+    {
+        result = (current_tm->tm_wday + days_ahead) % DAYS_IN_WEEK;
+    }
+    return result;
+}
+
+static void calculate_snooze_time(const TIME_INFO* time_info, uint8_t snooze_min, TIME_INFO* snooze)
+{
+    snooze->sec = 0;
+    if ((time_info->min + snooze_min) > 59)
+    {
+        snooze->min = 60 - (time_info->min - snooze_min);
+        if (time_info->hour + 1 > 23)
         {
-            target_day = 0;
+            snooze->hour = 00;
         }
         else
         {
-            target_day++;
+            snooze->hour = time_info->hour + 1;
         }
     }
-    return result;
+    else
+    {
+        snooze->min = time_info->min + snooze_min;
+        snooze->hour = time_info->hour;
+    }
+}
+
+static uint16_t get_week_minute(int wday, int hour, int min)
+{
+    return (uint16_t)(wday*MINUTES_IN_DAY + hour*MINUTES_IN_HOUR + min);
 }
 
-static int get_days_till_trigger(const ALARM_INFO* alarm_1, const struct tm* curr_time)
+static int resize_slot_table(ALARM_SCHEDULER* scheduler, size_t new_capacity)
 {
-    int result = 0;
-    int target_day = curr_time->tm_wday;
-    do
+    int result;
+    ALARM_STORAGE_ITEM** new_slots;
+    // The heaps never hold more than every alarm, so they share the capacity
+    if ((new_slots = (ALARM_STORAGE_ITEM**)malloc(new_capacity*((1+ALARM_HEAP_COUNT)*sizeof(ALARM_STORAGE_ITEM*) + 2*sizeof(uint16_t) + sizeof(uint8_t)))) == NULL)
+    {
+        log_error("Failure allocating alarm slots");
+        result = __LINE__;
+    }
+    else
     {
-        uint16_t compare_value = get_current_day_from_value(target_day);
-        if (compare_value & alarm_1->trigger_days)
+        ALARM_STORAGE_ITEM** new_heap_entries = new_slots + new_capacity;
+        uint16_t* new_trigger_minute = (uint16_t*)(new_heap_entries + ALARM_HEAP_COUNT*new_capacity);
+        uint16_t* new_fired_day = new_trigger_minute + new_capacity;
+        uint8_t* new_day_mask = (uint8_t*)(new_fired_day + new_capacity);
+        if (scheduler->alarm_slots != NULL)
         {
-            if (result >= 7)
+            memcpy(new_slots, scheduler->alarm_slots, scheduler->alarm_count*sizeof(ALARM_STORAGE_ITEM*));
+            for (size_t heap_id = 0; heap_id < ALARM_HEAP_COUNT; heap_id++)
             {
-                break;
-            }
-            else
-            {
-                if (target_day == curr_time->tm_wday)
-                {
-                    if (alarm_1->trigger_time.hour == curr_time->tm_hour)
-                    {
-                        if (alarm_1->trigger_time.min > curr_time->tm_min)
-                        {
-                            break;
-                        }
-                    }
-                    // If the current hour is greater than the trigger hour
-                    // then it's too late
-                    else if (alarm_1->trigger_time.hour > curr_time->tm_hour)
-                    {
-                        break;
-                    }
-                }
-                else
-                {
-                    break;
-                }
+                memcpy(&new_heap_entries[heap_id*new_capacity], scheduler->heaps[heap_id].entries, scheduler->heaps[heap_id].count*sizeof(ALARM_STORAGE_ITEM*));
             }
+            memcpy(new_trigger_minute, scheduler->slot_trigger_minute, scheduler->alarm_count*sizeof(uint16_t));
+            memcpy(new_fired_day, scheduler->slot_fired_day, scheduler->alarm_count*sizeof(uint16_t));
+            memcpy(new_day_mask, scheduler->slot_day_mask, scheduler->alarm_count*sizeof(uint8_t));
+            free(scheduler->alarm_slots);
         }
-        target_day = target_day == 6 ? 0 : target_day+1;
-        result++;
-    } while (true);
+        scheduler->alarm_slots = new_slots;
+        for (size_t heap_id = 0; heap_id < ALARM_HEAP_COUNT; heap_id++)
+        {
+            scheduler->heaps[heap_id].entries = &new_heap_entries[heap_id*new_capacity];
+        }
+        scheduler->slot_trigger_minute = new_trigger_minute;
+        scheduler->slot_fired_day = new_fired_day;
+        scheduler->slot_day_mask = new_day_mask;
+        scheduler->slot_capacity = new_capacity;
+        result = 0;
+    }
     return result;
 }
 
-static bool is_alarm_initial_sooner(const ALARM_INFO* ai_initial, const ALARM_INFO* ai_compare, const struct tm* curr_time)
+static int ensure_slot_capacity(ALARM_SCHEDULER* scheduler, size_t needed)
 {
-    bool result;
-    // Convert all time to the number of days till the alarm
-    int init_val_delta = get_days_till_trigger(ai_initial, curr_time);
-    int cmp_val_delta = get_days_till_trigger(ai_compare, curr_time);
-    if (init_val_delta < cmp_val_delta)
+    int result;
+    if (scheduler->alarm_count + needed <= scheduler->slot_capacity)
     {
-        result = false;
+        result = 0;
     }
-    else if (cmp_val_delta < init_val_delta)
+    else
+    {
+        size_t new_capacity = scheduler->slot_capacity*2;
+        while (new_capacity < scheduler->alarm_count + needed)
+        {
+            new_capacity *= 2;
+        }
+        result = resize_slot_table(scheduler, new_capacity);
+    }
+    return result;
+}
+
+// Appends so the oldest alarm in a bucket is found first
+static void append_wheel_node(WHEEL_BUCKET* bucket, WHEEL_NODE* node)
+{
+    WHEEL_NODE** link = bucket->tail_link == NULL ? &bucket->head : bucket->tail_link;
+    node->next = NULL;
+    node->prev_link = link;
+    *link = node;
+    bucket->tail_link = &node->next;
+}
+
+static void remove_wheel_node(WHEEL_BUCKET* bucket, WHEEL_NODE* node)
+{
+    *node->prev_link = node->next;
+    if (node->next != NULL)
     {
-        result = true;
+        node->next->prev_link = node->prev_link;
     }
     else
     {
-        // The days are equal, need to evaluate the hours
-        if (ai_initial->trigger_time.hour == ai_compare->trigger_time.hour)
+        bucket->tail_link = bucket->head == NULL ? NULL : node->prev_link;
+    }
+    node->prev_link = NULL;
+    node->next = NULL;
+}
+
+static void index_alarm(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item)
+{
+    const ALARM_INFO* alarm_info = &storage_item->alarm_info;
+    for (int wday = 0; wday < DAYS_IN_WEEK; wday++)
+    {
+        if (alarm_info->trigger_days & get_current_day_from_value(wday))
+        {
+            append_wheel_node(&scheduler->trigger_wheel[get_week_minute(wday, alarm_info->trigger_time.hour, alarm_info->trigger_time.min)], &storage_item->wheel_nodes[wday]);
+        }
+    }
+}
+
+static void unindex_alarm(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item)
+{
+    const ALARM_INFO* alarm_info = &storage_item->alarm_info;
+    for (int wday = 0; wday < DAYS_IN_WEEK; wday++)
+    {
+        WHEEL_NODE* node = &storage_item->wheel_nodes[wday];
+        if (node->prev_link != NULL)
+        {
+            remove_wheel_node(&scheduler->trigger_wheel[get_week_minute(wday, alarm_info->trigger_time.hour, alarm_info->trigger_time.min)], node);
+        }
+    }
+}
+
+static void link_alarm_id(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item)
+{
+    uint8_t alarm_id = storage_item->alarm_info.alarm_id;
+    ALARM_STORAGE_ITEM** link = scheduler->id_tail_links[alarm_id] == NULL ? &scheduler->id_table[alarm_id] : scheduler->id_tail_links[alarm_id];
+    storage_item->next_same_id = NULL;
+    storage_item->prev_same_id_link = link;
+    *link = storage_item;
+    scheduler->id_tail_links[alarm_id] = &storage_item->next_same_id;
+}
+
+static void unlink_alarm_id(ALARM_SCHEDULER* scheduler, const ALARM_STORAGE_ITEM* storage_item)
+{
+    uint8_t alarm_id = storage_item->alarm_info.alarm_id;
+    *storage_item->prev_same_id_link = storage_item->next_same_id;
+    if (storage_item->next_same_id != NULL)
+    {
+        storage_item->next_same_id->prev_same_id_link = storage_item->prev_same_id_link;
+    }
+    else
+    {
+        scheduler->id_tail_links[alarm_id] = scheduler->id_table[alarm_id] == NULL ? NULL : storage_item->prev_same_id_link;
+    }
+}
+
+// Day count that only ever moves forward, tm_yday alone wraps at new year
+static uint32_t get_day_number(const struct tm* curr_time)
+{
+    return (uint32_t)curr_time->tm_year*DAYS_IN_LEAP_YEAR + (uint32_t)curr_time->tm_yday;
+}
+
+static void set_heap_entry(ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, size_t pos, ALARM_STORAGE_ITEM* storage_item)
+{
+    scheduler->heaps[heap_id].entries[pos] = storage_item;
+    storage_item->heap_pos[heap_id] = pos;
+}
+
+static void sift_heap_up(ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, size_t pos)
+{
+    ALARM_HEAP* heap = &scheduler->heaps[heap_id];
+    ALARM_STORAGE_ITEM* storage_item = heap->entries[pos];
+    while (pos > 0)
+    {
+        size_t parent = (pos - 1) / 2;
+        if (heap->entries[parent]->heap_key[heap_id] <= storage_item->heap_key[heap_id])
+        {
+            break;
+        }
+        set_heap_entry(scheduler, heap_id, pos, heap->entries[parent]);
+        pos = parent;
+    }
+    set_heap_entry(scheduler, heap_id, pos, storage_item);
+}
+
+static void sift_heap_down(ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, size_t pos)
+{
+    ALARM_HEAP* heap = &scheduler->heaps[heap_id];
+    ALARM_STORAGE_ITEM* storage_item = heap->entries[pos];
+    size_t child;
+    while ((child = pos*2 + 1) < heap->count)
+    {
+        if (child + 1 < heap->count && heap->entries[child+1]->heap_key[heap_id] < heap->entries[child]->heap_key[heap_id])
+        {
+            child++;
+        }
+        if (storage_item->heap_key[heap_id] <= heap->entries[child]->heap_key[heap_id])
+        {
+            break;
+        }
+        set_heap_entry(scheduler, heap_id, pos, heap->entries[child]);
+        pos = child;
+    }
+    set_heap_entry(scheduler, heap_id, pos, storage_item);
+}
+
+// The heaps share the slot table capacity so queueing never allocates
+static void push_heap_item(ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, ALARM_STORAGE_ITEM* storage_item, int64_t key)
+{
+    storage_item->heap_key[heap_id] = key;
+    set_heap_entry(scheduler, heap_id, scheduler->heaps[heap_id].count++, storage_item);
+    sift_heap_up(scheduler, heap_id, storage_item->heap_pos[heap_id]);
+}
+
+static void remove_heap_item(ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, ALARM_STORAGE_ITEM* storage_item)
+{
+    ALARM_HEAP* heap = &scheduler->heaps[heap_id];
+    size_t pos = storage_item->heap_pos[heap_id];
+    if (pos != HEAP_NOT_QUEUED)
+    {
+        storage_item->heap_pos[heap_id] = HEAP_NOT_QUEUED;
+        if (pos != --heap->count)
+        {
+            // The last entry fills the hole and may need to move either way
+            ALARM_STORAGE_ITEM* moved_item = heap->entries[heap->count];
+            set_heap_entry(scheduler, heap_id, pos, moved_item);
+            sift_heap_up(scheduler, heap_id, pos);
+            sift_heap_down(scheduler, heap_id, moved_item->heap_pos[heap_id]);
+        }
+    }
+}
+
+static bool is_heap_top_due(const ALARM_SCHEDULER* scheduler, ALARM_HEAP_ID heap_id, int64_t key)
+{
+    const ALARM_HEAP* heap = &scheduler->heaps[heap_id];
+    return heap->count > 0 && heap->entries[0]->heap_key[heap_id] <= key;
+}
+
+// Snooze and one time alarms are removed once the day they fired on has passed
+static void queue_alarm_expiry(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item, const struct tm* fire_time)
+{
+    if (storage_item->heap_pos[ALARM_HEAP_EXPIRY] == HEAP_NOT_QUEUED)
+    {
+        push_heap_item(scheduler, ALARM_HEAP_EXPIRY, storage_item, (int64_t)get_day_number(fire_time) + 1);
+    }
+}
+
+// The caller is handed the alarm, so it only expires once released
+static void hold_alarm_expiry(ALARM_STORAGE_ITEM* storage_item, const struct tm* fire_time)
+{
+    storage_item->heap_key[ALARM_HEAP_EXPIRY] = (int64_t)get_day_number(fire_time) + 1;
+    storage_item->is_held = true;
+}
+
+static bool is_local_time_reached(time_t instant, const struct tm* target)
+{
+    bool result = false;
+    struct tm local;
+    if (localtime_r(&instant, &local) != NULL)
+    {
+        if (local.tm_year != target->tm_year)
         {
-            // Compare minutes
-            result = ai_initial->trigger_time.min > ai_compare->trigger_time.min;
+            result = local.tm_year > target->tm_year;
+        }
+        else if (local.tm_yday != target->tm_yday)
+        {
+            result = local.tm_yday > target->tm_yday;
         }
         else
         {
-            // Let's make sure that one hour has not passed
-            // If both the hours are either past or both are before the current hour the just compare them
-            if (
-                (ai_initial->trigger_time.hour >= curr_time->tm_hour && ai_compare->trigger_time.hour >= curr_time->tm_hour) ||
-                (ai_initial->trigger_time.hour <= curr_time->tm_hour && ai_compare->trigger_time.hour <= curr_time->tm_hour)
-               )
+            result = local.tm_hour*MINUTES_IN_HOUR + local.tm_min >= target->tm_hour*MINUTES_IN_HOUR + target->tm_min;
+        }
+    }
+    return result;
+}
+
+// Instant the local clock shows the alarm time on date.  A time the clock
+// shows twice when DST ends gives the first one, a time skipped when DST
+// starts gives the moment the clock jumps past it.
+static time_t get_local_instant(const struct tm* date, const TIME_INFO* trigger_time)
+{
+    time_t result = (time_t)-1;
+    time_t readings[2];
+    struct tm target = *date;
+    target.tm_hour = trigger_time->hour;
+    target.tm_min = trigger_time->min;
+    target.tm_sec = 0;
+    for (int is_dst = 0; is_dst < 2; is_dst++)
+    {
+        struct tm reading = target;
+        reading.tm_isdst = is_dst;
+        readings[is_dst] = mktime(&reading);
+        // mktime moves a reading that does not exist to another wall time
+        if (readings[is_dst] != (time_t)-1 && reading.tm_mday == target.tm_mday && reading.tm_hour == target.tm_hour && reading.tm_min == target.tm_min &&
+            (result == (time_t)-1 || readings[is_dst] < result))
+        {
+            result = readings[is_dst];
+        }
+    }
+    if (result == (time_t)-1 && readings[0] != (time_t)-1 && readings[1] != (time_t)-1)
+    {
+        // Neither reading exists, the jump lies between them
+        time_t low = readings[0] < readings[1] ? readings[0] : readings[1];
+        time_t high = readings[0] < readings[1] ? readings[1] : readings[0];
+        while (low < high)
+        {
+            time_t middle = low + (high - low)/2;
+            if (is_local_time_reached(middle, &target))
             {
-                result = ai_initial->trigger_time.hour > ai_compare->trigger_time.hour;
+                high = middle;
             }
             else
             {
-                // If the inital hour is past than the current time (it still is coming up) and the compare hour is before
-                if (ai_initial->trigger_time.hour >= curr_time->tm_hour && ai_compare->trigger_time.hour < curr_time->tm_hour)
-                {
-                    result = false;
-                }
-                else
+                low = middle + 1;
+            }
+        }
+        result = low;
+    }
+    return result;
+}
+
+// First instant at the alarm time on one of the days in day_mask, starting
+// first_day local days after from, that is not before not_before
+static time_t get_next_fire_instant(uint8_t day_mask, const TIME_INFO* trigger_time, time_t from, int first_day, time_t not_before)
+{
+    time_t result = (time_t)-1;
+    struct tm date;
+    if (day_mask != 0 && localtime_r(&from, &date) != NULL)
+    {
+        // Stepping days from noon keeps the date arithmetic clear of DST changes
+        date.tm_hour = 12;
+        date.tm_min = 0;
+        date.tm_sec = 0;
+        date.tm_isdst = -1;
+        for (int day = first_day; day <= first_day + DAYS_IN_WEEK && result == (time_t)-1; day++)
+        {
+            struct tm day_tm = date;
+            day_tm.tm_mday += day;
+            if (mktime(&day_tm) != (time_t)-1 && (day_mask & (1 << day_tm.tm_wday)) != 0)
+            {
+                time_t instant = get_local_instant(&day_tm, trigger_time);
+                if (instant != (time_t)-1 && instant >= not_before)
                 {
-                    result = true;
+                    result = instant;
                 }
             }
         }
     }
-    return result;
+    return result;
+}
+
+static ALARM_STORAGE_ITEM* get_schedule_node_item(WHEEL_NODE* node)
+{
+    return (ALARM_STORAGE_ITEM*)((char*)node - offsetof(ALARM_STORAGE_ITEM, schedule_node));
+}
+
+static void schedule_alarm(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item, time_t from, int first_day, time_t not_before)
+{
+    time_t instant = get_next_fire_instant(scheduler->slot_day_mask[storage_item->slot], &storage_item->alarm_info.trigger_time, from, first_day, not_before);
+    if (instant != (time_t)-1)
+    {
+        push_heap_item(scheduler, ALARM_HEAP_FIRE, storage_item, (int64_t)instant);
+    }
+}
+
+static void schedule_pending_alarms(ALARM_SCHEDULER* scheduler, time_t now, time_t not_before)
+{
+    WHEEL_NODE* node;
+    while ((node = scheduler->unscheduled_alarms.head) != NULL)
+    {
+        remove_wheel_node(&scheduler->unscheduled_alarms, node);
+        schedule_alarm(scheduler, get_schedule_node_item(node), now, 0, not_before);
+    }
+}
+
+static void detach_alarm(ALARM_SCHEDULER* scheduler, ALARM_STORAGE_ITEM* storage_item)
+{
+    scheduler->next_alarm_valid = false;
+    storage_item->is_held = false;
+    for (size_t heap_id = 0; heap_id < ALARM_HEAP_COUNT; heap_id++)
+    {
+        remove_heap_item(scheduler, (ALARM_HEAP_ID)heap_id, storage_item);
+    }
+    if (storage_item->schedule_node.prev_link != NULL)
+    {
+        remove_wheel_node(&scheduler->unscheduled_alarms, &storage_item->schedule_node);
+    }
+    unindex_alarm(scheduler, storage_item);
+    unlink_alarm_id(scheduler, storage_item);
 }
 
-static void calculate_snooze_time(const TIME_INFO* time_info, uint8_t snooze_min, TIME_INFO* snooze)
+static void remove_alarm_slot(ALARM_SCHEDULER* scheduler, size_t slot)
 {
-    snooze->sec = 0;
-    if ((time_info->min + snooze_min) > 59)
-    {
-        snooze->min = 60 - (time_info->min - snooze_min);
-        if (time_info->hour + 1 > 23)
-        {
-            snooze->hour = 00;
-        }
-        else
-        {
-            snooze->hour = time_info->hour + 1;
-        }
-    }
-    else
+    ALARM_STORAGE_ITEM* storage_item = scheduler->alarm_slots[slot];
+    detach_alarm(scheduler, storage_item);
+
+    scheduler->alarm_count--;
+    size_t move_count = scheduler->alarm_count - slot;
+    memmove(&scheduler->alarm_slots[slot], &scheduler->alarm_slots[slot+1], move_count*sizeof(ALARM_STORAGE_ITEM*));
+    memmove(&scheduler->slot_trigger_minute[slot], &scheduler->slot_trigger_minute[slot+1], move_count*sizeof(uint16_t));
+    memmove(&scheduler->slot_fired_day[slot], &scheduler->slot_fired_day[slot+1], move_count*sizeof(uint16_t));
+    memmove(&scheduler->slot_day_mask[slot], &scheduler->slot_day_mask[slot+1], move_count*sizeof(uint8_t));
+    for (size_t index = slot; index < scheduler->alarm_count; index++)
     {
-        snooze->min = time_info->min + snooze_min;
-        snooze->hour = time_info->hour;
+        scheduler->alarm_slots[index]->slot = index;
     }
+    release_storage_item(scheduler, storage_item);
 }
 
-static bool is_alarm_triggered(const ALARM_INFO* alarm_info, const struct tm* curr_time)
+static ALARM_STORAGE_ITEM* get_wheel_node_item(WHEEL_NODE* node, int wday)
 {
-    bool result = false;
-    if (alarm_info->trigger_days != NoDay && alarm_info->trigger_days & get_current_day(curr_time))
+    // The node for a day sits at that index in the item's wheel_nodes
+    return (ALARM_STORAGE_ITEM*)((char*)(node - wday) - offsetof(ALARM_STORAGE_ITEM, wheel_nodes));
+}
+
+// Marks up to list_size alarms in the bucket that have not fired today as
+// fired and hands them back in the order they were added
+static size_t collect_triggered_alarms(ALARM_SCHEDULER* scheduler, uint16_t week_minute, const struct tm* curr_time, const ALARM_INFO** triggered_list, size_t list_size)
+{
+    size_t result = 0;
+    for (WHEEL_NODE* node = scheduler->trigger_wheel[week_minute].head; node != NULL && result < list_size; node = node->next)
     {
-        if (alarm_info->trigger_time.hour == curr_time->tm_hour ||
-            alarm_info->trigger_time.hour == curr_time->tm_hour - 1)
+        ALARM_STORAGE_ITEM* storage_item = get_wheel_node_item(node, week_minute / MINUTES_IN_DAY);
+        if (scheduler->slot_fired_day[storage_item->slot] != curr_time->tm_yday)
         {
-            if (alarm_info->trigger_time.min == curr_time->tm_min)
+            scheduler->slot_fired_day[storage_item->slot] = (uint16_t)curr_time->tm_yday;
+            if (storage_item->type == ALARM_TYPE_SNOOZE || storage_item->type == ALARM_TYPE_ONE_TIME)
             {
-                result = true;
+                queue_alarm_expiry(scheduler, storage_item, curr_time);
             }
+            triggered_list[result++] = &storage_item->alarm_info;
         }
     }
     return result;
@@ -273,7 +1052,7 @@ static int store_time_object(ALARM_SCHEDULER* scheduler, ALARM_TYPE type, const
         log_error("Invalid time value specified");
         result = __LINE__;
     }
-    else if ((tm_info = (ALARM_STORAGE_ITEM*)malloc(sizeof(ALARM_STORAGE_ITEM))) == NULL)
+    else if ((tm_info = allocate_storage_item(scheduler)) == NULL)
     {
         log_error("Failed to allocate alarm info");
         result = __LINE__;
@@ -281,7 +1060,10 @@ static int store_time_object(ALARM_SCHEDULER* scheduler, ALARM_TYPE type, const
     else
     {
         tm_info->type = type;
-        tm_info->triggered_date = INVALID_TRIGGERED_DATE;
+        for (size_t heap_id = 0; heap_id < ALARM_HEAP_COUNT; heap_id++)
+        {
+            tm_info->heap_pos[heap_id] = HEAP_NOT_QUEUED;
+        }
         tm_info->alarm_info.trigger_days = trigger_days;
         if (id == NULL)
         {
@@ -301,51 +1083,107 @@ static int store_time_object(ALARM_SCHEDULER* scheduler, ALARM_TYPE type, const
         }
         memcpy(&tm_info->alarm_info.trigger_time, time_info, sizeof(TIME_INFO) );
         tm_info->alarm_info.snooze_min = snooze_min;
-        if (alarm_text != NULL && clone_string(&tm_info->alarm_info.alarm_text, alarm_text) != 0)
+        if (alarm_text != NULL && intern_string(scheduler, &tm_info->alarm_info.alarm_text, alarm_text) != 0)
         {
             log_error("Failure copying alarm text");
-            free(tm_info);
+            release_storage_item(scheduler, tm_info);
             result = __LINE__;
         }
-        else if (sound_file != NULL && clone_string(&tm_info->alarm_info.sound_file, sound_file) != 0)
+        else if (sound_file != NULL && intern_string(scheduler, &tm_info->alarm_info.sound_file, sound_file) != 0)
         {
             log_error("Failure copying sound file");
-            free(tm_info->alarm_info.alarm_text);
-            free(tm_info);
+            release_storage_item(scheduler, tm_info);
             result = __LINE__;
         }
-        else if (item_list_add_item(scheduler->sched_list, (const void*)tm_info) != 0)
+        else if (ensure_slot_capacity(scheduler, 1) != 0)
         {
             log_error("Failure adding items to list");
-            free(tm_info->alarm_info.alarm_text);
-            free(tm_info->alarm_info.sound_file);
-            free(tm_info);
+            release_storage_item(scheduler, tm_info);
             result = __LINE__;
         }
         else
         {
+            index_alarm(scheduler, tm_info);
+            append_wheel_node(&scheduler->unscheduled_alarms, &tm_info->schedule_node);
+            tm_info->slot = scheduler->alarm_count;
+            scheduler->alarm_slots[tm_info->slot] = tm_info;
+            scheduler->slot_trigger_minute[tm_info->slot] = get_day_minute(time_info);
+            scheduler->slot_fired_day[tm_info->slot] = INVALID_TRIGGERED_DATE;
+            scheduler->slot_day_mask[tm_info->slot] = get_wday_mask(trigger_days);
+            scheduler->alarm_count++;
+            link_alarm_id(scheduler, tm_info);
+            scheduler->next_alarm_valid = false;
             result = 0;
         }
     }
     return result;
 }
 
-static void purge_alarms(ALARM_SCHEDULER* scheduler)
+static ALARM_TYPE get_alarm_type(uint32_t trigger_days)
+{
+    ALARM_TYPE result = ALARM_TYPE_ACTIVE;
+    if (trigger_days == NoDay)
+    {
+        result = ALARM_TYPE_INACTIVE;
+    }
+    else if (trigger_days == OneTime)
+    {
+        result = ALARM_TYPE_ONE_TIME;
+    }
+    return result;
+}
+
+static void purge_alarms(ALARM_SCHEDULER* scheduler, uint32_t curr_day)
 {
-    const ALARM_STORAGE_ITEM* alarm_info;
-    ITERATOR_HANDLE iterator = item_list_iterator(scheduler->sched_list);
-    if (iterator != NULL)
+    // Only the heap top is checked until something is due
+    if (is_heap_top_due(scheduler, ALARM_HEAP_EXPIRY, curr_day))
     {
-        if ((alarm_info = (ALARM_STORAGE_ITEM*)item_list_get_next(scheduler->sched_list, &iterator)) == NULL)
+        size_t first_slot = scheduler->alarm_count;
+        do
         {
-            if (alarm_info->type == ALARM_TYPE_SNOOZE || alarm_info->type == ALARM_TYPE_ONE_TIME)
+            ALARM_STORAGE_ITEM* storage_item = scheduler->heaps[ALARM_HEAP_EXPIRY].entries[0];
+            if (storage_item->slot < first_slot)
             {
-                if (item_list_remove_item(scheduler->sched_list, 0) != 0)
-                {
-                    log_warning("Failure removing alarm info %s", alarm_info->alarm_info.alarm_text);
-                }
+                first_slot = storage_item->slot;
+            }
+            detach_alarm(scheduler, storage_item);
+            scheduler->alarm_slots[storage_item->slot] = NULL;
+            release_storage_item(scheduler, storage_item);
+        } while (is_heap_top_due(scheduler, ALARM_HEAP_EXPIRY, curr_day));
+
+        // Close the gaps in one pass however many alarms expired
+        size_t target = first_slot;
+        for (size_t index = first_slot; index < scheduler->alarm_count; index++)
+        {
+            ALARM_STORAGE_ITEM* storage_item = scheduler->alarm_slots[index];
+            if (storage_item != NULL)
+            {
+                scheduler->alarm_slots[target] = storage_item;
+                scheduler->slot_trigger_minute[target] = scheduler->slot_trigger_minute[index];
+                scheduler->slot_fired_day[target] = scheduler->slot_fired_day[index];
+                scheduler->slot_day_mask[target] = scheduler->slot_day_mask[index];
+                storage_item->slot = target++;
             }
         }
+        scheduler->alarm_count = target;
+    }
+}
+
+// Expires snooze and one time alarms once the local day rolls over, the
+// local time is only broken down again at the next midnight
+static void update_local_day(ALARM_SCHEDULER* scheduler, time_t now)
+{
+    struct tm local;
+    if (now >= scheduler->next_day_start && localtime_r(&now, &local) != NULL)
+    {
+        scheduler->current_day = get_day_number(&local);
+        purge_alarms(scheduler, scheduler->current_day);
+        local.tm_mday++;
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+        scheduler->next_day_start = mktime(&local);
     }
 }
 
@@ -359,14 +1197,23 @@ SCHEDULER_HANDLE alarm_scheduler_create(void)
     else
     {
         memset(result, 0, sizeof(ALARM_SCHEDULER));
-        if ((result->sched_list = item_list_create(destroy_schedule_list_cb, result)) == NULL)
+        if (resize_slot_table(result, INITIAL_STORE_CAPACITY) != 0)
+        {
+            log_error("Unable to allocate alarm slots");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->trigger_wheel = (WHEEL_BUCKET*)malloc(MINUTES_IN_WEEK*sizeof(WHEEL_BUCKET))) == NULL)
         {
-            log_error("Unable to allocate item list");
+            log_error("Unable to allocate trigger wheel");
+            free(result->alarm_slots);
             free(result);
             result = NULL;
         }
         else
         {
+            memset(result->trigger_wheel, 0, MINUTES_IN_WEEK*sizeof(WHEEL_BUCKET));
+            result->next_chunk_count = ITEM_CHUNK_MIN_COUNT;
             result->alarm_next_id = MIN_ID_VALUE;
         }
     }
@@ -377,7 +1224,21 @@ void alarm_scheduler_destroy(SCHEDULER_HANDLE handle)
 {
     if (handle != NULL)
     {
-        item_list_destroy(handle->sched_list);
+        while (handle->item_chunks != NULL)
+        {
+            ITEM_CHUNK* chunk = handle->item_chunks;
+            handle->item_chunks = chunk->next;
+            free(chunk);
+        }
+        while (handle->string_blocks != NULL)
+        {
+            STRING_BLOCK* block = handle->string_blocks;
+            handle->string_blocks = block->next;
+            free(block);
+        }
+        free(handle->string_table);
+        free(handle->trigger_wheel);
+        free(handle->alarm_slots);
         free(handle);
     }
 }
@@ -391,31 +1252,197 @@ const ALARM_INFO* alarm_scheduler_is_triggered(SCHEDULER_HANDLE handle, const st
     }
     else
     {
-        purge_alarms(handle);
+        (void)alarm_scheduler_get_triggered_alarms(handle, curr_time, &result, 1);
+    }
+    return result;
+}
+
+size_t alarm_scheduler_get_triggered_alarms(SCHEDULER_HANDLE handle, const struct tm* curr_time, const ALARM_INFO** triggered_list, size_t list_size)
+{
+    size_t result = 0;
+    if (handle == NULL || curr_time == NULL || triggered_list == NULL)
+    {
+        log_error("Invalid argument handle: %p, curr_time: %p, triggered_list: %p", handle, curr_time, triggered_list);
+    }
+    else if (curr_time->tm_wday >= 0 && curr_time->tm_wday < DAYS_IN_WEEK)
+    {
+        purge_alarms(handle, get_day_number(curr_time));
+
+        uint16_t week_minute = get_week_minute(curr_time->tm_wday, curr_time->tm_hour, curr_time->tm_min);
+        result = collect_triggered_alarms(handle, week_minute, curr_time, triggered_list, list_size);
+        if (curr_time->tm_hour > 0)
+        {
+            // Alarms from the previous hour that have not fired today still trigger
+            result += collect_triggered_alarms(handle, week_minute - MINUTES_IN_HOUR, curr_time, triggered_list + result, list_size - result);
+        }
+    }
+    return result;
+}
+
+size_t alarm_scheduler_get_due_alarms(SCHEDULER_HANDLE handle, time_t now, const ALARM_INFO** triggered_list, size_t list_size)
+{
+    size_t result = 0;
+    if (handle == NULL || triggered_list == NULL)
+    {
+        log_error("Invalid argument handle: %p, triggered_list: %p", handle, triggered_list);
+    }
+    else
+    {
+        // A new alarm still fires during its own minute
+        time_t not_before = now - (SECONDS_IN_MINUTE - 1);
+        if (handle->timezone_changed)
+        {
+            // Everything gets a new instant under the new rules, without
+            // firing again what already fired this minute
+            ALARM_HEAP* fire_heap = &handle->heaps[ALARM_HEAP_FIRE];
+            while (fire_heap->count > 0)
+            {
+                ALARM_STORAGE_ITEM* storage_item = fire_heap->entries[fire_heap->count - 1];
+                remove_heap_item(handle, ALARM_HEAP_FIRE, storage_item);
+                append_wheel_node(&handle->unscheduled_alarms, &storage_item->schedule_node);
+            }
+            handle->next_day_start = 0;
+            handle->timezone_changed = false;
+            not_before = now + 1;
+        }
+        update_local_day(handle, now);
+        schedule_pending_alarms(handle, now, not_before);
 
-        // Loop through the available alarms and see if any are triggered
-        size_t alarm_cnt = item_list_item_count(handle->sched_list);
-        for (size_t index = 0; index < alarm_cnt; index++)
+        while (result < list_size && is_heap_top_due(handle, ALARM_HEAP_FIRE, now))
         {
-            ALARM_STORAGE_ITEM* alarm_info = (ALARM_STORAGE_ITEM*)item_list_get_item(handle->sched_list, index);
-            if (alarm_info != NULL)
+            ALARM_STORAGE_ITEM* storage_item = handle->heaps[ALARM_HEAP_FIRE].entries[0];
+            time_t fire_instant = (time_t)storage_item->heap_key[ALARM_HEAP_FIRE];
+            // Alarms missed while the clock was off or stalled are skipped
+            bool is_missed = now - fire_instant >= MISSED_ALARM_WINDOW;
+            struct tm fire_time = {0};
+            (void)localtime_r(is_missed ? &now : &fire_instant, &fire_time);
+
+            remove_heap_item(handle, ALARM_HEAP_FIRE, storage_item);
+            if (storage_item->type == ALARM_TYPE_SNOOZE || storage_item->type == ALARM_TYPE_ONE_TIME)
             {
-                if (alarm_info->alarm_info.trigger_days != NoDay)
+                if (is_missed)
+                {
+                    queue_alarm_expiry(handle, storage_item, &fire_time);
+                }
+                else
                 {
-                    if (is_alarm_triggered(&alarm_info->alarm_info, curr_time) &&
-                        alarm_info->triggered_date != curr_time->tm_yday)
-                    {
-                        alarm_info->triggered_date = curr_time->tm_yday;
-                        result = &alarm_info->alarm_info;
-                        break;
-                    }
+                    hold_alarm_expiry(storage_item, &fire_time);
                 }
             }
+            else if (is_missed)
+            {
+                schedule_alarm(handle, storage_item, now, 0, now + 1);
+            }
+            else
+            {
+                schedule_alarm(handle, storage_item, fire_instant, 1, fire_instant + 1);
+            }
+            if (!is_missed)
+            {
+                handle->slot_fired_day[storage_item->slot] = (uint16_t)fire_time.tm_yday;
+                storage_item->fired_instant = fire_instant;
+                triggered_list[result++] = &storage_item->alarm_info;
+            }
+        }
+    }
+    return result;
+}
+
+void alarm_scheduler_timezone_changed(SCHEDULER_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        log_error("Invalid argument handle is NULL");
+    }
+    else
+    {
+        // localtime_r is not required to pick up a new TZ on its own
+        tzset();
+        handle->timezone_changed = true;
+    }
+}
+
+time_t alarm_scheduler_get_next_due_time(SCHEDULER_HANDLE handle)
+{
+    time_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument handle is NULL");
+        result = 0;
+    }
+    // New alarms and a new timezone have no fire instant until the next check
+    else if (handle->timezone_changed || handle->unscheduled_alarms.head != NULL || handle->next_day_start == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        // The day rollover purges expired snoozes and one time alarms
+        result = handle->next_day_start;
+        if (handle->heaps[ALARM_HEAP_FIRE].count > 0 && handle->heaps[ALARM_HEAP_FIRE].entries[0]->heap_key[ALARM_HEAP_FIRE] < (int64_t)result)
+        {
+            result = (time_t)handle->heaps[ALARM_HEAP_FIRE].entries[0]->heap_key[ALARM_HEAP_FIRE];
         }
     }
     return result;
 }
 
+const ALARM_INFO* alarm_scheduler_get_next_due_alarm(SCHEDULER_HANDLE handle, time_t* fire_time)
+{
+    const ALARM_INFO* result;
+    if (handle == NULL || fire_time == NULL)
+    {
+        log_error("Invalid argument handle: %p, fire_time: %p", handle, fire_time);
+        result = NULL;
+    }
+    else if (handle->heaps[ALARM_HEAP_FIRE].count == 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        ALARM_STORAGE_ITEM* storage_item = handle->heaps[ALARM_HEAP_FIRE].entries[0];
+        *fire_time = (time_t)storage_item->heap_key[ALARM_HEAP_FIRE];
+        result = &storage_item->alarm_info;
+    }
+    return result;
+}
+
+time_t alarm_scheduler_get_fire_time(SCHEDULER_HANDLE handle, const ALARM_INFO* alarm_info)
+{
+    time_t result;
+    if (handle == NULL || alarm_info == NULL)
+    {
+        log_error("Invalid argument handle: %p, alarm_info: %p", handle, alarm_info);
+        result = 0;
+    }
+    else
+    {
+        const ALARM_STORAGE_ITEM* storage_item = (const ALARM_STORAGE_ITEM*)((const char*)alarm_info - offsetof(ALARM_STORAGE_ITEM, alarm_info));
+        result = storage_item->fired_instant;
+    }
+    return result;
+}
+
+void alarm_scheduler_release_alarm(SCHEDULER_HANDLE handle, const ALARM_INFO* alarm_info)
+{
+    if (handle == NULL || alarm_info == NULL)
+    {
+        log_error("Invalid argument handle: %p, alarm_info: %p", handle, alarm_info);
+    }
+    else
+    {
+        ALARM_STORAGE_ITEM* storage_item = (ALARM_STORAGE_ITEM*)((const char*)alarm_info - offsetof(ALARM_STORAGE_ITEM, alarm_info));
+        if (storage_item->is_held)
+        {
+            storage_item->is_held = false;
+            push_heap_item(handle, ALARM_HEAP_EXPIRY, storage_item, storage_item->heap_key[ALARM_HEAP_EXPIRY]);
+            // The day may have rolled over while the alarm was held
+            purge_alarms(handle, handle->current_day);
+        }
+    }
+}
+
 int alarm_scheduler_add_alarm_info(SCHEDULER_HANDLE handle, ALARM_INFO* alarm_info)
 {
     int result;
@@ -426,16 +1453,7 @@ int alarm_scheduler_add_alarm_info(SCHEDULER_HANDLE handle, ALARM_INFO* alarm_in
     }
     else
     {
-        ALARM_TYPE type = ALARM_TYPE_ACTIVE;
-        if (alarm_info->trigger_days == NoDay)
-        {
-            type = ALARM_TYPE_INACTIVE;
-        }
-        else if (alarm_info->trigger_days == OneTime)
-        {
-            type = ALARM_TYPE_ONE_TIME;
-        }
-        if (store_time_object(handle, type, alarm_info->alarm_text, &alarm_info->trigger_time, alarm_info->trigger_days, alarm_info->sound_file, alarm_info->snooze_min, &alarm_info->alarm_id) != 0)
+        if (store_time_object(handle, get_alarm_type(alarm_info->trigger_days), alarm_info->alarm_text, &alarm_info->trigger_time, alarm_info->trigger_days, alarm_info->sound_file, alarm_info->snooze_min, &alarm_info->alarm_id) != 0)
         {
             log_error("Invalid time value specified");
             result = __LINE__;
@@ -448,6 +1466,48 @@ int alarm_scheduler_add_alarm_info(SCHEDULER_HANDLE handle, ALARM_INFO* alarm_in
     return result;
 }
 
+int alarm_scheduler_add_alarms(SCHEDULER_HANDLE handle, const ALARM_INFO* alarm_list, size_t alarm_count)
+{
+    int result;
+    if (handle == NULL || (alarm_list == NULL && alarm_count > 0))
+    {
+        log_error("Invalid argument value: handle: %p, alarm_list: %p", handle, alarm_list);
+        result = __LINE__;
+    }
+    else if (ensure_slot_capacity(handle, alarm_count) != 0 || reserve_storage_items(handle, alarm_count) != 0)
+    {
+        log_error("Failure reserving storage for %zu alarms", alarm_count);
+        result = __LINE__;
+    }
+    else
+    {
+        size_t initial_count = handle->alarm_count;
+        uint8_t initial_next_id = handle->alarm_next_id;
+        result = 0;
+        for (size_t index = 0; index < alarm_count; index++)
+        {
+            const ALARM_INFO* alarm_info = &alarm_list[index];
+            uint8_t alarm_id = alarm_info->alarm_id;
+            if (store_time_object(handle, get_alarm_type(alarm_info->trigger_days), alarm_info->alarm_text, &alarm_info->trigger_time, alarm_info->trigger_days, alarm_info->sound_file, alarm_info->snooze_min, &alarm_id) != 0)
+            {
+                log_error("Failure adding alarm %zu of %zu", index, alarm_count);
+                result = __LINE__;
+                break;
+            }
+        }
+        if (result != 0)
+        {
+            // Leave the scheduler as it was before the call
+            while (handle->alarm_count > initial_count)
+            {
+                remove_alarm_slot(handle, handle->alarm_count-1);
+            }
+            handle->alarm_next_id = initial_next_id;
+        }
+    }
+    return result;
+}
+
 int alarm_scheduler_add_alarm(SCHEDULER_HANDLE handle, const char* alarm_text, const TIME_INFO* time_info, uint32_t trigger_days, const char* sound_file, uint8_t snooze_min, uint8_t* alarm_id)
 {
     int result;
@@ -496,25 +1556,12 @@ int alarm_scheduler_delete_alarm(SCHEDULER_HANDLE handle, uint8_t alarm_id)
     }
     else
     {
-        result = 0;
-        size_t alarm_cnt = item_list_item_count(handle->sched_list);
-        for (size_t index = 0; index < alarm_cnt; index++)
+        const ALARM_STORAGE_ITEM* item = handle->id_table[alarm_id];
+        if (item != NULL)
         {
-            const ALARM_STORAGE_ITEM* item = item_list_get_item(handle->sched_list, index);
-            if (item != NULL && item->alarm_info.alarm_id == alarm_id)
-            {
-                if (item_list_remove_item(handle->sched_list, index) != 0)
-                {
-                    log_error("Failure removing item id %d", (int)alarm_id);
-                    result = __LINE__;
-                }
-                else
-                {
-                    result = 0;
-                }
-                break;
-            }
+            remove_alarm_slot(handle, item->slot);
         }
+        result = 0;
     }
     return result;
 }
@@ -527,27 +1574,15 @@ int alarm_scheduler_remove_alarm(SCHEDULER_HANDLE handle, size_t alarm_index)
         log_error("Invalid argument handle:%p", handle);
         result = __LINE__;
     }
+    else if (alarm_index >= handle->alarm_count)
+    {
+        log_error("remove item index is out of range");
+        result = __LINE__;
+    }
     else
     {
+        remove_alarm_slot(handle, alarm_index);
         result = 0;
-        size_t alarm_cnt = item_list_item_count(handle->sched_list);
-        if (alarm_cnt >= alarm_index)
-        {
-            if (item_list_remove_item(handle->sched_list, alarm_index) != 0)
-            {
-                log_error("Failure removing item %d", (int)alarm_index);
-                result = __LINE__;
-            }
-            else
-            {
-                result = 0;
-            }
-        }
-        else
-        {
-            log_error("remove item index is out of range");
-            result = __LINE__;
-        }
     }
     return result;
 }
@@ -561,36 +1596,49 @@ const ALARM_INFO* alarm_scheduler_get_next_alarm(SCHEDULER_HANDLE handle)
     }
     else
     {
-        struct tm* curr_time = get_time_value();
-
-        // Loop through the available alarms and see if any are triggered
-        size_t alarm_cnt = item_list_item_count(handle->sched_list);
-        for (size_t index = 0; index < alarm_cnt; index++)
+        time_t now = get_time();
+        // A clock moving backwards can skip past an alarm we would have expired on
+        if (handle->next_alarm_valid && now >= handle->next_alarm_calc_time && (handle->next_alarm == NULL || now < handle->next_alarm_time))
         {
-            ALARM_STORAGE_ITEM* alarm_info = (ALARM_STORAGE_ITEM*)item_list_get_item(handle->sched_list, index);
-            if (alarm_info != NULL)
+            result = handle->next_alarm;
+        }
+        else
+        {
+            struct tm* curr_time = get_time_value();
+            uint32_t day_minute = curr_time->tm_hour*MINUTES_IN_HOUR + curr_time->tm_min;
+            NEXT_ALARM_SCAN scan = scan_next_alarm(handle, curr_time->tm_wday, day_minute);
+            if (scan.minutes != ALARM_NO_TRIGGER)
             {
-                if (alarm_info->alarm_info.trigger_days != NoDay)
-                {
-                    if (result == NULL)
-                    {
-                        // If we only have 1 alarm then this is the next one
-                        result = &alarm_info->alarm_info;
-                    }
-                    else
-                    {
-                        if (is_alarm_initial_sooner(result, &alarm_info->alarm_info, curr_time))
-                        {
-                            result = &alarm_info->alarm_info;
-                        }
-                    }
-                }
+                result = &handle->alarm_slots[scan.slot]->alarm_info;
+            }
+            handle->next_alarm = result;
+            if (result != NULL)
+            {
+                handle->next_alarm_time = now + (time_t)scan.minutes*60 - curr_time->tm_sec;
             }
+            handle->next_alarm_calc_time = now;
+            handle->next_alarm_valid = true;
+            handle->next_alarm_generation++;
         }
     }
     return result;
 }
 
+uint32_t alarm_scheduler_get_next_alarm_generation(SCHEDULER_HANDLE handle)
+{
+    uint32_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument handle is NULL");
+        result = 0;
+    }
+    else
+    {
+        result = handle->next_alarm_generation;
+    }
+    return result;
+}
+
 int alarm_scheduler_get_next_day(const ALARM_INFO* alarm_info)
 {
     struct tm* curr_time = get_time_value();
@@ -599,6 +1647,26 @@ int alarm_scheduler_get_next_day(const ALARM_INFO* alarm_info)
     return get_next_trigger_day(curr_time, alarm_info->trigger_days, &alarm_info->trigger_time);
 }
 
+uint32_t alarm_scheduler_get_minutes_till_trigger(const ALARM_INFO* alarm_info, const struct tm* curr_time)
+{
+    uint32_t result;
+    if (alarm_info == NULL || curr_time == NULL)
+    {
+        log_error("Invalid argument alarm_info: %p, curr_time: %p", alarm_info, curr_time);
+        result = ALARM_NO_TRIGGER;
+    }
+    else if (curr_time->tm_wday < 0 || curr_time->tm_wday >= DAYS_IN_WEEK)
+    {
+        log_error("Invalid week day specified %d", curr_time->tm_wday);
+        result = ALARM_NO_TRIGGER;
+    }
+    else
+    {
+        result = get_minutes_till_trigger(get_wday_mask(alarm_info->trigger_days), get_day_minute(&alarm_info->trigger_time), curr_time->tm_wday, curr_time->tm_hour*MINUTES_IN_HOUR + curr_time->tm_min);
+    }
+    return result;
+}
+
 size_t alarm_scheduler_get_alarm_count(SCHEDULER_HANDLE handle)
 {
     size_t result;
@@ -609,7 +1677,7 @@ size_t alarm_scheduler_get_alarm_count(SCHEDULER_HANDLE handle)
     }
     else
     {
-        result = item_list_item_count(handle->sched_list);
+        result = handle->alarm_count;
     }
     return result;
 }
@@ -622,18 +1690,14 @@ const ALARM_INFO* alarm_scheduler_get_alarm(SCHEDULER_HANDLE handle, size_t inde
         log_error("Invalid argument handle is NULL");
         result = NULL;
     }
+    else if (index >= handle->alarm_count)
+    {
+        log_error("Failure retrieving item");
+        result = NULL;
+    }
     else
     {
-        const ALARM_STORAGE_ITEM* tm_info = item_list_get_item(handle->sched_list, index);
-        if (tm_info == NULL)
-        {
-            log_error("Failure retrieving item");
-            result = NULL;
-        }
-        else
-        {
-            result = &tm_info->alarm_info;
-        }
+        result = &handle->alarm_slots[index]->alarm_info;
     }
     return result;
 }
@@ -646,19 +1710,13 @@ const ALARM_INFO* alarm_scheduler_get_alarm_by_id(SCHEDULER_HANDLE handle, size_
         log_error("Invalid argument handle is NULL");
         result = NULL;
     }
-    else
+    else if (id >= ALARM_ID_TABLE_SIZE || handle->id_table[id] == NULL)
     {
         result = NULL;
-        size_t alarm_cnt = item_list_item_count(handle->sched_list);
-        for (size_t index = 0; index < alarm_cnt; index++)
-        {
-            const ALARM_STORAGE_ITEM* item = item_list_get_item(handle->sched_list, index);
-            if (item != NULL && item->alarm_info.alarm_id == id)
-            {
-                result = &item->alarm_info;
-                break;
-            }
-        }
+    }
+    else
+    {
+        result = &handle->id_table[id]->alarm_info;
     }
     return result;
 }
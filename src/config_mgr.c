@@ -13,6 +13,7 @@
 
 static const char* CONFIG_JSON_FILE = "clock_config.json";
 static const char* NTP_ADDRESS_NODE = "ntpAddress";
+static const char* NTP_SERVERS_NODE = "ntpServers";
 static const char* ZIPCODE_NODE = "zipcode";
 static const char* ALARMS_ARRAY_NODE = "alarms";
 static const char* AUDIO_DIR_NODE = "audioDirectory";
@@ -21,6 +22,9 @@ static const char* OPTION_NODE = "option";
 static const char* SHADE_START_NODE = "shadeStart";
 static const char* SHADE_END_NODE = "shadeEnd";
 static const char* DEMO_MODE_NODE = "demo_mode";
+static const char* ALARM_PREPARE_NODE = "alarmPrepareTime";
+static const char* SOUND_CACHE_NODE = "soundCacheSize";
+static const char* CRESCENDO_TIME_NODE = "crescendoTime";
 
 static const char* ALARM_NODE_NAME = "name";
 static const char* ALARM_NODE_TIME = "time";
@@ -34,6 +38,8 @@ static const char* ALARM_NODE_ID = "id";
 #define USE_CELSIUS             0x00000004
 #define DEFAULT_DIGIT_COLOR     0
 #define INVALID_DIGIT_COLOR     0xFFFFFFFF
+#define DEFAULT_ALARM_PREPARE_TIME  60
+#define DEFAULT_SOUND_CACHE_SIZE    8192
 
 typedef struct CONFIG_MGR_INFO_TAG
 {
@@ -281,6 +287,44 @@ const char* config_mgr_get_ntp_address(CONFIG_MGR_HANDLE handle)
     return result;
 }
 
+size_t config_mgr_get_ntp_servers(CONFIG_MGR_HANDLE handle, const char** server_list, size_t list_count)
+{
+    size_t result = 0;
+    if (handle == NULL || server_list == NULL || list_count == 0)
+    {
+        log_error("Invalid parameter specified handle: %p, server_list: %p, list_count: %zu", handle, server_list, list_count);
+    }
+    else
+    {
+        JSON_Array* servers;
+        if ((servers = json_object_get_array(handle->json_object, NTP_SERVERS_NODE)) == NULL)
+        {
+            // Older configs only name the one server
+            if ((server_list[0] = config_mgr_get_ntp_address(handle)) != NULL)
+            {
+                result = 1;
+            }
+        }
+        else
+        {
+            size_t server_count = json_array_get_count(servers);
+            for (size_t index = 0; index < server_count && result < list_count; index++)
+            {
+                const char* server;
+                if ((server = json_array_get_string(servers, index)) == NULL)
+                {
+                    log_warning("Skipping invalid ntp server entry %zu", index);
+                }
+                else
+                {
+                    server_list[result++] = server;
+                }
+            }
+        }
+    }
+    return result;
+}
+
 const char* config_mgr_get_audio_dir(CONFIG_MGR_HANDLE handle)
 {
     const char* result;
@@ -544,6 +588,56 @@ bool config_mgr_show_seconds(CONFIG_MGR_HANDLE handle)
     return result;
 }
 
+uint32_t config_mgr_get_alarm_prepare_time(CONFIG_MGR_HANDLE handle)
+{
+    uint32_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid handle specified");
+        result = DEFAULT_ALARM_PREPARE_TIME;
+    }
+    else
+    {
+        // A missing node reads as 0
+        double prepare_time = json_object_get_number(handle->json_object, ALARM_PREPARE_NODE);
+        result = prepare_time <= 0 ? DEFAULT_ALARM_PREPARE_TIME : (uint32_t)prepare_time;
+    }
+    return result;
+}
+
+uint32_t config_mgr_get_sound_cache_size(CONFIG_MGR_HANDLE handle)
+{
+    uint32_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid handle specified");
+        result = DEFAULT_SOUND_CACHE_SIZE;
+    }
+    else
+    {
+        double cache_size = json_object_get_number(handle->json_object, SOUND_CACHE_NODE);
+        result = cache_size <= 0 ? DEFAULT_SOUND_CACHE_SIZE : (uint32_t)cache_size;
+    }
+    return result;
+}
+
+uint32_t config_mgr_get_crescendo_time(CONFIG_MGR_HANDLE handle)
+{
+    uint32_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid handle specified");
+        result = 0;
+    }
+    else
+    {
+        // A missing node reads as 0 which plays alarms at full volume
+        double crescendo_time = json_object_get_number(handle->json_object, CRESCENDO_TIME_NODE);
+        result = crescendo_time <= 0 ? 0 : (uint32_t)crescendo_time;
+    }
+    return result;
+}
+
 int config_mgr_set_24h_clock(CONFIG_MGR_HANDLE handle, bool is_24h_clock)
 {
     int result;
@@ -188,6 +188,13 @@ size_t gui_mgr_get_refresh_resolution(void)
     return RESOLUTION_TIME;
 }
 
+int gui_mgr_get_input_fd(GUI_MGR_HANDLE handle)
+{
+    (void)handle;
+    // getch reads the terminal straight from stdin
+    return STDIN_FILENO;
+}
+
 int gui_mgr_create_win(GUI_MGR_HANDLE handle)
 {
     int result;
@@ -1135,6 +1135,13 @@ size_t gui_mgr_get_refresh_resolution(void)
     return RESOLUTION_TIME;
 }
 
+int gui_mgr_get_input_fd(GUI_MGR_HANDLE handle)
+{
+    (void)handle;
+    // lvgl needs its tick every refresh resolution and SDL input has no fd to wait on
+    return -1;
+}
+
 int gui_mgr_create_win(GUI_MGR_HANDLE handle)
 {
     int result;
@@ -0,0 +1,165 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "lib-util-c/app_logging.h"
+
+#include "latency_stats.h"
+
+static size_t get_bucket_index(uint64_t latency_usec)
+{
+    size_t result;
+    if (latency_usec < LATENCY_SUB_BUCKET_COUNT)
+    {
+        result = (size_t)latency_usec;
+    }
+    else
+    {
+        // The top bits below the leading one pick the linear bucket
+        size_t shift = (size_t)(63 - __builtin_clzll(latency_usec)) - LATENCY_SUB_BUCKET_BITS;
+        result = (shift + 1)*LATENCY_SUB_BUCKET_COUNT + (size_t)((latency_usec >> shift) & (LATENCY_SUB_BUCKET_COUNT - 1));
+    }
+    return result;
+}
+
+static uint64_t get_bucket_upper_bound(size_t index)
+{
+    uint64_t result;
+    if (index < LATENCY_SUB_BUCKET_COUNT)
+    {
+        result = index;
+    }
+    else
+    {
+        size_t shift = index/LATENCY_SUB_BUCKET_COUNT - 1;
+        uint64_t lower_bound = (uint64_t)(LATENCY_SUB_BUCKET_COUNT + index % LATENCY_SUB_BUCKET_COUNT) << shift;
+        result = lower_bound + (UINT64_C(1) << shift) - 1;
+    }
+    return result;
+}
+
+void latency_stats_init(LATENCY_HISTOGRAM* histogram)
+{
+    if (histogram == NULL)
+    {
+        log_error("Invalid argument histogram is NULL");
+    }
+    else
+    {
+        memset(histogram, 0, sizeof(LATENCY_HISTOGRAM));
+    }
+}
+
+void latency_stats_add(LATENCY_HISTOGRAM* histogram, uint64_t latency_usec)
+{
+    if (histogram == NULL)
+    {
+        log_error("Invalid argument histogram is NULL");
+    }
+    else
+    {
+        if (latency_usec > LATENCY_MAX_USEC)
+        {
+            latency_usec = LATENCY_MAX_USEC;
+        }
+        histogram->buckets[get_bucket_index(latency_usec)]++;
+        histogram->count++;
+        histogram->total_usec += latency_usec;
+        if (latency_usec > histogram->max_usec)
+        {
+            histogram->max_usec = latency_usec;
+        }
+    }
+}
+
+uint32_t latency_stats_get_count(const LATENCY_HISTOGRAM* histogram)
+{
+    uint32_t result;
+    if (histogram == NULL)
+    {
+        log_error("Invalid argument histogram is NULL");
+        result = 0;
+    }
+    else
+    {
+        result = histogram->count;
+    }
+    return result;
+}
+
+uint64_t latency_stats_get_mean(const LATENCY_HISTOGRAM* histogram)
+{
+    uint64_t result;
+    if (histogram == NULL)
+    {
+        log_error("Invalid argument histogram is NULL");
+        result = 0;
+    }
+    else
+    {
+        result = histogram->count == 0 ? 0 : histogram->total_usec/histogram->count;
+    }
+    return result;
+}
+
+uint64_t latency_stats_get_max(const LATENCY_HISTOGRAM* histogram)
+{
+    uint64_t result;
+    if (histogram == NULL)
+    {
+        log_error("Invalid argument histogram is NULL");
+        result = 0;
+    }
+    else
+    {
+        result = histogram->max_usec;
+    }
+    return result;
+}
+
+uint64_t latency_stats_get_percentile(const LATENCY_HISTOGRAM* histogram, uint32_t percentile)
+{
+    uint64_t result = 0;
+    if (histogram == NULL || percentile == 0 || percentile > 100)
+    {
+        log_error("Invalid argument histogram: %p, percentile: %u", histogram, percentile);
+    }
+    else if (histogram->count > 0)
+    {
+        // Rank of the sample that sits at the percentile, rounded up
+        uint64_t rank = ((uint64_t)histogram->count*percentile + 99)/100;
+        uint64_t seen = 0;
+        for (size_t index = 0; index < LATENCY_BUCKET_COUNT; index++)
+        {
+            seen += histogram->buckets[index];
+            if (seen >= rank)
+            {
+                result = get_bucket_upper_bound(index);
+                break;
+            }
+        }
+        // The bucket bound can overshoot the largest sample
+        if (result > histogram->max_usec)
+        {
+            result = histogram->max_usec;
+        }
+    }
+    return result;
+}
+
+void latency_stats_log(const LATENCY_HISTOGRAM* histogram, const char* name)
+{
+    if (histogram == NULL || name == NULL)
+    {
+        log_error("Invalid argument histogram: %p, name: %p", histogram, name);
+    }
+    else
+    {
+        log_info("%s latency: count %" PRIu32 ", mean %" PRIu64 " us, p50 %" PRIu64 " us, p99 %" PRIu64 " us, max %" PRIu64 " us",
+            name, histogram->count, latency_stats_get_mean(histogram), latency_stats_get_percentile(histogram, 50),
+            latency_stats_get_percentile(histogram, 99), histogram->max_usec);
+    }
+}
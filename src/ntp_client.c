@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 
 #ifdef WIN32
@@ -28,7 +29,34 @@
 #define OPERATION_SUCCESSFUL    1
 #define OPERATION_FAILURE       2
 
+#define NTP_MODE_SERVER         4
+#define NTP_LEAP_UNSYNCHRONIZED 3
+#define NTP_MAX_STRATUM         15
+#define MAX_HOSTNAME_LEN        128
+// After the first reply the slower servers get at least this long to answer
+#define MIN_COLLECT_WINDOW_US   20000
+#define NSEC_IN_SECOND          1000000000ll
+
+// The poll interval is 2^exponent seconds, 64 s up to the 36 h cap
+#define POLL_EXPONENT_MIN       6
+#define POLL_EXPONENT_MAX       17
+#define POLL_HISTORY_COUNT      8
+// Steady samples in a row before the interval doubles
+#define POLL_STEADY_SAMPLES     2
+// An offset inside this many jitters is noise and lets the interval grow
+#define POLL_JITTER_GATE        4
+// Offsets below this count as steady however small the jitter is
+#define POLL_STEADY_OFFSET_NS   2000000
+// The clock is far enough off to start over from the shortest interval
+#define POLL_RESET_OFFSET_NS    128000000
+#define RETRY_MIN_SEC           16
+#define RETRY_MAX_SEC           3600
+
 static const unsigned long long NTP_TIMESTAMP_DELTA = 2208988800ull;
+#ifdef WIN32
+// Seconds between the FILETIME epoch (1601) and the NTP epoch (1900)
+static const unsigned long long FILETIME_NTP_DELTA = 9435484800ull;
+#endif
 //static const uint32_t JAN_1ST_1900 = 2415021;
 
 typedef struct SET_TIME_INFO_TAG
@@ -84,104 +112,105 @@ typedef struct NTP_RESP_PACKET_TAG
     NTP_AUTH_INFO ntp_auth_info;
 } NTP_RESP_PACKET;
 
-typedef struct NTP_CLIENT_INFO_TAG
+typedef struct NTP_SERVER_INFO_TAG
 {
-    NTP_TIME_CALLBACK ntp_callback;
-    void* user_ctx;
     CORD_HANDLE socket_impl;
-    size_t timeout_sec;
     bool server_connected;
+    char hostname[MAX_HOSTNAME_LEN];
 
-    NTP_TIME_PACKET recv_packet;
     NTP_CLIENT_STATE ntp_state;
     NTP_OPERATION_RESULT ntp_op_result;
-    ALARM_TIMER_INFO timer_info;
-
-    unsigned char collection_buff[48];
+    bool has_sample;
+    uint64_t send_tick;
+    uint64_t recv_tick;
+    // T1 to T4 of the exchange, all 32.32 fixed point in the NTP era
+    NTP_TIME_PACKET orig_timestamp;
+    NTP_TIME_PACKET recv_timestamp;
+    NTP_TIME_PACKET transmit_timestamp;
+    NTP_TIME_PACKET dest_timestamp;
+    // Signed 32.32 fixed point seconds
+    int64_t offset;
+    int64_t delay;
+
+    unsigned char collection_buff[NTP_PACKET_SIZE];
     size_t collection_size;
+} NTP_SERVER_INFO;
+
+typedef struct NTP_POLL_INFO_TAG
+{
+    int64_t offset_history[POLL_HISTORY_COUNT];
+    size_t history_count;
+    size_t history_index;
+    int64_t jitter_ns;
+    uint32_t steady_count;
+    uint32_t poll_exponent;
+    uint32_t failure_count;
+    uint32_t random_state;
+} NTP_POLL_INFO;
+
+typedef struct NTP_CLIENT_INFO_TAG
+{
+    NTP_TIME_CALLBACK ntp_callback;
+    NTP_OFFSET_CALLBACK offset_callback;
+    void* user_ctx;
+    size_t timeout_sec;
+    bool query_active;
+    // Zero until the first valid reply comes in
+    uint64_t collect_deadline;
+
+    NTP_SERVER_INFO server_list[NTP_CLIENT_MAX_SERVERS];
+    size_t server_count;
+    ALARM_TIMER_INFO timer_info;
+    NTP_POLL_INFO poll_info;
 } NTP_CLIENT_INFO;
 
+// Reads the wall clock as an NTP timestamp with the full fraction resolution
+static void get_ntp_time(NTP_TIME_PACKET* timestamp)
+{
 #ifdef WIN32
-LARGE_INTEGER getFILETIMEoffset()
-{
-    SYSTEMTIME s;
-    FILETIME f;
-    LARGE_INTEGER t;
-
-    s.wYear = 1970;
-    s.wMonth = 1;
-    s.wDay = 1;
-    s.wHour = 0;
-    s.wMinute = 0;
-    s.wSecond = 0;
-    s.wMilliseconds = 0;
-    SystemTimeToFileTime(&s, &f);
-    t.QuadPart = f.dwHighDateTime;
-    t.QuadPart <<= 32;
-    t.QuadPart |= f.dwLowDateTime;
-    return (t);
-}
+    FILETIME file_time;
+    ULARGE_INTEGER ticks;
+    GetSystemTimeAsFileTime(&file_time);
+    ticks.LowPart = file_time.dwLowDateTime;
+    ticks.HighPart = file_time.dwHighDateTime;
+    // FILETIME counts 100 ns intervals
+    timestamp->integer = (uint32_t)(ticks.QuadPart/10000000 - FILETIME_NTP_DELTA);
+    timestamp->fractional = (uint32_t)(((ticks.QuadPart % 10000000) << 32)/10000000);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    timestamp->integer = (uint32_t)(ts.tv_sec + NTP_TIMESTAMP_DELTA);
+    timestamp->fractional = (uint32_t)(((uint64_t)ts.tv_nsec << 32)/1000000000);
 #endif
+}
 
-static uint32_t clock_get_time(void)
+static uint64_t get_tick_us(void)
 {
-    uint32_t result;
 #ifdef WIN32
-    struct timeval ts;
-    LARGE_INTEGER t;
-    FILETIME f;
-    double microseconds;
-    static LARGE_INTEGER offset;
-    static double frequencyToMicroseconds;
-    static int initialized = 0;
-    static BOOL usePerformanceCounter = 0;
-
-    if (!initialized)
-    {
-        LARGE_INTEGER performanceFrequency;
-        initialized = 1;
-        usePerformanceCounter = QueryPerformanceFrequency(&performanceFrequency);
-        if (usePerformanceCounter)
-        {
-            QueryPerformanceCounter(&offset);
-            frequencyToMicroseconds = (double)performanceFrequency.QuadPart / 1000000.;
-        }
-        else
-        {
-            offset = getFILETIMEoffset();
-            frequencyToMicroseconds = 10.;
-        }
-    }
-    if (usePerformanceCounter)
-    {
-        QueryPerformanceCounter(&t);
-    }
-    else
-    {
-        GetSystemTimeAsFileTime(&f);
-        t.QuadPart = f.dwHighDateTime;
-        t.QuadPart <<= 32;
-        t.QuadPart |= f.dwLowDateTime;
-    }
-
-    t.QuadPart -= offset.QuadPart;
-    microseconds = (double)t.QuadPart / frequencyToMicroseconds;
-    t.QuadPart = (LONGLONG)microseconds;
-    ts.tv_sec = (long)(t.QuadPart / 1000000);
-    ts.tv_usec = (long)(t.QuadPart % 1000000);
-    result = (uint32_t)ts.tv_sec * 1000000LL + (uint32_t)ts.tv_usec / 1000LL;
+    return (uint64_t)GetTickCount64()*1000;
 #else
-  struct timespec ts;
-  clock_gettime(CLOCK_REALTIME, &ts);
-  result = (uint32_t)ts.tv_sec * 1000000LL + (uint32_t)ts.tv_nsec / 1000LL;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000 + (uint64_t)ts.tv_nsec/1000;
 #endif
-  return result;
+}
+
+static uint64_t get_ntp_value(const NTP_TIME_PACKET* timestamp)
+{
+    return ((uint64_t)timestamp->integer << 32) | timestamp->fractional;
+}
+
+static void get_timespec(int64_t ntp_value, struct timespec* result)
+{
+    // The shift floors, which keeps tv_nsec positive for negative values
+    result->tv_sec = (time_t)(ntp_value >> 32);
+    result->tv_nsec = (long)(((uint64_t)(ntp_value & 0xFFFFFFFF)*1000000000) >> 32);
 }
 
 static void on_socket_open_complete(void* context, IO_OPEN_RESULT open_result)
 {
-    NTP_CLIENT_INFO* ntp_client = (NTP_CLIENT_INFO*)context;
-    if (ntp_client == NULL)
+    NTP_SERVER_INFO* ntp_server = (NTP_SERVER_INFO*)context;
+    if (ntp_server == NULL)
     {
         log_error("Invalid context specified");
     }
@@ -189,100 +218,142 @@ static void on_socket_open_complete(void* context, IO_OPEN_RESULT open_result)
     {
         if (open_result == IO_OPEN_OK)
         {
-            ntp_client->server_connected = true;
-            ntp_client->ntp_state = NTP_CLIENT_STATE_CONNECTED;
+            ntp_server->server_connected = true;
+            ntp_server->ntp_state = NTP_CLIENT_STATE_CONNECTED;
         }
         else
         {
-            ntp_client->ntp_state = NTP_CLIENT_STATE_ERROR;
-            ntp_client->ntp_op_result = NTP_OP_RESULT_COMM_ERR;
+            ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+            ntp_server->ntp_op_result = NTP_OP_RESULT_COMM_ERR;
             log_error("socket open failed");
         }
     }
 }
 
+static bool is_valid_response(const NTP_BASIC_INFO* ntp_info)
+{
+    bool result;
+    uint8_t leap_indicator = ntp_info->li_vn_mode >> 6;
+    // Unsynchronized servers and kiss-o'-death replies (stratum 0) carry no usable time
+    if ((ntp_info->li_vn_mode & 0x07) != NTP_MODE_SERVER || leap_indicator == NTP_LEAP_UNSYNCHRONIZED ||
+        ntp_info->stratum == 0 || ntp_info->stratum > NTP_MAX_STRATUM || ntp_info->ntp_transmit_timestamp.integer == 0)
+    {
+        log_warning("Discarding NTP reply mode: %d, leap: %d, stratum: %d", ntp_info->li_vn_mode & 0x07, leap_indicator, ntp_info->stratum);
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+    return result;
+}
+
 static void on_socket_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
-    NTP_CLIENT_INFO* ntp_client = (NTP_CLIENT_INFO*)context;
-    if (ntp_client == NULL)
+    NTP_SERVER_INFO* ntp_server = (NTP_SERVER_INFO*)context;
+    if (ntp_server == NULL)
     {
         log_error("Invalid context specified");
     }
     else
     {
-        //NTP_RESP_PACKET resp_packet;
-        if (ntp_client->collection_size+size > NTP_PACKET_SIZE)
+        // Take the arrival time before anything else so parsing is not part of the delay
+        uint64_t recv_tick = get_tick_us();
+        NTP_TIME_PACKET dest_timestamp;
+        get_ntp_time(&dest_timestamp);
+        if (ntp_server->collection_size+size > NTP_PACKET_SIZE)
         {
             log_error("Recieving packet size too large");
-            ntp_client->ntp_state = NTP_CLIENT_STATE_ERROR;
-            ntp_client->collection_size = 0;
+            ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+            ntp_server->ntp_op_result = NTP_OP_RESULT_INVALID_DATA_ERR;
+            ntp_server->collection_size = 0;
         }
         else
         {
-            memcpy(ntp_client->collection_buff, buffer, size);
-            ntp_client->collection_size += size;
+            memcpy(ntp_server->collection_buff + ntp_server->collection_size, buffer, size);
+            ntp_server->collection_size += size;
         }
 
-        if (ntp_client->collection_size == sizeof(NTP_BASIC_INFO) )
+        if (ntp_server->collection_size == sizeof(NTP_BASIC_INFO) )
         {
-            NTP_BASIC_INFO* ntp_info = (NTP_BASIC_INFO*)buffer;
-
-            log_debug("Leap Indicator: %d", ntp_info->li_vn_mode&0x11000000);
+            NTP_BASIC_INFO ntp_info;
+            memcpy(&ntp_info, ntp_server->collection_buff, sizeof(NTP_BASIC_INFO));
 
-            // These two fields contain the time-stamp seconds as the packet left the NTP server.
-            // The number of seconds correspond to the seconds passed since 1900.
-            // ntohl() converts the bit/byte order from the network's to host's "endianness".
-            ntp_client->recv_packet.integer = ntohl(ntp_info->ntp_transmit_timestamp.integer);
-            ntp_client->recv_packet.fractional = ntohl(ntp_info->ntp_transmit_timestamp.fractional);
-            ntp_client->ntp_state = NTP_CLIENT_STATE_RECV;
-
-            log_debug("NTP values: integer value: %u, fraction value: %u", ntp_client->recv_packet.integer, ntp_client->recv_packet.fractional);
+            if (!is_valid_response(&ntp_info))
+            {
+                ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+                ntp_server->ntp_op_result = NTP_OP_RESULT_INVALID_DATA_ERR;
+            }
+            // The server echoes our transmit time, anything else is a stale or forged reply
+            else if (ntohl(ntp_info.ntp_orig_timestamp.integer) != ntp_server->orig_timestamp.integer ||
+                ntohl(ntp_info.ntp_orig_timestamp.fractional) != ntp_server->orig_timestamp.fractional)
+            {
+                log_warning("Discarding NTP reply that does not match the request");
+                ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+                ntp_server->ntp_op_result = NTP_OP_RESULT_INVALID_DATA_ERR;
+            }
+            else
+            {
+                // These fields contain the time-stamp seconds as the packet reached and left the NTP server.
+                // The number of seconds correspond to the seconds passed since 1900.
+                // ntohl() converts the bit/byte order from the network's to host's "endianness".
+                ntp_server->recv_timestamp.integer = ntohl(ntp_info.ntp_recv_timestamp.integer);
+                ntp_server->recv_timestamp.fractional = ntohl(ntp_info.ntp_recv_timestamp.fractional);
+                ntp_server->transmit_timestamp.integer = ntohl(ntp_info.ntp_transmit_timestamp.integer);
+                ntp_server->transmit_timestamp.fractional = ntohl(ntp_info.ntp_transmit_timestamp.fractional);
+                ntp_server->dest_timestamp = dest_timestamp;
+                ntp_server->recv_tick = recv_tick;
+                ntp_server->ntp_state = NTP_CLIENT_STATE_RECV;
+
+                log_debug("NTP values: integer value: %u, fraction value: %u", ntp_server->transmit_timestamp.integer, ntp_server->transmit_timestamp.fractional);
+            }
         }
     }
 }
 
 static void on_socket_error(void* context, IO_ERROR_RESULT error_result)
 {
-    NTP_CLIENT_INFO* ntp_client = (NTP_CLIENT_INFO*)context;
-    if (ntp_client == NULL)
+    NTP_SERVER_INFO* ntp_server = (NTP_SERVER_INFO*)context;
+    if (ntp_server == NULL)
     {
         log_error("Invalid context specified");
     }
     else
     {
         (void)error_result;
-        ntp_client->ntp_state = NTP_CLIENT_STATE_ERROR;
-        ntp_client->ntp_op_result = NTP_OP_RESULT_COMM_ERR;
+        ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+        ntp_server->ntp_op_result = NTP_OP_RESULT_COMM_ERR;
     }
 }
 
 static void on_connection_closed(void* context)
 {
-    NTP_CLIENT_INFO* ntp_client = (NTP_CLIENT_INFO*)context;
-    if (ntp_client == NULL)
+    NTP_SERVER_INFO* ntp_server = (NTP_SERVER_INFO*)context;
+    if (ntp_server == NULL)
     {
         log_error("Invalid context specified");
     }
     else
     {
-        ntp_client->server_connected = false;
+        ntp_server->server_connected = false;
     }
 }
 
-static int send_initial_ntp_packet(NTP_CLIENT_INFO* ntp_client)
+static int send_initial_ntp_packet(NTP_SERVER_INFO* ntp_server)
 {
     int result;
     NTP_BASIC_INFO ntp_info;
     size_t ntp_len = sizeof(NTP_BASIC_INFO);
     memset(&ntp_info, 0, ntp_len);
 
-    ntp_info.li_vn_mode = 0x1B; // Last min is 59, version 4, mode reserved
-    ntp_info.ntp_orig_timestamp.integer = (uint32_t)time(NULL);
-    ntp_info.ntp_orig_timestamp.fractional = clock_get_time();
-    //ntp_info.ntp_transmit_timestamp.integer = ntp_info.ntp_orig_timestamp.integer;
-    //ntp_info.ntp_transmit_timestamp.fractional = ntp_info.ntp_orig_timestamp.fractional;
+    ntp_info.li_vn_mode = 0x23; // No leap warning, version 4, client mode
+    // T1 goes out as the transmit time and comes back as the originate time
+    get_ntp_time(&ntp_server->orig_timestamp);
+    ntp_info.ntp_transmit_timestamp.integer = htonl(ntp_server->orig_timestamp.integer);
+    ntp_info.ntp_transmit_timestamp.fractional = htonl(ntp_server->orig_timestamp.fractional);
 
-    if (cord_socket_send(ntp_client->socket_impl, &ntp_info, ntp_len, NULL, NULL) != 0)
+    ntp_server->send_tick = get_tick_us();
+    if (cord_socket_send(ntp_server->socket_impl, &ntp_info, ntp_len, NULL, NULL) != 0)
     {
         log_error("Failure sending NTP packet to server");
         result = MU_FAILURE;
@@ -294,29 +365,65 @@ static int send_initial_ntp_packet(NTP_CLIENT_INFO* ntp_client)
     return result;
 }
 
-static int init_connect_to_server(NTP_CLIENT_INFO* ntp_client, const char* time_server)
+// Servers may be given as host:port, which lets a local responder run on
+// an unprivileged port
+static int parse_server_address(NTP_SERVER_INFO* ntp_server, const char* time_server, SOCKETIO_CONFIG* socket_config)
+{
+    int result;
+    const char* port_sep = strrchr(time_server, ':');
+    // More than one colon is an IPv6 address without a port
+    if (port_sep == NULL || strchr(time_server, ':') != port_sep)
+    {
+        socket_config->hostname = time_server;
+        socket_config->port = NTP_PORT_NUM;
+        result = 0;
+    }
+    else
+    {
+        size_t host_len = (size_t)(port_sep - time_server);
+        long port = strtol(port_sep + 1, NULL, 10);
+        if (host_len == 0 || host_len >= MAX_HOSTNAME_LEN || port <= 0 || port > 65535)
+        {
+            log_error("Invalid NTP server address %s", time_server);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            memcpy(ntp_server->hostname, time_server, host_len);
+            ntp_server->hostname[host_len] = '\0';
+            socket_config->hostname = ntp_server->hostname;
+            socket_config->port = (int)port;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int init_connect_to_server(NTP_SERVER_INFO* ntp_server, const char* time_server)
 {
     int result;
     PATCHCORD_CALLBACK_INFO patch_info;
     patch_info.on_bytes_received = on_socket_bytes_received;
     patch_info.on_client_close = on_connection_closed;
     patch_info.on_io_error = on_socket_error;
-    patch_info.on_bytes_received_ctx = patch_info.on_close_ctx = patch_info.on_io_error_ctx = ntp_client;
+    patch_info.on_bytes_received_ctx = patch_info.on_close_ctx = patch_info.on_io_error_ctx = ntp_server;
 
     SOCKETIO_CONFIG socket_config = {0};
-    socket_config.hostname = time_server;
-    socket_config.port = NTP_PORT_NUM;
     socket_config.address_type = ADDRESS_TYPE_UDP;
-    if ((ntp_client->socket_impl = cord_socket_create(&socket_config, &patch_info)) == NULL)
+    if (parse_server_address(ntp_server, time_server, &socket_config) != 0)
     {
-        log_error("Error connecting to NTP server %s:%d", time_server, NTP_PORT_NUM);
         result = MU_FAILURE;
     }
-    else if (cord_socket_open(ntp_client->socket_impl, on_socket_open_complete, ntp_client) != 0)
+    else if ((ntp_server->socket_impl = cord_socket_create(&socket_config, &patch_info)) == NULL)
+    {
+        log_error("Error connecting to NTP server %s:%d", socket_config.hostname, socket_config.port);
+        result = MU_FAILURE;
+    }
+    else if (cord_socket_open(ntp_server->socket_impl, on_socket_open_complete, ntp_server) != 0)
     {
         log_error("Error opening socket IO.");
-        cord_socket_destroy(ntp_client->socket_impl);
-        ntp_client->socket_impl = NULL;
+        cord_socket_destroy(ntp_server->socket_impl);
+        ntp_server->socket_impl = NULL;
         result = MU_FAILURE;
     }
     else
@@ -326,27 +433,35 @@ static int init_connect_to_server(NTP_CLIENT_INFO* ntp_client, const char* time_
     return result;
 }
 
-static void close_ntp_connection(NTP_CLIENT_INFO* ntp_client)
+static void close_ntp_connection(NTP_SERVER_INFO* ntp_server)
 {
-    if (ntp_client->server_connected)
+    if (ntp_server->server_connected)
     {
-        if (cord_socket_close(ntp_client->socket_impl, on_connection_closed, ntp_client) == 0)
+        if (cord_socket_close(ntp_server->socket_impl, on_connection_closed, ntp_server) == 0)
         {
             size_t counter = 0;
             do
             {
-                cord_socket_process_item(ntp_client->socket_impl);
+                cord_socket_process_item(ntp_server->socket_impl);
                 counter++;
                 //ThreadAPI_Sleep(2);
-            } while (ntp_client->server_connected && counter < MAX_CLOSE_RETRIES);
-            ntp_client->server_connected = false;
+            } while (ntp_server->server_connected && counter < MAX_CLOSE_RETRIES);
+            ntp_server->server_connected = false;
         }
     }
     // Close client
-    if (ntp_client->socket_impl)
+    if (ntp_server->socket_impl)
+    {
+        cord_socket_destroy(ntp_server->socket_impl);
+        ntp_server->socket_impl = NULL;
+    }
+}
+
+static void close_all_connections(NTP_CLIENT_INFO* ntp_client)
+{
+    for (size_t index = 0; index < ntp_client->server_count; index++)
     {
-        cord_socket_destroy(ntp_client->socket_impl);
-        ntp_client->socket_impl = NULL;
+        close_ntp_connection(&ntp_client->server_list[index]);
     }
 }
 
@@ -360,6 +475,165 @@ static bool is_timed_out(NTP_CLIENT_INFO* ntp_client)
     return result;
 }
 
+static void record_sample(NTP_CLIENT_INFO* ntp_client, NTP_SERVER_INFO* ntp_server)
+{
+    int64_t round_trip = (int64_t)(ntp_server->recv_tick - ntp_server->send_tick);
+    uint64_t orig_time = get_ntp_value(&ntp_server->orig_timestamp);
+    uint64_t recv_time = get_ntp_value(&ntp_server->recv_timestamp);
+    uint64_t transmit_time = get_ntp_value(&ntp_server->transmit_timestamp);
+    uint64_t dest_time = get_ntp_value(&ntp_server->dest_timestamp);
+
+    // Differences are taken unsigned first so they stay right across an era
+    // rollover. delay = (T4 - T1) - (T3 - T2), offset = ((T2 - T1) + (T3 - T4))/2
+    ntp_server->delay = (int64_t)(dest_time - orig_time) - (int64_t)(transmit_time - recv_time);
+    ntp_server->offset = (int64_t)(recv_time - orig_time)/2 + (int64_t)(transmit_time - dest_time)/2;
+    // Clock resolution can push a loopback exchange just below zero
+    if (ntp_server->delay < 0)
+    {
+        ntp_server->delay = 0;
+    }
+    ntp_server->has_sample = true;
+
+    if (ntp_client->collect_deadline == 0)
+    {
+        // A server that answers after this went through a path at least
+        // twice as slow as the first one, it will not be the best sample
+        ntp_client->collect_deadline = ntp_server->recv_tick + (round_trip > MIN_COLLECT_WINDOW_US ? (uint64_t)round_trip : MIN_COLLECT_WINDOW_US);
+    }
+    log_debug("NTP sample: round trip %lld us, delay %.3f ms, offset %.3f ms", (long long)round_trip,
+        ntp_server->delay/4294967296.0*1000.0, ntp_server->offset/4294967296.0*1000.0);
+}
+
+static uint32_t get_poll_random(NTP_POLL_INFO* poll_info)
+{
+    // xorshift32, only spreads clients out so it does not need to be strong
+    uint32_t result = poll_info->random_state;
+    result ^= result << 13;
+    result ^= result >> 17;
+    result ^= result << 5;
+    poll_info->random_state = result;
+    return result;
+}
+
+static void update_poll_jitter(NTP_POLL_INFO* poll_info)
+{
+    // Mean change between successive offsets, what the clock wanders by
+    // from one sample to the next
+    int64_t sum = 0;
+    for (size_t index = 1; index < poll_info->history_count; index++)
+    {
+        size_t current = (poll_info->history_index + POLL_HISTORY_COUNT - index) % POLL_HISTORY_COUNT;
+        size_t previous = (current + POLL_HISTORY_COUNT - 1) % POLL_HISTORY_COUNT;
+        int64_t diff = poll_info->offset_history[current] - poll_info->offset_history[previous];
+        sum += diff < 0 ? -diff : diff;
+    }
+    poll_info->jitter_ns = poll_info->history_count > 1 ? sum/(int64_t)(poll_info->history_count - 1) : 0;
+}
+
+static void record_poll_sample(NTP_POLL_INFO* poll_info, int64_t offset_ns)
+{
+    int64_t abs_offset = offset_ns < 0 ? -offset_ns : offset_ns;
+    int64_t steady_offset = poll_info->jitter_ns*POLL_JITTER_GATE;
+    if (steady_offset < POLL_STEADY_OFFSET_NS)
+    {
+        steady_offset = POLL_STEADY_OFFSET_NS;
+    }
+    poll_info->failure_count = 0;
+
+    if (abs_offset > POLL_RESET_OFFSET_NS)
+    {
+        // The clock gets stepped or slewed a long way, the history no longer
+        // describes it
+        poll_info->history_count = 0;
+        poll_info->jitter_ns = 0;
+        poll_info->steady_count = 0;
+        poll_info->poll_exponent = POLL_EXPONENT_MIN;
+    }
+    else
+    {
+        if (abs_offset <= steady_offset)
+        {
+            if (++poll_info->steady_count >= POLL_STEADY_SAMPLES && poll_info->poll_exponent < POLL_EXPONENT_MAX)
+            {
+                poll_info->poll_exponent++;
+                poll_info->steady_count = 0;
+            }
+        }
+        else
+        {
+            poll_info->steady_count = 0;
+            if (poll_info->poll_exponent > POLL_EXPONENT_MIN)
+            {
+                poll_info->poll_exponent--;
+            }
+        }
+        poll_info->offset_history[poll_info->history_index] = offset_ns;
+        poll_info->history_index = (poll_info->history_index + 1) % POLL_HISTORY_COUNT;
+        if (poll_info->history_count < POLL_HISTORY_COUNT)
+        {
+            poll_info->history_count++;
+        }
+        update_poll_jitter(poll_info);
+    }
+    log_debug("NTP poll exponent %u, jitter %lld us", poll_info->poll_exponent, (long long)(poll_info->jitter_ns/1000));
+}
+
+static void complete_time_query(NTP_CLIENT_INFO* ntp_client)
+{
+    NTP_SERVER_INFO* best_server = NULL;
+    NTP_OPERATION_RESULT op_result = NTP_OP_RESULT_TIMEOUT;
+    for (size_t index = 0; index < ntp_client->server_count; index++)
+    {
+        NTP_SERVER_INFO* ntp_server = &ntp_client->server_list[index];
+        if (ntp_server->has_sample)
+        {
+            // The reply with the least delay has the least room for asymmetric paths
+            if (best_server == NULL || ntp_server->delay < best_server->delay)
+            {
+                best_server = ntp_server;
+            }
+        }
+        else if (ntp_server->ntp_state == NTP_CLIENT_STATE_COMPLETE)
+        {
+            op_result = ntp_server->ntp_op_result;
+        }
+    }
+    close_all_connections(ntp_client);
+    ntp_client->query_active = false;
+
+    if (best_server != NULL)
+    {
+        struct timespec offset;
+        struct timespec delay;
+        get_timespec(best_server->offset, &offset);
+        get_timespec(best_server->delay, &delay);
+        record_poll_sample(&ntp_client->poll_info, (int64_t)offset.tv_sec*NSEC_IN_SECOND + offset.tv_nsec);
+        if (ntp_client->offset_callback != NULL)
+        {
+            ntp_client->offset_callback(ntp_client->user_ctx, NTP_OP_RESULT_SUCCESS, &offset, &delay);
+        }
+        else
+        {
+            // Server time at the moment the reply arrived
+            uint64_t server_time = get_ntp_value(&best_server->dest_timestamp) + (uint64_t)best_server->offset;
+            time_t recv_time = (time_t)((server_time >> 32) - NTP_TIMESTAMP_DELTA);
+            ntp_client->ntp_callback(ntp_client->user_ctx, NTP_OP_RESULT_SUCCESS, recv_time);
+        }
+    }
+    else
+    {
+        ntp_client->poll_info.failure_count++;
+        if (ntp_client->offset_callback != NULL)
+        {
+            ntp_client->offset_callback(ntp_client->user_ctx, op_result, NULL, NULL);
+        }
+        else
+        {
+            ntp_client->ntp_callback(ntp_client->user_ctx, op_result, (time_t)0);
+        }
+    }
+}
+
 static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result, time_t current_time)
 {
     SET_TIME_INFO* set_time_info = (SET_TIME_INFO*)user_ctx;
@@ -377,6 +651,62 @@ static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result,
     }
 }
 
+static int start_time_query(NTP_CLIENT_INFO* ntp_client, const char** server_list, size_t server_count, size_t timeout_sec)
+{
+    int result;
+    if (ntp_client->query_active)
+    {
+        log_error("NTP time query already in progress");
+        result = __LINE__;
+    }
+    else
+    {
+        // Every server is asked at once, a server that cannot be reached
+        // only removes its sample from the choice
+        memset(ntp_client->server_list, 0, sizeof(ntp_client->server_list));
+        ntp_client->server_count = 0;
+        ntp_client->collect_deadline = 0;
+        for (size_t index = 0; index < server_count; index++)
+        {
+            NTP_SERVER_INFO* ntp_server = &ntp_client->server_list[ntp_client->server_count];
+            if (server_list[index] == NULL)
+            {
+                log_error("Invalid NTP server at index %zu", index);
+            }
+            else if (init_connect_to_server(ntp_server, server_list[index]) != 0)
+            {
+                log_warning("Failure initializing connection to ntp server %s.", server_list[index]);
+            }
+            else
+            {
+                ntp_server->ntp_state = NTP_CLIENT_STATE_IDLE;
+                ntp_client->server_count++;
+            }
+        }
+
+        if (ntp_client->server_count == 0)
+        {
+            log_error("Failure initializing connection to ntp server.");
+            ntp_client->poll_info.failure_count++;
+            result = __LINE__;
+        }
+        else if (timeout_sec > 0 && alarm_timer_start(&ntp_client->timer_info, timeout_sec) != 0)
+        {
+            log_error("Failure starting timer alarm.");
+            close_all_connections(ntp_client);
+            ntp_client->server_count = 0;
+            result = __LINE__;
+        }
+        else
+        {
+            ntp_client->timeout_sec = timeout_sec;
+            ntp_client->query_active = true;
+            result = 0;
+        }
+    }
+    return result;
+}
+
 NTP_CLIENT_HANDLE ntp_client_create(void)
 {
     NTP_CLIENT_INFO* result;
@@ -394,7 +724,12 @@ NTP_CLIENT_HANDLE ntp_client_create(void)
         }
         else
         {
-            result->ntp_state = NTP_CLIENT_STATE_IDLE;
+            NTP_TIME_PACKET now;
+            get_ntp_time(&now);
+            result->poll_info.poll_exponent = POLL_EXPONENT_MIN;
+            // Clocks that boot together still need different seeds, 0 would
+            // stall the generator
+            result->poll_info.random_state = (now.fractional ^ (uint32_t)get_tick_us()) | 1;
         }
     }
     return result;
@@ -404,7 +739,7 @@ void ntp_client_destroy(NTP_CLIENT_HANDLE handle)
 {
     if (handle != NULL)
     {
-        close_ntp_connection(handle);
+        close_all_connections(handle);
         free(handle);
     }
 }
@@ -417,76 +752,138 @@ int ntp_client_get_time(NTP_CLIENT_HANDLE handle, const char* time_server, size_
         log_error("Invalid parameter specified handle: %p, time_server: %p, ntp_callback: %p.", handle, time_server, ntp_callback);
         result = __LINE__;
     }
-    else if (init_connect_to_server(handle, time_server) != 0)
+    else
     {
-        log_error("Failure initializing connection to ntp server.");
-        result = __LINE__;
+        result = ntp_client_get_time_multi(handle, &time_server, 1, timeout_sec, ntp_callback, user_ctx);
     }
-    else if (timeout_sec > 0 && alarm_timer_start(&handle->timer_info, timeout_sec) != 0)
+    return result;
+}
+
+int ntp_client_get_time_multi(NTP_CLIENT_HANDLE handle, const char** server_list, size_t server_count, size_t timeout_sec, NTP_TIME_CALLBACK ntp_callback, void* user_ctx)
+{
+    int result;
+    if (handle == NULL || server_list == NULL || server_count == 0 || server_count > NTP_CLIENT_MAX_SERVERS || ntp_callback == NULL)
     {
-        log_error("Failure starting timer alarm.");
-        close_ntp_connection(handle);
+        log_error("Invalid parameter specified handle: %p, server_list: %p, server_count: %zu, ntp_callback: %p.", handle, server_list, server_count, ntp_callback);
         result = __LINE__;
     }
-    else
+    else if ((result = start_time_query(handle, server_list, server_count, timeout_sec)) == 0)
     {
-        handle->timeout_sec = timeout_sec;
         handle->ntp_callback = ntp_callback;
+        handle->offset_callback = NULL;
         handle->user_ctx = user_ctx;
-        result = 0;
     }
     return result;
 }
 
-void ntp_client_process(NTP_CLIENT_HANDLE handle)
+int ntp_client_get_offset(NTP_CLIENT_HANDLE handle, const char** server_list, size_t server_count, size_t timeout_sec, NTP_OFFSET_CALLBACK offset_callback, void* user_ctx)
 {
-    if (handle != NULL)
+    int result;
+    if (handle == NULL || server_list == NULL || server_count == 0 || server_count > NTP_CLIENT_MAX_SERVERS || offset_callback == NULL)
     {
-        cord_socket_process_item(handle->socket_impl);
+        log_error("Invalid parameter specified handle: %p, server_list: %p, server_count: %zu, offset_callback: %p.", handle, server_list, server_count, offset_callback);
+        result = __LINE__;
+    }
+    else if ((result = start_time_query(handle, server_list, server_count, timeout_sec)) == 0)
+    {
+        handle->ntp_callback = NULL;
+        handle->offset_callback = offset_callback;
+        handle->user_ctx = user_ctx;
+    }
+    return result;
+}
 
-        // Check timeout here
-        if (handle->server_connected)
+size_t ntp_client_get_poll_interval(NTP_CLIENT_HANDLE handle)
+{
+    size_t result;
+    if (handle == NULL)
+    {
+        log_error("Invalid parameter specified handle: NULL");
+        result = NTP_CLIENT_MIN_POLL_SEC;
+    }
+    else if (handle->poll_info.failure_count > 0)
+    {
+        uint32_t shift = handle->poll_info.failure_count - 1;
+        size_t retry_sec = shift < 8 ? (size_t)RETRY_MIN_SEC << shift : RETRY_MAX_SEC;
+        if (retry_sec > RETRY_MAX_SEC)
         {
-            switch (handle->ntp_state)
+            retry_sec = RETRY_MAX_SEC;
+        }
+        // Anywhere in the upper half, so a fleet that lost its server at the
+        // same moment does not come back in step
+        result = retry_sec/2 + get_poll_random(&handle->poll_info) % (retry_sec/2 + 1);
+    }
+    else
+    {
+        result = (size_t)1 << handle->poll_info.poll_exponent;
+        // Up to an eighth more keeps clocks that started together apart
+        result += get_poll_random(&handle->poll_info) % (result/8 + 1);
+        if (result > NTP_CLIENT_MAX_POLL_SEC)
+        {
+            result = NTP_CLIENT_MAX_POLL_SEC;
+        }
+    }
+    return result;
+}
+
+void ntp_client_process(NTP_CLIENT_HANDLE handle)
+{
+    if (handle != NULL && handle->query_active)
+    {
+        size_t pending_count = 0;
+        for (size_t index = 0; index < handle->server_count; index++)
+        {
+            NTP_SERVER_INFO* ntp_server = &handle->server_list[index];
+            if (ntp_server->socket_impl != NULL)
+            {
+                cord_socket_process_item(ntp_server->socket_impl);
+            }
+
+            switch (ntp_server->ntp_state)
             {
                 case NTP_CLIENT_STATE_CONNECTED:
                     // Send the NTP packet
-                    if (send_initial_ntp_packet(handle) != 0)
+                    if (send_initial_ntp_packet(ntp_server) != 0)
                     {
-                        handle->ntp_state = NTP_CLIENT_STATE_ERROR;
+                        ntp_server->ntp_state = NTP_CLIENT_STATE_ERROR;
+                        ntp_server->ntp_op_result = NTP_OP_RESULT_COMM_ERR;
+                        pending_count++;
                     }
                     else
                     {
                         log_debug("NTP Client: Packet sent");
-                        handle->ntp_state = NTP_CLIENT_STATE_SENT;
+                        ntp_server->ntp_state = NTP_CLIENT_STATE_SENT;
                         alarm_timer_reset(&handle->timer_info);
+                        pending_count++;
                     }
                     break;
                 case NTP_CLIENT_STATE_RECV:
+                    record_sample(handle, ntp_server);
+                    close_ntp_connection(ntp_server);
+                    ntp_server->ntp_state = NTP_CLIENT_STATE_COMPLETE;
+                    break;
                 case NTP_CLIENT_STATE_ERROR:
-                {
-                    time_t recv_time = (time_t)(handle->recv_packet.integer - NTP_TIMESTAMP_DELTA);
-                    handle->ntp_callback(handle->user_ctx, handle->ntp_op_result, recv_time);
-                    close_ntp_connection(handle);
-                    handle->ntp_state = NTP_CLIENT_STATE_COMPLETE;
+                    close_ntp_connection(ntp_server);
+                    ntp_server->ntp_state = NTP_CLIENT_STATE_COMPLETE;
                     break;
-                }
-                case NTP_CLIENT_STATE_SENT:
                 case NTP_CLIENT_STATE_IDLE:
+                case NTP_CLIENT_STATE_SENT:
+                    pending_count++;
+                    break;
                 case NTP_CLIENT_STATE_COMPLETE:
                 default:
                     break;
             }
         }
-        else
+
+        if (pending_count == 0 || (handle->collect_deadline != 0 && get_tick_us() >= handle->collect_deadline))
         {
-            // test if the connection has timed out
-            if (handle->ntp_state == NTP_CLIENT_STATE_IDLE && is_timed_out(handle) )
-            {
-                handle->ntp_state = NTP_CLIENT_STATE_ERROR;
-                handle->ntp_op_result = NTP_OP_RESULT_TIMEOUT;
-                handle->ntp_callback(handle->user_ctx, handle->ntp_op_result, (time_t)0);
-            }
+            complete_time_query(handle);
+        }
+        // test if the operation has timed out
+        else if (is_timed_out(handle))
+        {
+            complete_time_query(handle);
         }
     }
 }
@@ -0,0 +1,179 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "lib-util-c/sys_debug_shim.h"
+#include "lib-util-c/app_logging.h"
+
+#include "event_loop.h"
+
+#define MAX_WAIT_EVENTS         8
+
+typedef struct EVENT_LOOP_INFO_TAG
+{
+    int epoll_fd;
+    int timer_fd;
+} EVENT_LOOP_INFO;
+
+static int add_epoll_fd(EVENT_LOOP_INFO* event_loop, int fd)
+{
+    int result;
+    struct epoll_event event = {0};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        log_error("Failure adding fd %d to epoll: %d", fd, errno);
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static int arm_wake_timer(EVENT_LOOP_INFO* event_loop, time_t wake_time)
+{
+    int result;
+    struct itimerspec timer_value = {0};
+    // Absolute realtime expiry so a clock change cannot stretch the sleep, and
+    // TFD_TIMER_CANCEL_ON_SET wakes the loop as soon as the clock is set
+    timer_value.it_value.tv_sec = wake_time;
+    if (timerfd_settime(event_loop->timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &timer_value, NULL) != 0)
+    {
+        log_error("Failure arming the wake timer: %d", errno);
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+EVENT_LOOP_HANDLE event_loop_create(void)
+{
+    EVENT_LOOP_INFO* result;
+    if ((result = (EVENT_LOOP_INFO*)malloc(sizeof(EVENT_LOOP_INFO))) == NULL)
+    {
+        log_error("Failure allocating event loop");
+    }
+    else if ((result->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        log_error("Failure creating epoll instance: %d", errno);
+        free(result);
+        result = NULL;
+    }
+    else if ((result->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+    {
+        log_error("Failure creating wake timer: %d", errno);
+        (void)close(result->epoll_fd);
+        free(result);
+        result = NULL;
+    }
+    else if (add_epoll_fd(result, result->timer_fd) != 0)
+    {
+        log_error("Failure adding wake timer to the event loop");
+        (void)close(result->timer_fd);
+        (void)close(result->epoll_fd);
+        free(result);
+        result = NULL;
+    }
+    return result;
+}
+
+void event_loop_destroy(EVENT_LOOP_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        (void)close(handle->timer_fd);
+        (void)close(handle->epoll_fd);
+        free(handle);
+    }
+}
+
+int event_loop_add_fd(EVENT_LOOP_HANDLE handle, int fd)
+{
+    int result;
+    if (handle == NULL || fd < 0)
+    {
+        log_error("Invalid argument handle: %p, fd: %d", handle, fd);
+        result = __LINE__;
+    }
+    else
+    {
+        result = add_epoll_fd(handle, fd);
+    }
+    return result;
+}
+
+int event_loop_remove_fd(EVENT_LOOP_HANDLE handle, int fd)
+{
+    int result;
+    if (handle == NULL || fd < 0)
+    {
+        log_error("Invalid argument handle: %p, fd: %d", handle, fd);
+        result = __LINE__;
+    }
+    else if (epoll_ctl(handle->epoll_fd, EPOLL_CTL_DEL, fd, NULL) != 0)
+    {
+        log_error("Failure removing fd %d from epoll: %d", fd, errno);
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+int event_loop_wait(EVENT_LOOP_HANDLE handle, time_t wake_time, size_t max_wait_ms)
+{
+    int result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument handle is NULL");
+        result = __LINE__;
+    }
+    else if (arm_wake_timer(handle, wake_time) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        struct epoll_event event_list[MAX_WAIT_EVENTS];
+        int timeout = max_wait_ms >= INT_MAX ? -1 : (int)max_wait_ms;
+        int event_count = epoll_wait(handle->epoll_fd, event_list, MAX_WAIT_EVENTS, timeout);
+        if (event_count < 0 && errno != EINTR)
+        {
+            log_error("Failure waiting on the event loop: %d", errno);
+            result = __LINE__;
+        }
+        else
+        {
+            for (int index = 0; index < event_count; index++)
+            {
+                if (event_list[index].data.fd == handle->timer_fd)
+                {
+                    // Drain the expiration count, this fails with ECANCELED
+                    // after a clock change which is just another wake up
+                    uint64_t expirations;
+                    if (read(handle->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != ECANCELED && errno != EAGAIN)
+                    {
+                        log_error("Failure reading the wake timer: %d", errno);
+                    }
+                }
+            }
+            result = 0;
+        }
+    }
+    return result;
+}
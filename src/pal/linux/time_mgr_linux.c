@@ -1,19 +1,145 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/timex.h>
 
 #include "lib-util-c/app_logging.h"
 
 #include "time_mgr.h"
 
+#define NSEC_IN_SECOND          1000000000ll
+// Offsets up to this are slewed, anything larger steps the clock
+#define MAX_SLEW_OFFSET_NS      500000000ll
+// Samples closer together than this mostly measure network jitter
+#define MIN_DRIFT_INTERVAL_SEC  60
+// Share of the measured drift taken into the frequency on each sample
+#define DRIFT_GAIN              0.5
+// The kernel refuses frequency corrections beyond 500 ppm
+#define MAX_FREQUENCY_PPM       500.0
+// adjtimex frequencies are ppm with a 16 bit fraction
+#define FREQUENCY_SCALE         65536.0
+
+typedef struct CLOCK_DISCIPLINE_TAG
+{
+    bool initialized;
+    bool has_sample;
+    // Monotonic time of the last sample, the corrections do not move it
+    struct timespec sample_time;
+    double frequency_ppm;
+} CLOCK_DISCIPLINE;
+
+static CLOCK_DISCIPLINE g_discipline;
+
+static int64_t get_timespec_ns(const struct timespec* value)
+{
+    return (int64_t)value->tv_sec*NSEC_IN_SECOND + value->tv_nsec;
+}
+
+static double get_frequency_ppm(void)
+{
+    double result = 0.0;
+#if PRODUCTION
+    struct timex adjust;
+    memset(&adjust, 0, sizeof(adjust));
+    // Carry on from the correction the kernel already has
+    if (adjtimex(&adjust) >= 0)
+    {
+        result = adjust.freq/FREQUENCY_SCALE;
+    }
+#endif
+    return result;
+}
+
+// Part of the last slew the kernel has not applied yet
+static int64_t get_pending_slew_ns(void)
+{
+    int64_t result = 0;
+#if PRODUCTION
+    struct timex adjust;
+    memset(&adjust, 0, sizeof(adjust));
+    adjust.modes = ADJ_OFFSET_SS_READ;
+    if (adjtimex(&adjust) >= 0)
+    {
+        result = (int64_t)adjust.offset*1000;
+    }
+#endif
+    return result;
+}
+
+static int step_machine_time(int64_t offset_ns)
+{
+    int result;
+#if PRODUCTION
+    struct timespec time_now;
+    (void)clock_gettime(CLOCK_REALTIME, &time_now);
+    int64_t set_ns = get_timespec_ns(&time_now) + offset_ns;
+    time_now.tv_sec = (time_t)(set_ns/NSEC_IN_SECOND);
+    time_now.tv_nsec = (long)(set_ns % NSEC_IN_SECOND);
+    if ((result = clock_settime(CLOCK_REALTIME, &time_now)) != 0)
+    {
+        log_error("Failure stepping the time of day");
+    }
+#else
+    log_info("Stepping time by %lld ms", (long long)(offset_ns/1000000));
+    result = 0;
+#endif
+    return result;
+}
+
+static int slew_machine_time(int64_t offset_ns, double frequency_ppm)
+{
+    int result;
+#if PRODUCTION
+    struct timex adjust;
+    memset(&adjust, 0, sizeof(adjust));
+    // A single shot offset has to go in on its own, it replaces whatever is
+    // left of the previous one
+    adjust.modes = ADJ_OFFSET_SINGLESHOT;
+    adjust.offset = (long)(offset_ns/1000);
+    if (adjtimex(&adjust) < 0)
+    {
+        log_error("Failure slewing the time of day");
+        result = __LINE__;
+    }
+    else
+    {
+        memset(&adjust, 0, sizeof(adjust));
+        adjust.modes = ADJ_FREQUENCY;
+        adjust.freq = (long)(frequency_ppm*FREQUENCY_SCALE);
+        if (adjtimex(&adjust) < 0)
+        {
+            log_error("Failure setting the clock frequency");
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+#else
+    log_info("Slewing time by %lld us, frequency %.3f ppm", (long long)(offset_ns/1000), frequency_ppm);
+    result = 0;
+#endif
+    return result;
+}
+
 
 time_t get_time(void)
 {
     return time(NULL);
 }
 
+int64_t get_time_usec(void)
+{
+    struct timespec curr_time;
+    (void)clock_gettime(CLOCK_REALTIME, &curr_time);
+    return (int64_t)curr_time.tv_sec*1000000 + curr_time.tv_nsec/1000;
+}
+
 struct tm* get_time_value(void)
 {
     time_t mark_time = time(NULL);
@@ -38,4 +164,57 @@ int set_machine_time(time_t* set_time)
     result = 0;
 #endif
     return result;
+}
+
+int discipline_machine_time(const struct timespec* offset)
+{
+    int result;
+    if (offset == NULL)
+    {
+        log_error("Invalid argument specified offset: NULL");
+        result = __LINE__;
+    }
+    else
+    {
+        struct timespec sample_time;
+        int64_t offset_ns = get_timespec_ns(offset);
+        (void)clock_gettime(CLOCK_MONOTONIC, &sample_time);
+        if (!g_discipline.initialized)
+        {
+            g_discipline.frequency_ppm = get_frequency_ppm();
+            g_discipline.initialized = true;
+        }
+
+        if (offset_ns > MAX_SLEW_OFFSET_NS || offset_ns < -MAX_SLEW_OFFSET_NS)
+        {
+            // Slewing this far would take hours at the kernel's 500 ppm, and
+            // an offset this size says nothing about the drift
+            g_discipline.has_sample = false;
+            result = step_machine_time(offset_ns);
+        }
+        else
+        {
+            double interval = (double)(get_timespec_ns(&sample_time) - get_timespec_ns(&g_discipline.sample_time))/NSEC_IN_SECOND;
+            if (g_discipline.has_sample && interval >= MIN_DRIFT_INTERVAL_SEC)
+            {
+                // Whatever the last slew has not applied yet is not drift
+                double drift_ppm = (double)(offset_ns - get_pending_slew_ns())/(interval*1000.0);
+                g_discipline.frequency_ppm += DRIFT_GAIN*drift_ppm;
+                if (g_discipline.frequency_ppm > MAX_FREQUENCY_PPM)
+                {
+                    g_discipline.frequency_ppm = MAX_FREQUENCY_PPM;
+                }
+                else if (g_discipline.frequency_ppm < -MAX_FREQUENCY_PPM)
+                {
+                    g_discipline.frequency_ppm = -MAX_FREQUENCY_PPM;
+                }
+            }
+            if ((result = slew_machine_time(offset_ns, g_discipline.frequency_ppm)) == 0)
+            {
+                g_discipline.sample_time = sample_time;
+                g_discipline.has_sample = true;
+            }
+        }
+    }
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,313 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SAMPLE_CONVERT_X86
+#endif
+
+#include "lib-util-c/app_logging.h"
+
+#include "sample_convert.h"
+
+#define GAIN_UNITY_Q15      32767
+
+typedef struct SAMPLE_CONVERT_OPS_TAG
+{
+    SAMPLE_CONVERT_IMPL impl;
+    void (*swap_16)(int16_t* samples, size_t count);
+    void (*widen_8)(const uint8_t* source, int16_t* target, size_t count);
+    void (*downmix_stereo)(const int16_t* source, int16_t* target, size_t frames);
+    void (*apply_gain)(int16_t* samples, size_t count, int16_t gain_q15);
+} SAMPLE_CONVERT_OPS;
+
+static const SAMPLE_CONVERT_OPS* g_convert_ops = NULL;
+
+// The scalar kernels finish the tail of every vector kernel, so they
+// take the starting index instead of an adjusted pointer
+static void swap_16_scalar(int16_t* samples, size_t index, size_t count)
+{
+    for (; index < count; index++)
+    {
+        uint16_t value = (uint16_t)samples[index];
+        samples[index] = (int16_t)(uint16_t)((value << 8) | (value >> 8));
+    }
+}
+
+static void widen_8_scalar(const uint8_t* source, int16_t* target, size_t index, size_t count)
+{
+    for (; index < count; index++)
+    {
+        target[index] = (int16_t)(((int32_t)source[index] - 128)*256);
+    }
+}
+
+static void downmix_stereo_scalar(const int16_t* source, int16_t* target, size_t index, size_t frames)
+{
+    for (; index < frames; index++)
+    {
+        target[index] = (int16_t)(((int32_t)source[index*2] + source[index*2 + 1]) >> 1);
+    }
+}
+
+static void apply_gain_scalar(int16_t* samples, size_t index, size_t count, int16_t gain_q15)
+{
+    // Rounds the same way pmulhrsw does so every kernel gives identical output
+    for (; index < count; index++)
+    {
+        samples[index] = (int16_t)(((int32_t)samples[index]*gain_q15 + 0x4000) >> 15);
+    }
+}
+
+static void swap_16_c(int16_t* samples, size_t count)
+{
+    swap_16_scalar(samples, 0, count);
+}
+
+static void widen_8_c(const uint8_t* source, int16_t* target, size_t count)
+{
+    widen_8_scalar(source, target, 0, count);
+}
+
+static void downmix_stereo_c(const int16_t* source, int16_t* target, size_t frames)
+{
+    downmix_stereo_scalar(source, target, 0, frames);
+}
+
+static void apply_gain_c(int16_t* samples, size_t count, int16_t gain_q15)
+{
+    apply_gain_scalar(samples, 0, count, gain_q15);
+}
+
+static const SAMPLE_CONVERT_OPS g_scalar_ops = { SAMPLE_CONVERT_SCALAR, swap_16_c, widen_8_c, downmix_stereo_c, apply_gain_c };
+
+#ifdef SAMPLE_CONVERT_X86
+__attribute__((target("ssse3")))
+static void swap_16_ssse3(int16_t* samples, size_t count)
+{
+    const __m128i swap_mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i*)(samples + index));
+        _mm_storeu_si128((__m128i*)(samples + index), _mm_shuffle_epi8(value, swap_mask));
+    }
+    swap_16_scalar(samples, index, count);
+}
+
+__attribute__((target("ssse3")))
+static void widen_8_ssse3(const uint8_t* source, int16_t* target, size_t count)
+{
+    // Flipping the top bit makes the byte signed, interleaving it above a
+    // zero byte then shifts it into the high half of each sample
+    const __m128i sign_bit = _mm_set1_epi8((char)0x80);
+    const __m128i zero = _mm_setzero_si128();
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(source + index)), sign_bit);
+        _mm_storeu_si128((__m128i*)(target + index), _mm_unpacklo_epi8(zero, value));
+        _mm_storeu_si128((__m128i*)(target + index + 8), _mm_unpackhi_epi8(zero, value));
+    }
+    widen_8_scalar(source, target, index, count);
+}
+
+__attribute__((target("ssse3")))
+static void downmix_stereo_ssse3(const int16_t* source, int16_t* target, size_t frames)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    size_t index = 0;
+    for (; index + 8 <= frames; index += 8)
+    {
+        __m128i low = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(source + index*2)), ones);
+        __m128i high = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(source + index*2 + 8)), ones);
+        _mm_storeu_si128((__m128i*)(target + index), _mm_packs_epi32(_mm_srai_epi32(low, 1), _mm_srai_epi32(high, 1)));
+    }
+    downmix_stereo_scalar(source, target, index, frames);
+}
+
+__attribute__((target("ssse3")))
+static void apply_gain_ssse3(int16_t* samples, size_t count, int16_t gain_q15)
+{
+    const __m128i gain = _mm_set1_epi16(gain_q15);
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i*)(samples + index));
+        _mm_storeu_si128((__m128i*)(samples + index), _mm_mulhrs_epi16(value, gain));
+    }
+    apply_gain_scalar(samples, index, count, gain_q15);
+}
+
+__attribute__((target("avx2")))
+static void swap_16_avx2(int16_t* samples, size_t count)
+{
+    const __m256i swap_mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(samples + index));
+        _mm256_storeu_si256((__m256i*)(samples + index), _mm256_shuffle_epi8(value, swap_mask));
+    }
+    swap_16_scalar(samples, index, count);
+}
+
+__attribute__((target("avx2")))
+static void widen_8_avx2(const uint8_t* source, int16_t* target, size_t count)
+{
+    const __m128i sign_bit = _mm_set1_epi8((char)0x80);
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        __m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(source + index)), sign_bit);
+        _mm256_storeu_si256((__m256i*)(target + index), _mm256_slli_epi16(_mm256_cvtepi8_epi16(value), 8));
+    }
+    widen_8_scalar(source, target, index, count);
+}
+
+__attribute__((target("avx2")))
+static void downmix_stereo_avx2(const int16_t* source, int16_t* target, size_t frames)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    size_t index = 0;
+    for (; index + 16 <= frames; index += 16)
+    {
+        __m256i low = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(source + index*2)), ones);
+        __m256i high = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(source + index*2 + 16)), ones);
+        // The pack works per 128 bit lane, so put the quarters back in order
+        __m256i packed = _mm256_packs_epi32(_mm256_srai_epi32(low, 1), _mm256_srai_epi32(high, 1));
+        _mm256_storeu_si256((__m256i*)(target + index), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    downmix_stereo_scalar(source, target, index, frames);
+}
+
+__attribute__((target("avx2")))
+static void apply_gain_avx2(int16_t* samples, size_t count, int16_t gain_q15)
+{
+    const __m256i gain = _mm256_set1_epi16(gain_q15);
+    size_t index = 0;
+    for (; index + 16 <= count; index += 16)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(samples + index));
+        _mm256_storeu_si256((__m256i*)(samples + index), _mm256_mulhrs_epi16(value, gain));
+    }
+    apply_gain_scalar(samples, index, count, gain_q15);
+}
+
+static const SAMPLE_CONVERT_OPS g_ssse3_ops = { SAMPLE_CONVERT_SSSE3, swap_16_ssse3, widen_8_ssse3, downmix_stereo_ssse3, apply_gain_ssse3 };
+static const SAMPLE_CONVERT_OPS g_avx2_ops = { SAMPLE_CONVERT_AVX2, swap_16_avx2, widen_8_avx2, downmix_stereo_avx2, apply_gain_avx2 };
+#endif
+
+static const SAMPLE_CONVERT_OPS* get_supported_ops(SAMPLE_CONVERT_IMPL impl)
+{
+    const SAMPLE_CONVERT_OPS* result = NULL;
+    if (impl == SAMPLE_CONVERT_SCALAR)
+    {
+        result = &g_scalar_ops;
+    }
+#ifdef SAMPLE_CONVERT_X86
+    else
+    {
+        __builtin_cpu_init();
+        if (impl == SAMPLE_CONVERT_SSSE3 && __builtin_cpu_supports("ssse3"))
+        {
+            result = &g_ssse3_ops;
+        }
+        else if (impl == SAMPLE_CONVERT_AVX2 && __builtin_cpu_supports("avx2"))
+        {
+            result = &g_avx2_ops;
+        }
+    }
+#endif
+    return result;
+}
+
+static const SAMPLE_CONVERT_OPS* get_convert_ops(void)
+{
+    if (g_convert_ops == NULL)
+    {
+        const SAMPLE_CONVERT_OPS* result;
+        if ((result = get_supported_ops(SAMPLE_CONVERT_AVX2)) == NULL &&
+            (result = get_supported_ops(SAMPLE_CONVERT_SSSE3)) == NULL)
+        {
+            result = &g_scalar_ops;
+        }
+        g_convert_ops = result;
+    }
+    return g_convert_ops;
+}
+
+int sample_convert_set_impl(SAMPLE_CONVERT_IMPL impl)
+{
+    int result;
+    const SAMPLE_CONVERT_OPS* convert_ops;
+    if ((convert_ops = get_supported_ops(impl)) == NULL)
+    {
+        log_error("Sample conversion %d is not supported on this cpu", (int)impl);
+        result = __LINE__;
+    }
+    else
+    {
+        g_convert_ops = convert_ops;
+        result = 0;
+    }
+    return result;
+}
+
+SAMPLE_CONVERT_IMPL sample_convert_get_impl(void)
+{
+    return get_convert_ops()->impl;
+}
+
+void sample_convert_swap_16(int16_t* samples, size_t count)
+{
+    if (samples == NULL)
+    {
+        log_error("Invalid argument samples is NULL");
+    }
+    else
+    {
+        get_convert_ops()->swap_16(samples, count);
+    }
+}
+
+void sample_convert_widen_8(const uint8_t* source, int16_t* target, size_t count)
+{
+    if (source == NULL || target == NULL)
+    {
+        log_error("Invalid argument source: %p, target: %p", source, target);
+    }
+    else
+    {
+        get_convert_ops()->widen_8(source, target, count);
+    }
+}
+
+void sample_convert_downmix_stereo(const int16_t* source, int16_t* target, size_t frames)
+{
+    if (source == NULL || target == NULL)
+    {
+        log_error("Invalid argument source: %p, target: %p", source, target);
+    }
+    else
+    {
+        get_convert_ops()->downmix_stereo(source, target, frames);
+    }
+}
+
+void sample_convert_apply_gain(int16_t* samples, size_t count, float gain)
+{
+    if (samples == NULL)
+    {
+        log_error("Invalid argument samples is NULL");
+    }
+    else if (gain < 1.0f)
+    {
+        int16_t gain_q15 = gain <= 0.0f ? 0 : (int16_t)(gain*GAIN_UNITY_Q15 + 0.5f);
+        get_convert_ops()->apply_gain(samples, count, gain_q15);
+    }
+}
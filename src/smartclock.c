@@ -21,9 +21,13 @@
 #include "sound_mgr.h"
 #include "gui_mgr.h"
 #include "time_mgr.h"
+#include "event_loop.h"
+#include "latency_stats.h"
 
 #include "smartclock.h"
 
+#define MAX_PENDING_ALARMS      8
+
 typedef enum OPERATION_STATE_TAG
 {
     OPERATION_STATE_IDLE,
@@ -38,8 +42,9 @@ typedef struct SMARTCLOCK_INFO_TAG
     CONFIG_MGR_HANDLE config_mgr;
     SOUND_MGR_HANDLE sound_mgr;
     GUI_MGR_HANDLE gui_mgr;
+    EVENT_LOOP_HANDLE event_loop;
+    bool poll_gui;
 
-    uint8_t last_alarm_min;
     uint8_t last_weather_day;
 
 #ifdef USE_NTP_CLIENT
@@ -55,7 +60,19 @@ typedef struct SMARTCLOCK_INFO_TAG
     OPERATION_STATE weather_operation;
 
     ALARM_TIMER_INFO max_alarm_len;
+    ALARM_TIMER_INFO latency_log_timer;
     const ALARM_INFO* triggered_alarm;
+    // Alarm id and instant the sound is loaded ahead of, a recurring alarm
+    // keeps its ALARM_INFO from one day to the next
+    uint8_t prepared_alarm_id;
+    time_t prepared_fire_time;
+    time_t prepare_time;
+    uint32_t alarm_prepare_lead;
+    // Seconds the alarm sound ramps up over, 0 is full volume straight away
+    uint32_t crescendo_time;
+    const ALARM_INFO* pending_alarms[MAX_PENDING_ALARMS];
+    size_t pending_count;
+    uint32_t next_alarm_generation;
 
     uint32_t alarm_volume;
     const char* weather_appid;
@@ -67,6 +84,13 @@ typedef struct SMARTCLOCK_INFO_TAG
     bool is_demo_mode;
 } SMARTCLOCK_INFO;
 
+typedef struct ALARM_LOAD_INFO_TAG
+{
+    ALARM_INFO* alarm_list;
+    size_t alarm_count;
+    size_t alarm_capacity;
+} ALARM_LOAD_INFO;
+
 typedef enum ARGUEMENT_TYPE_TAG
 {
     ARGUEMENT_TYPE_UNKNOWN,
@@ -74,11 +98,14 @@ typedef enum ARGUEMENT_TYPE_TAG
 } ARGUEMENT_TYPE;
 
 #define OPERATION_TIMEOUT       5
-#define MAX_TIME_DIFFERENCE     2*60*60 // Every 2 hours
 #define MAX_WEATHER_DIFF        3*60*60 // Every 3 hours
-#define MAX_TIME_OFFSET         2*60    // 2 min
 #define MAX_ALARM_RING_TIME     2*60    // 2 min
+#define LATENCY_LOG_INTERVAL    24*60*60 // Once a day
 #define INVALID_HOUR_VALUE      24      // Invalid hour
+#define INITIAL_ALARM_LOAD_CAPACITY 16
+#define SECONDS_IN_MINUTE       60
+#define USEC_IN_SECOND          1000000
+#define MAX_SOUND_PATH_LENGTH   1024
 
 //static const char* const ENV_WEATHER_APP_ID = "weather_appid";
 static const char* const CONFIG_FOLDER_NAME = "config";
@@ -86,9 +113,11 @@ static const char OS_FILE_SEPARATOR = '/';
 static const char* OS_FILE_SEPARATOR_FMT = "%s/";
 
 static bool g_run_application = true;
+static LATENCY_HISTOGRAM g_alarm_latency[ALARM_LATENCY_STAGE_COUNT];
+static const char* const ALARM_LATENCY_NAMES[ALARM_LATENCY_STAGE_COUNT] = { "Alarm detected", "Alarm displayed", "Alarm audible", "Alarm queued" };
 
 // Callback information
-static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result, time_t current_time)
+static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result, const struct timespec* offset, const struct timespec* delay)
 {
     SMARTCLOCK_INFO* clock_info = (SMARTCLOCK_INFO*)user_ctx;
     if (clock_info == NULL)
@@ -99,11 +128,11 @@ static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result,
     {
         if (ntp_result == NTP_OP_RESULT_SUCCESS)
         {
-            time_t sys_time = time(NULL);
-            double delta = difftime(sys_time, current_time);
-            if ((delta < 0 ? delta*-1 : delta) > MAX_TIME_OFFSET)
+            (void)delay;
+            // Small offsets are slewed so the display never jumps
+            if (discipline_machine_time(offset) != 0)
             {
-                set_machine_time(&current_time);
+                log_warning("Failure correcting the clock from NTP");
             }
             clock_info->ntp_operation = OPERATION_STATE_SUCCESS;
         }
@@ -112,7 +141,6 @@ static void ntp_result_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result,
             clock_info->ntp_operation = OPERATION_STATE_ERROR;
             log_error("Failure retrieving NTP time %d", ntp_result);
         }
-        (void)alarm_timer_reset(&clock_info->ntp_alarm);
     }
 }
 
@@ -204,29 +232,33 @@ static void check_ntp_operation(SMARTCLOCK_INFO* clock_info)
     {
         if (clock_info->is_demo_mode)
         {
-            ntp_result_callback(clock_info, NTP_OP_RESULT_SUCCESS, time(NULL));
+            struct timespec no_offset = { 0 };
+            ntp_result_callback(clock_info, NTP_OP_RESULT_SUCCESS, &no_offset, &no_offset);
         }
         else
         {
             ntp_client_process(clock_info->ntp_client);
         }
     }
-    else if (clock_info->ntp_operation == OPERATION_STATE_ERROR)
+    else if (clock_info->ntp_operation == OPERATION_STATE_SUCCESS || clock_info->ntp_operation == OPERATION_STATE_ERROR)
     {
-        // todo: Need to alert the user and show config dialog
-        alarm_timer_reset(&clock_info->ntp_alarm);
+        // todo: Need to alert the user and show config dialog on errors
+        // The client backs off after failures and polls less often while
+        // the clock holds steady
+        (void)alarm_timer_start(&clock_info->ntp_alarm, ntp_client_get_poll_interval(clock_info->ntp_client));
         clock_info->ntp_operation = OPERATION_STATE_IDLE;
     }
     else if (alarm_timer_is_expired(&clock_info->ntp_alarm))
     {
-        const char* ntp_address = config_mgr_get_ntp_address(clock_info->config_mgr);
-        if (ntp_address == NULL)
+        const char* server_list[NTP_CLIENT_MAX_SERVERS];
+        size_t server_count = config_mgr_get_ntp_servers(clock_info->config_mgr, server_list, NTP_CLIENT_MAX_SERVERS);
+        if (server_count == 0)
         {
             // todo: Need to alert the user and show config dialog
             log_error("Ntp Address is not entered");
             clock_info->ntp_operation = OPERATION_STATE_ERROR;
         }
-        else if (!clock_info->is_demo_mode && ntp_client_get_time(clock_info->ntp_client, ntp_address, OPERATION_TIMEOUT, ntp_result_callback, clock_info) != 0)
+        else if (!clock_info->is_demo_mode && ntp_client_get_offset(clock_info->ntp_client, server_list, server_count, OPERATION_TIMEOUT, ntp_result_callback, clock_info) != 0)
         {
             clock_info->ntp_operation = OPERATION_STATE_ERROR;
             log_error("NTP get_time operation failure");
@@ -284,6 +316,27 @@ static void adjust_shades(SMARTCLOCK_INFO* clock_info, const struct tm* curr_tim
     }
 }
 
+static void show_next_alarm(SMARTCLOCK_INFO* clock_info)
+{
+    const ALARM_INFO* next_alarm = alarm_scheduler_get_next_alarm(clock_info->sched_mgr);
+    // Only redraw when the scheduler has recalculated the next alarm
+    uint32_t generation = alarm_scheduler_get_next_alarm_generation(clock_info->sched_mgr);
+    if (generation != clock_info->next_alarm_generation)
+    {
+        gui_mgr_set_next_alarm(clock_info->gui_mgr, next_alarm);
+        clock_info->next_alarm_generation = generation;
+    }
+}
+
+static void release_triggered_alarm(SMARTCLOCK_INFO* clock_info)
+{
+    if (clock_info->triggered_alarm != NULL)
+    {
+        alarm_scheduler_release_alarm(clock_info->sched_mgr, clock_info->triggered_alarm);
+        clock_info->triggered_alarm = NULL;
+    }
+}
+
 static void gui_notification_cb(void* user_ctx, GUI_NOTIFICATION_TYPE type, void* res_value)
 {
     SMARTCLOCK_INFO* clock_info = (SMARTCLOCK_INFO*)user_ctx;
@@ -307,8 +360,8 @@ static void gui_notification_cb(void* user_ctx, GUI_NOTIFICATION_TYPE type, void
                 clock_info->alarm_op_state = ALARM_STATE_SNOOZE;
                 (void)alarm_scheduler_snooze_alarm(clock_info->sched_mgr, clock_info->triggered_alarm);
             }
-            gui_mgr_set_next_alarm(clock_info->gui_mgr, alarm_scheduler_get_next_alarm(clock_info->sched_mgr));
-            clock_info->triggered_alarm = NULL;
+            show_next_alarm(clock_info);
+            release_triggered_alarm(clock_info);
         }
         else if (type == NOTIFICATION_APPLICATION_RESULT)
         {
@@ -331,31 +384,82 @@ static void gui_notification_cb(void* user_ctx, GUI_NOTIFICATION_TYPE type, void
                     }
                 }
                 // The option dialog just closed
-                gui_mgr_set_next_alarm(clock_info->gui_mgr, alarm_scheduler_get_next_alarm(clock_info->sched_mgr));
+                show_next_alarm(clock_info);
             }
         }
     }
 }
 
-static void play_alarm_sound(SMARTCLOCK_INFO* clock_info, const ALARM_INFO* alarm_info)
+static void record_alarm_latency(ALARM_LATENCY_STAGE stage, time_t fire_time)
+{
+    // Only alarms fired by the absolute scheduler have a fire time
+    if (fire_time != 0)
+    {
+        int64_t latency_usec = get_time_usec() - (int64_t)fire_time*USEC_IN_SECOND;
+        // Stepping the clock back can put the fire time in the future
+        latency_stats_add(&g_alarm_latency[stage], latency_usec < 0 ? 0 : (uint64_t)latency_usec);
+    }
+}
+
+static void log_alarm_latency(SMARTCLOCK_INFO* clock_info)
 {
-    char sound_filename[1024];
+    if (alarm_timer_is_expired(&clock_info->latency_log_timer))
+    {
+        for (size_t index = 0; index < ALARM_LATENCY_STAGE_COUNT; index++)
+        {
+            if (latency_stats_get_count(&g_alarm_latency[index]) > 0)
+            {
+                latency_stats_log(&g_alarm_latency[index], ALARM_LATENCY_NAMES[index]);
+            }
+        }
+        (void)alarm_timer_start(&clock_info->latency_log_timer, LATENCY_LOG_INTERVAL);
+    }
+}
+
+static int get_alarm_sound_path(SMARTCLOCK_INFO* clock_info, const ALARM_INFO* alarm_info, char* sound_filename)
+{
+    int result;
     const char* audio_dir = config_mgr_get_audio_dir(clock_info->config_mgr);
     if (audio_dir == NULL)
     {
         // todo: need to do something to tell the user
         log_error("Invalid configuration file unable to retrieve audio directory");
+        result = __LINE__;
+    }
+    else if (snprintf(sound_filename, MAX_SOUND_PATH_LENGTH, "%s%s", audio_dir, alarm_info->sound_file) >= MAX_SOUND_PATH_LENGTH)
+    {
+        log_error("Sound file path is too long for alarm: %s", alarm_info->alarm_text);
+        result = __LINE__;
     }
     else
     {
-        // construct names
-        sprintf(sound_filename, "%s%s", audio_dir, alarm_info->sound_file);
-        if (sound_mgr_play(clock_info->sound_mgr, sound_filename, true, false) != 0)
+        result = 0;
+    }
+    return result;
+}
+
+static int play_alarm_sound(SMARTCLOCK_INFO* clock_info, const ALARM_INFO* alarm_info)
+{
+    int result;
+    char sound_filename[MAX_SOUND_PATH_LENGTH];
+    if (get_alarm_sound_path(clock_info, alarm_info, sound_filename) != 0)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        if (sound_mgr_play(clock_info->sound_mgr, sound_filename, true, clock_info->crescendo_time > 0) != 0)
         {
             // todo: need to do something to tell the user
             log_error("Failure playing sound file for alarm: %s", alarm_info->alarm_text);
+            result = __LINE__;
+        }
+        else
+        {
+            result = 0;
         }
     }
+    return result;
 }
 
 static void stop_alarm_sound(SMARTCLOCK_INFO* clock_info)
@@ -366,76 +470,243 @@ static void stop_alarm_sound(SMARTCLOCK_INFO* clock_info)
     }
 }
 
-static void check_alarm_operation(SMARTCLOCK_INFO* clock_info, const struct tm* curr_time)
+static void trigger_alarm(SMARTCLOCK_INFO* clock_info, const ALARM_INFO* triggered, bool queued)
 {
-    if (clock_info->last_alarm_min != curr_time->tm_min)
+    time_t fire_time = alarm_scheduler_get_fire_time(clock_info->sched_mgr, triggered);
+
+    // Trigger Alarm to fire
+    gui_mgr_set_alarm_triggered(clock_info->gui_mgr, triggered);
+    // An alarm that waited out another one's ring would swamp the fire path
+    // numbers, so its wait is kept apart
+    record_alarm_latency(queued ? ALARM_LATENCY_QUEUED : ALARM_LATENCY_DISPLAYED, fire_time);
+
+    if (clock_info->shades_down)
     {
-        const struct tm* time_value = get_time_value();
-        const ALARM_INFO* triggered = alarm_scheduler_is_triggered(clock_info->sched_mgr, time_value);
-        if (triggered != NULL)
-        {
-            // Trigger Alarm to fire
-            gui_mgr_set_alarm_triggered(clock_info->gui_mgr, triggered);
+        // Turn shades on
+    }
 
-            if (clock_info->shades_down)
-            {
-                // Turn shades on
-            }
+    // sound_mgr_play returns once the first buffers are queued
+    if (play_alarm_sound(clock_info, triggered) == 0 && !queued)
+    {
+        record_alarm_latency(ALARM_LATENCY_AUDIBLE, fire_time);
+    }
 
-            play_alarm_sound(clock_info, triggered);
+    clock_info->alarm_op_state = ALARM_STATE_TRIGGERED;
+    (void)alarm_timer_start(&clock_info->max_alarm_len, MAX_ALARM_RING_TIME);
+    clock_info->triggered_alarm = triggered;
+}
 
-            clock_info->alarm_op_state = ALARM_STATE_TRIGGERED;
-            (void)alarm_timer_start(&clock_info->max_alarm_len, MAX_ALARM_RING_TIME);
-            clock_info->triggered_alarm = triggered;
+static void prepare_next_alarm(SMARTCLOCK_INFO* clock_info, time_t curr_time)
+{
+    time_t fire_time;
+    const ALARM_INFO* next_alarm = alarm_scheduler_get_next_due_alarm(clock_info->sched_mgr, &fire_time);
+    if (next_alarm == NULL || (next_alarm->alarm_id == clock_info->prepared_alarm_id && fire_time == clock_info->prepared_fire_time))
+    {
+        clock_info->prepare_time = 0;
+    }
+    else if (fire_time - curr_time > (time_t)clock_info->alarm_prepare_lead)
+    {
+        clock_info->prepare_time = fire_time - clock_info->alarm_prepare_lead;
+    }
+    else
+    {
+        // Load the sound now so firing only has to start the source
+        char sound_filename[MAX_SOUND_PATH_LENGTH];
+        if (get_alarm_sound_path(clock_info, next_alarm, sound_filename) != 0 ||
+            sound_mgr_prepare(clock_info->sound_mgr, sound_filename) != 0)
+        {
+            log_warning("Failure preparing sound for alarm: %s", next_alarm->alarm_text);
         }
-        clock_info->last_alarm_min = curr_time->tm_min;
+        // Don't retry every pass, playing loads the sound again anyway
+        clock_info->prepared_alarm_id = next_alarm->alarm_id;
+        clock_info->prepared_fire_time = fire_time;
+        clock_info->prepare_time = 0;
+    }
+}
+
+static void check_alarm_operation(SMARTCLOCK_INFO* clock_info)
+{
+    time_t curr_time = get_time();
+    // Alarms still pending from an earlier pass waited for the one ringing
+    size_t waiting_count = clock_info->pending_count;
+
+    // The scheduler keeps each alarm's next fire instant, so checking every
+    // pass only costs a compare until one is due.  Alarms sharing a minute
+    // queue up behind the one that is ringing.
+    if (clock_info->pending_count < MAX_PENDING_ALARMS)
+    {
+        size_t due_count = alarm_scheduler_get_due_alarms(clock_info->sched_mgr, curr_time,
+            &clock_info->pending_alarms[clock_info->pending_count], MAX_PENDING_ALARMS - clock_info->pending_count);
+        for (size_t index = 0; index < due_count; index++)
+        {
+            record_alarm_latency(ALARM_LATENCY_DETECTED, alarm_scheduler_get_fire_time(clock_info->sched_mgr, clock_info->pending_alarms[clock_info->pending_count++]));
+        }
+    }
+    if (clock_info->alarm_op_state != ALARM_STATE_TRIGGERED && clock_info->pending_count > 0)
+    {
+        const ALARM_INFO* triggered = clock_info->pending_alarms[0];
+        clock_info->pending_count--;
+        memmove(&clock_info->pending_alarms[0], &clock_info->pending_alarms[1], clock_info->pending_count*sizeof(const ALARM_INFO*));
+        trigger_alarm(clock_info, triggered, waiting_count > 0);
     }
     if (clock_info->alarm_op_state == ALARM_STATE_TRIGGERED)
     {
+        // Long alarm tracks are streamed and need topping up
+        (void)sound_mgr_process(clock_info->sound_mgr);
         if (alarm_timer_is_expired(&clock_info->max_alarm_len))
         {
             gui_mgr_set_alarm_triggered(clock_info->gui_mgr, NULL);
-            gui_mgr_set_next_alarm(clock_info->gui_mgr, alarm_scheduler_get_next_alarm(clock_info->sched_mgr));
+            show_next_alarm(clock_info);
             stop_alarm_sound(clock_info);
+            release_triggered_alarm(clock_info);
             clock_info->alarm_op_state = ALARM_STATE_STOPPED;
         }
     }
+    else if (clock_info->pending_count == 0)
+    {
+        prepare_next_alarm(clock_info, curr_time);
+    }
+    log_alarm_latency(clock_info);
+}
+
+static void register_gui_input(SMARTCLOCK_INFO* clock_info)
+{
+    int input_fd = gui_mgr_get_input_fd(clock_info->gui_mgr);
+    if (input_fd < 0)
+    {
+        clock_info->poll_gui = true;
+    }
+    else if (event_loop_add_fd(clock_info->event_loop, input_fd) != 0)
+    {
+        log_warning("Failure waiting on gui input, polling the gui instead");
+        clock_info->poll_gui = true;
+    }
+}
+
+static void wait_for_next_event(SMARTCLOCK_INFO* clock_info, size_t refresh_time)
+{
+    time_t curr_time = get_time();
+    size_t max_wait;
+
+    // Nothing changes on screen before the next second or minute boundary
+    time_t wake_time = config_mgr_show_seconds(clock_info->config_mgr) ? curr_time + 1 : curr_time - (curr_time % SECONDS_IN_MINUTE) + SECONDS_IN_MINUTE;
+    time_t alarm_time = alarm_scheduler_get_next_due_time(clock_info->sched_mgr);
+    if (alarm_time < wake_time)
+    {
+        wake_time = alarm_time;
+    }
+    if (clock_info->prepare_time > curr_time && clock_info->prepare_time < wake_time)
+    {
+        wake_time = clock_info->prepare_time;
+    }
+
+    if (wake_time <= curr_time || (clock_info->pending_count > 0 && clock_info->alarm_op_state != ALARM_STATE_TRIGGERED))
+    {
+        max_wait = 0;
+    }
+    // The ntp and weather sockets live inside their clients and a ringing
+    // alarm has to time out, so keep polling while any of them is active
+    else if (clock_info->poll_gui || clock_info->ntp_operation != OPERATION_STATE_IDLE ||
+        clock_info->weather_operation != OPERATION_STATE_IDLE || clock_info->alarm_op_state == ALARM_STATE_TRIGGERED)
+    {
+        max_wait = refresh_time;
+    }
+    else
+    {
+        max_wait = EVENT_LOOP_WAIT_FOREVER;
+    }
+
+    if (event_loop_wait(clock_info->event_loop, wake_time, max_wait) != 0)
+    {
+        log_error("Failure waiting on the event loop");
+        thread_mgr_sleep(refresh_time);
+    }
 }
 
 static int load_alarms_cb(void* context, const CONFIG_ALARM_INFO* cfg_alarm)
 {
     int result;
-    SCHEDULER_HANDLE sched_mgr = (SCHEDULER_HANDLE)context;
-    if (sched_mgr == NULL)
+    ALARM_LOAD_INFO* load_info = (ALARM_LOAD_INFO*)context;
+    if (load_info == NULL)
     {
         log_error("Invalid user context specfied");
         result = __LINE__;
     }
     else
     {
-        ALARM_INFO alarm_info;
-        alarm_info.alarm_text = (char*)cfg_alarm->name;
-        alarm_info.sound_file = (char*)cfg_alarm->sound_file;
-        alarm_info.trigger_time.hour = cfg_alarm->time_value.hours;
-        alarm_info.trigger_time.min = cfg_alarm->time_value.minutes;
-        alarm_info.trigger_time.sec = cfg_alarm->time_value.seconds;
-        alarm_info.snooze_min = cfg_alarm->snooze;
-        alarm_info.trigger_days = cfg_alarm->frequency;
-        alarm_info.alarm_id = cfg_alarm->id;
+        if (load_info->alarm_count == load_info->alarm_capacity)
+        {
+            size_t new_capacity = load_info->alarm_capacity == 0 ? INITIAL_ALARM_LOAD_CAPACITY : load_info->alarm_capacity*2;
+            ALARM_INFO* new_list;
+            if ((new_list = (ALARM_INFO*)realloc(load_info->alarm_list, new_capacity*sizeof(ALARM_INFO))) == NULL)
+            {
+                log_error("Failure allocating alarm list");
+            }
+            else
+            {
+                load_info->alarm_list = new_list;
+                load_info->alarm_capacity = new_capacity;
+            }
+        }
 
-        if (alarm_scheduler_add_alarm_info(sched_mgr, &alarm_info) != 0)
+        if (load_info->alarm_count == load_info->alarm_capacity)
         {
             log_error("Failure adding alarm %s", cfg_alarm->name);
             result = __LINE__;
         }
         else
         {
+            // The strings belong to the config manager and are copied by the
+            // scheduler once the whole list is loaded
+            ALARM_INFO* alarm_info = &load_info->alarm_list[load_info->alarm_count++];
+            alarm_info->alarm_text = (char*)cfg_alarm->name;
+            alarm_info->sound_file = (char*)cfg_alarm->sound_file;
+            alarm_info->trigger_time.hour = cfg_alarm->time_value.hours;
+            alarm_info->trigger_time.min = cfg_alarm->time_value.minutes;
+            alarm_info->trigger_time.sec = cfg_alarm->time_value.seconds;
+            alarm_info->snooze_min = cfg_alarm->snooze;
+            alarm_info->trigger_days = cfg_alarm->frequency;
+            alarm_info->alarm_id = cfg_alarm->id;
             result = 0;
         }
     }
     return result;
 }
 
+static int load_alarms(SMARTCLOCK_INFO* clock_info)
+{
+    int result;
+    ALARM_LOAD_INFO load_info = {0};
+    if (config_mgr_load_alarm(clock_info->config_mgr, load_alarms_cb, &load_info) != 0)
+    {
+        log_error("Failure loading alarms from config file");
+        result = __LINE__;
+    }
+    else
+    {
+        // Hand the scheduler every alarm at once so it only sizes its storage
+        // once.  The batch is all or nothing, so when one alarm is bad the
+        // rest are added one at a time.
+        if (load_info.alarm_count > 0 && alarm_scheduler_add_alarms(clock_info->sched_mgr, load_info.alarm_list, load_info.alarm_count) != 0)
+        {
+            log_warning("Failure adding alarms to the scheduler in one batch");
+            for (size_t index = 0; index < load_info.alarm_count; index++)
+            {
+                if (alarm_scheduler_add_alarm_info(clock_info->sched_mgr, &load_info.alarm_list[index]) != 0)
+                {
+                    log_error("Failure adding alarm %s", load_info.alarm_list[index].alarm_text);
+                }
+            }
+        }
+        result = 0;
+    }
+    if (load_info.alarm_list != NULL)
+    {
+        free(load_info.alarm_list);
+    }
+    return result;
+}
+
 static int parse_command_line(int argc, char* argv[], SMARTCLOCK_INFO* clock_info)
 {
     int result = 0;
@@ -553,16 +824,45 @@ int initialize_data(SMARTCLOCK_INFO* clock_info)
         gui_mgr_destroy(clock_info->gui_mgr);
         result = __LINE__;
     }
+    else if ((clock_info->event_loop = event_loop_create()) == NULL)
+    {
+        log_error("Failure creating event loop object");
+#ifdef USE_NTP_CLIENT
+        ntp_client_destroy(clock_info->ntp_client);
+#endif
+        config_mgr_destroy(clock_info->config_mgr);
+        sound_mgr_destroy(clock_info->sound_mgr);
+        alarm_scheduler_destroy(clock_info->sched_mgr);
+        gui_mgr_destroy(clock_info->gui_mgr);
+        weather_client_destroy(clock_info->weather_client);
+        result = __LINE__;
+    }
     else
     {
         (void)alarm_timer_init(&clock_info->weather_timer);
         (void)alarm_timer_init(&clock_info->ntp_alarm);
         (void)alarm_timer_init(&clock_info->max_alarm_len);
+        (void)alarm_timer_init(&clock_info->latency_log_timer);
         result = 0;
     }
     return result;
 }
 
+const LATENCY_HISTOGRAM* smartclock_get_alarm_latency(ALARM_LATENCY_STAGE stage)
+{
+    const LATENCY_HISTOGRAM* result;
+    if (stage >= ALARM_LATENCY_STAGE_COUNT)
+    {
+        log_error("Invalid latency stage specified %d", (int)stage);
+        result = NULL;
+    }
+    else
+    {
+        result = &g_alarm_latency[stage];
+    }
+    return result;
+}
+
 int run_application(int argc, char* argv[])
 {
     int result;
@@ -580,7 +880,7 @@ int run_application(int argc, char* argv[])
     }
     else
     {
-        if (config_mgr_load_alarm(clock_info.config_mgr, load_alarms_cb, clock_info.sched_mgr) != 0)
+        if (load_alarms(&clock_info) != 0)
         {
             log_error("Failure loading alarms from config file");
             result = __LINE__;
@@ -605,16 +905,28 @@ int run_application(int argc, char* argv[])
             }
 
             clock_info.is_demo_mode = config_mgr_is_demo_mode(clock_info.config_mgr);
+            clock_info.alarm_prepare_lead = config_mgr_get_alarm_prepare_time(clock_info.config_mgr);
+            if (sound_mgr_set_cache_limit(clock_info.sound_mgr, (size_t)config_mgr_get_sound_cache_size(clock_info.config_mgr)*1024) != 0)
+            {
+                log_warning("Failure setting the sound cache size");
+            }
+            clock_info.crescendo_time = config_mgr_get_crescendo_time(clock_info.config_mgr);
+            if (clock_info.crescendo_time > 0 && sound_mgr_set_crescendo(clock_info.sound_mgr, SOUND_CRESCENDO_LOUDNESS, clock_info.crescendo_time*1000) != 0)
+            {
+                log_warning("Failure setting the alarm crescendo");
+            }
+            register_gui_input(&clock_info);
 
             // Get the inital weather
             check_ntp_operation(&clock_info);
             check_weather_operation(&clock_info, curr_time->tm_yday);
 
-            (void)alarm_timer_start(&clock_info.ntp_alarm, MAX_TIME_DIFFERENCE);
+            (void)alarm_timer_start(&clock_info.ntp_alarm, NTP_CLIENT_MIN_POLL_SEC);
             (void)alarm_timer_start(&clock_info.weather_timer, MAX_WEATHER_DIFF);
+            (void)alarm_timer_start(&clock_info.latency_log_timer, LATENCY_LOG_INTERVAL);
 
             // Show the next alarm
-            gui_mgr_set_next_alarm(clock_info.gui_mgr, alarm_scheduler_get_next_alarm(clock_info.sched_mgr));
+            show_next_alarm(&clock_info);
             refresh_time = gui_mgr_get_refresh_resolution();
 
             do
@@ -627,7 +939,7 @@ int run_application(int argc, char* argv[])
                 check_weather_operation(&clock_info, curr_time->tm_yday);
 
                 // Get the current time value
-                check_alarm_operation(&clock_info, curr_time);
+                check_alarm_operation(&clock_info);
 
                 // Check the shades
                 adjust_shades(&clock_info, curr_time);
@@ -635,7 +947,8 @@ int run_application(int argc, char* argv[])
                 gui_mgr_set_time_item(clock_info.gui_mgr, curr_time);
                 gui_mgr_process_items(clock_info.gui_mgr);
 
-                thread_mgr_sleep(refresh_time);
+                // Sleep until the display, an alarm or the user needs us
+                wait_for_next_event(&clock_info, refresh_time);
             } while (g_run_application);
             result = 0;
         }
@@ -648,6 +961,7 @@ int run_application(int argc, char* argv[])
         alarm_scheduler_destroy(clock_info.sched_mgr);
         config_mgr_destroy(clock_info.config_mgr);
         weather_client_destroy(clock_info.weather_client);
+        event_loop_destroy(clock_info.event_loop);
         free(clock_info.config_path);
     }
     return result;
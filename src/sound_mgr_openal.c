@@ -3,18 +3,50 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "lib-util-c/sys_debug_shim.h"
 #include "lib-util-c/app_logging.h"
 #include "lib-util-c/crt_extensions.h"
 #include "lib-util-c/file_mgr.h"
 #include "sound_mgr.h"
+#include "sample_convert.h"
 
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/alut.h>
 
+#define MAX_CACHED_SOUNDS           16
+#define DEFAULT_SOUND_CACHE_LIMIT   (8*1024*1024)
+
+// Files over STREAM_MIN_FILE_SIZE are played through a ring of small queued
+// buffers, which holds over a second of 44.1kHz stereo audio
+#define STREAM_MIN_FILE_SIZE        (512*1024)
+#define STREAM_BUFFER_COUNT         6
+#define STREAM_BUFFER_SIZE          (32*1024)
+
+// The crescendo starts at the old fixed crescendo volume and moves the gain
+// every GAIN_RAMP_INTERVAL_MS, OpenAL smooths each step over a mix update
+#define CRESCENDO_START_GAIN        0.1f
+#define DEFAULT_CRESCENDO_TIME      30000
+#define GAIN_RAMP_INTERVAL_MS       50
+
+typedef struct SOUND_CACHE_ENTRY_TAG
+{
+    char* sound_file;
+    time_t modify_time;
+    ALuint sound_buf;
+    size_t buffer_size;
+    uint32_t last_used;
+} SOUND_CACHE_ENTRY;
+
 typedef struct SOUND_MGR_INFO_TAG
 {
     SOUND_MGR_STATE sound_state;
@@ -24,23 +56,61 @@ typedef struct SOUND_MGR_INFO_TAG
     size_t wav_size;
     float volume;
 
+    // File already decoded into sound_buf and attached to source
+    char* prepared_file;
+
     ALuint source;
     ALuint sound_buf;
+
+    // Decoded buffers outlive the source so replaying a sound skips the
+    // file, the least recently used one goes first once over the limit
+    SOUND_CACHE_ENTRY sound_cache[MAX_CACHED_SOUNDS];
+    size_t cache_limit;
+    size_t cache_size;
+    uint32_t cache_clock;
+
+    // Streaming state, stream_chunk is only set while a file is streaming
+    FILE_MGR_HANDLE stream_file;
+    unsigned char* stream_chunk;
+    ALuint stream_bufs[STREAM_BUFFER_COUNT];
+    // Ring buffers off the queue, they wait here until there are samples for them
+    ALuint stream_free[STREAM_BUFFER_COUNT];
+    size_t stream_free_count;
+    ALenum stream_format;
+    int stream_sample_rate;
+    short stream_block_align;
+    // 16 bit samples that need an endian swap
+    bool stream_swapped;
+    bool stream_repeat;
+    size_t stream_data_offset;
+    size_t stream_data_size;
+    size_t stream_remaining;
+    size_t stream_pending;
+
+    // Crescendo ramp, gain_thread is only valid while gain_running is set.
+    // gain_lock guards volume and gain_stop against the ramp thread
+    SOUND_CRESCENDO_CURVE crescendo_curve;
+    uint32_t crescendo_time;
+    pthread_t gain_thread;
+    pthread_mutex_t gain_lock;
+    pthread_cond_t gain_cond;
+    bool gain_running;
+    bool gain_stop;
 } SOUND_MGR_INFO;
 
 #define RIFF_ID     0x46464952 // 'RIFF'
 #define FMT_ID      0x20746D66 // 'FMT '
 #define DATA_ID     0x61746164 // 'DATA'
 
-#define SWAP_32(value)                 \
-        (((((unsigned short)value)<<8) & 0xFF00)   | \
-         ((((unsigned short)value)>>8) & 0x00FF))
+#define SWAP_16(value)                 \
+        (((((unsigned short)(value))<<8) & 0xFF00)   | \
+         ((((unsigned short)(value))>>8) & 0x00FF))
 
-#define SWAP_16(value)                     \
-        (((((unsigned int)value)<<24) & 0xFF000000)  | \
-         ((((unsigned int)value)<< 8) & 0x00FF0000)  | \
-         ((((unsigned int)value)>> 8) & 0x0000FF00)  | \
-         ((((unsigned int)value)>>24) & 0x000000FF))
+#define SWAP_32(value)                     \
+        (((((unsigned int)(value))<<24) & 0xFF000000)  | \
+         ((((unsigned int)(value))<< 8) & 0x00FF0000)  | \
+         ((((unsigned int)(value))>> 8) & 0x0000FF00)  | \
+         ((((unsigned int)(value))>>24) & 0x000000FF))
 
 typedef struct chunk_header_tag
 {
@@ -124,7 +194,7 @@ static void deinitialize_openai(SOUND_MGR_INFO* sound_info)
 static const char* find_data_chunk(const unsigned char* file_begin, const unsigned char* file_end, int desired_id, int swapped)
 {
     const unsigned char* result = NULL;
-    while (file_begin < file_end)
+    while (file_begin + sizeof(chunk_header) <= file_end)
     {
         chunk_header* h = (chunk_header *)file_begin;
         if (h->id == desired_id && !swapped)
@@ -132,27 +202,65 @@ static const char* find_data_chunk(const unsigned char* file_begin, const unsign
             result = file_begin + sizeof(chunk_header);
             break;
         }
-        if (h->id == SWAP_32(desired_id) && swapped)
+        if (h->id == (int)SWAP_32(desired_id) && swapped)
         {
             result = file_begin + sizeof(chunk_header);
             break;
         }
-        int chunk_size = swapped ? SWAP_32(h->size) : h->size;
-        const unsigned char *next = file_begin + chunk_size + sizeof(chunk_header);
-        if (next > file_end || next <= file_begin)
+        size_t chunk_size = swapped ? SWAP_32(h->size) : (unsigned int)h->size;
+        // Compare sizes, a bogus size would wrap the pointer
+        if (chunk_size > (size_t)(file_end - file_begin) - sizeof(chunk_header))
         {
             break;
         }
-        file_begin = next;
+        file_begin += sizeof(chunk_header) + chunk_size;
     }
     return (const char*)result;
 }
 
-// Given a chunk, find its end by going back to the header.
-static const char* chunk_end(const char* chunk_start, int swapped)
+// Given a chunk, find the size it claims by going back to the header.  The
+// size is unchecked, clamp it to the bytes actually held.
+static size_t get_chunk_size(const char* chunk_start, int swapped)
+{
+    const chunk_header* h = (const chunk_header*)(chunk_start - sizeof(chunk_header));
+    return swapped ? SWAP_32(h->size) : (unsigned int)h->size;
+}
+
+static int read_wav_format(const char* format, int swapped, format_info* fmt_info)
 {
-    chunk_header* h = (chunk_header*)(chunk_start - sizeof(chunk_header));
-    return chunk_start + (swapped ? SWAP_32(h->size) : h->size);
+    int result;
+    memcpy(fmt_info, format, sizeof(format_info));
+    if (swapped)
+    {
+        fmt_info->format = SWAP_16(fmt_info->format);
+        fmt_info->num_channels = SWAP_16(fmt_info->num_channels);
+        fmt_info->sample_rate = SWAP_32(fmt_info->sample_rate);
+        fmt_info->byte_rate = SWAP_32(fmt_info->byte_rate);
+        fmt_info->block_align = SWAP_16(fmt_info->block_align);
+        fmt_info->bits_per_sample = SWAP_16(fmt_info->bits_per_sample);
+    }
+
+    // Reject things we don't understand...expand this code to support weirder audio formats.
+    if (fmt_info->format != 1)
+    {
+        log_error("Wave file is not PCM format data");
+        result = __LINE__;
+    }
+    else if (fmt_info->num_channels != 1 && fmt_info->num_channels != 2)
+    {
+        log_error("Must have mono or stereo sound");
+        result = __LINE__;
+    }
+    else if (fmt_info->bits_per_sample != 8 && fmt_info->bits_per_sample != 16)
+    {
+        log_error("Must have 8 or 16 bit sounds");
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
 }
 
 static int validate_wav_data(unsigned char* wav_buffer, long wav_size, format_info* fmt_info, const unsigned char** wav_data, int* swapped)
@@ -187,6 +295,13 @@ static int validate_wav_data(unsigned char* wav_buffer, long wav_size, format_in
     if (result == 0)
     {
         const char* format;
+        // Don't search past the end of a truncated file
+        size_t riff_size = get_chunk_size(riff, *swapped);
+        const unsigned char* riff_end = wav_end;
+        if (riff_size < (size_t)(wav_end - (const unsigned char*)riff))
+        {
+            riff_end = (const unsigned char*)riff + riff_size;
+        }
 
         // The wave chunk isn't really a chunk at all. :-(  It's just a "WAVE" tag
         // followed by more chunks.  This strikes me as totally inconsistent, but
@@ -196,346 +311,1159 @@ static int validate_wav_data(unsigned char* wav_buffer, long wav_size, format_in
             log_error("Could not find WAVE signature in wave file");
             result = __LINE__;
         }
-        else if ((format = find_data_chunk((const unsigned char*)riff+4, (const unsigned char*)chunk_end(riff, *swapped), FMT_ID, *swapped)) == NULL)
+        else if ((format = find_data_chunk((const unsigned char*)riff+4, riff_end, FMT_ID, *swapped)) == NULL)
         {
             log_error("Could not find FMT chunk in wave file");
             result = __LINE__;
         }
+        else if (read_wav_format(format, *swapped, fmt_info) != 0)
+        {
+            result = __LINE__;
+        }
+        else if ((*wav_data = (const unsigned char*)find_data_chunk((const unsigned char*)riff+4, riff_end, DATA_ID, *swapped)) == NULL)
+        {
+            log_error("Could not find the DATA chunk");
+            result = __LINE__;
+        }
         else
         {
-            memcpy(fmt_info, format, sizeof(format_info));
-            if (*swapped)
-            {
-                fmt_info->format = SWAP_16(fmt_info->format);
-                fmt_info->num_channels = SWAP_16(fmt_info->num_channels);
-                fmt_info->sample_rate = SWAP_32(fmt_info->sample_rate);
-                fmt_info->byte_rate = SWAP_32(fmt_info->byte_rate);
-                fmt_info->block_align = SWAP_16(fmt_info->block_align);
-                fmt_info->bits_per_sample = SWAP_16(fmt_info->bits_per_sample);
-            }
-
-            // Reject things we don't understand...expand this code to support weirder audio formats.
-            if (fmt_info->format != 1)
-            {
-                log_error("Wave file is not PCM format data");
-                result = __LINE__;
-            }
-            else if (fmt_info->num_channels != 1 && fmt_info->num_channels != 2)
-            {
-                log_error("Must have mono or stereo sound");
-                result = __LINE__;
-            }
-            else if (fmt_info->bits_per_sample != 8 && fmt_info->bits_per_sample != 16)
-            {
-                log_error("Must have 8 or 16 bit sounds");
-                result = __LINE__;
-            }
-            else if ((*wav_data = (const unsigned char*)find_data_chunk((const unsigned char*)riff+4, (const unsigned char*)chunk_end(riff, *swapped), DATA_ID, *swapped)) == NULL)
-            {
-                log_error("Could not find the DATA chunk");
-                result = __LINE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            result = 0;
         }
     }
     return result;
 }
 
-static unsigned char* retrieve_wav_data(const char* filename, long* wav_size)
+static unsigned char* retrieve_wav_data(FILE_MGR_HANDLE file_mgr, size_t wav_size)
 {
     unsigned char* result;
-    FILE_MGR_HANDLE file_mgr;
-    if ((file_mgr = file_mgr_open(filename, "rb")) == NULL)
+    if ((result = (unsigned char*)malloc(wav_size)) == NULL)
     {
-        log_error("Failure loading wav");
+        log_error("Failure allocating wav file");
+    }
+    else if (file_mgr_read(file_mgr, result, wav_size) != wav_size)
+    {
+        log_error("Failure reading wav file");
+        free(result);
         result = NULL;
     }
+    return result;
+}
+
+static ALenum get_openal_format(const format_info* fmt_info)
+{
+    return fmt_info->bits_per_sample == 16 ?
+        (fmt_info->num_channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16) :
+        (fmt_info->num_channels == 2 ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8);
+}
+
+static time_t get_file_modify_time(const char* sound_file)
+{
+    time_t result;
+    struct stat file_stat;
+    if (stat(sound_file, &file_stat) != 0)
+    {
+        // Let a cached copy keep playing if the file goes missing
+        result = 0;
+    }
     else
     {
-        if ((*wav_size = file_mgr_get_length(file_mgr)) == 0)
+        result = file_stat.st_mtime;
+    }
+    return result;
+}
+
+static void remove_cached_sound(SOUND_MGR_INFO* sound_info, SOUND_CACHE_ENTRY* cache_entry)
+{
+    alDeleteBuffers(1, &cache_entry->sound_buf);
+    sound_info->cache_size -= cache_entry->buffer_size;
+    free(cache_entry->sound_file);
+    memset(cache_entry, 0, sizeof(SOUND_CACHE_ENTRY));
+}
+
+static SOUND_CACHE_ENTRY* get_oldest_cached_sound(SOUND_MGR_INFO* sound_info)
+{
+    SOUND_CACHE_ENTRY* result = NULL;
+    for (size_t index = 0; index < MAX_CACHED_SOUNDS; index++)
+    {
+        SOUND_CACHE_ENTRY* cache_entry = &sound_info->sound_cache[index];
+        // The buffer attached to the source can't be deleted
+        if (cache_entry->sound_file != NULL && cache_entry->sound_buf != sound_info->sound_buf &&
+            (result == NULL || cache_entry->last_used < result->last_used))
         {
-            log_error("Invalid file size found");
-            result = NULL;
+            result = cache_entry;
         }
-        else if ((result = (unsigned char*)malloc(*wav_size)) == NULL)
+    }
+    return result;
+}
+
+static void trim_sound_cache(SOUND_MGR_INFO* sound_info, size_t cache_limit)
+{
+    SOUND_CACHE_ENTRY* cache_entry;
+    while (sound_info->cache_size > cache_limit && (cache_entry = get_oldest_cached_sound(sound_info)) != NULL)
+    {
+        remove_cached_sound(sound_info, cache_entry);
+    }
+}
+
+static SOUND_CACHE_ENTRY* find_cached_sound(SOUND_MGR_INFO* sound_info, const char* sound_file, time_t modify_time)
+{
+    SOUND_CACHE_ENTRY* result = NULL;
+    for (size_t index = 0; index < MAX_CACHED_SOUNDS; index++)
+    {
+        SOUND_CACHE_ENTRY* cache_entry = &sound_info->sound_cache[index];
+        if (cache_entry->sound_file != NULL && strcmp(cache_entry->sound_file, sound_file) == 0)
         {
-            log_error("Failure allocating wav file");
-            result = NULL;
+            if (cache_entry->modify_time != modify_time)
+            {
+                // The file changed since it was decoded
+                remove_cached_sound(sound_info, cache_entry);
+            }
+            else
+            {
+                cache_entry->last_used = ++sound_info->cache_clock;
+                result = cache_entry;
+            }
+            break;
         }
-        else if (file_mgr_read(file_mgr, result, *wav_size) != (size_t)*wav_size)
+    }
+    return result;
+}
+
+static SOUND_CACHE_ENTRY* add_cached_sound(SOUND_MGR_INFO* sound_info, const char* sound_file, time_t modify_time, ALuint sound_buf, size_t buffer_size)
+{
+    SOUND_CACHE_ENTRY* result = NULL;
+    for (size_t index = 0; index < MAX_CACHED_SOUNDS; index++)
+    {
+        if (sound_info->sound_cache[index].sound_file == NULL)
         {
-            log_error("Failure reading wav file");
-            free(result);
-            result = NULL;
+            result = &sound_info->sound_cache[index];
+            break;
         }
-        file_mgr_close(file_mgr);
+    }
+    if (result == NULL && (result = get_oldest_cached_sound(sound_info)) != NULL)
+    {
+        remove_cached_sound(sound_info, result);
+    }
+
+    if (result == NULL)
+    {
+        log_error("Failure finding a free sound cache entry");
+    }
+    else if (clone_string(&result->sound_file, sound_file) != 0)
+    {
+        log_error("Failure copying sound file name");
+        result = NULL;
+    }
+    else
+    {
+        result->modify_time = modify_time;
+        result->sound_buf = sound_buf;
+        result->buffer_size = buffer_size;
+        result->last_used = ++sound_info->cache_clock;
+        sound_info->cache_size += buffer_size;
     }
     return result;
 }
 
-static int construct_buffer_data(SOUND_MGR_INFO* sound_info, format_info* fmt_info, bool repeat)
+static int create_sound_buffer(SOUND_MGR_INFO* sound_info, format_info* fmt_info, ALuint* sound_buf)
 {
     int result;
 
     //ALenum error;
-    alGenBuffers(1, &sound_info->sound_buf);
-    if (sound_info->sound_buf == 0)
+    alGenBuffers(1, sound_buf);
+    if (*sound_buf == 0)
     {
         log_error("Could not generate buffer id");
         result = __LINE__;
     }
     else
     {
-        alBufferData(sound_info->sound_buf, fmt_info->bits_per_sample == 16 ?
-            (fmt_info->num_channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16) :
-            (fmt_info->num_channels == 2 ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8),
-            sound_info->wav_data, sound_info->wav_size, fmt_info->sample_rate);
+        alBufferData(*sound_buf, get_openal_format(fmt_info), sound_info->wav_data, sound_info->wav_size, fmt_info->sample_rate);
         if (!validate_openal_error("Failure constructing sound data Buffer") )
         {
+            alDeleteBuffers(1, sound_buf);
             result = __LINE__;
         }
         else
         {
-            // Attach the buffers to a source
-            alGenSources(1, &sound_info->source);
-            if (!validate_openal_error("Failure generating sources") )
-            {
-                result = __LINE__;
-            }
-            else
-            {
-                alSourcei(sound_info->source, AL_BUFFER, sound_info->sound_buf);
-                if (!validate_openal_error("Failure setting up source buffer") )
-                {
-                    result = __LINE__;
-                }
-                else
-                {
-                    ALfloat sourcePos[] = { -2.0, 0.0, 0.0};
-                    ALfloat sourceVel[] = { 0.0, 0.0, 0.0};
-
-                    ALfloat listenerPos[] = {0.0,0.0,4.0};
-                    ALfloat listenerVel[] = {0.0,0.0,0.0};
-                    ALfloat listenerOri[] = {0.0,0.0,1.0, 0.0,1.0,0.0};
-
-                    alSourcefv(sound_info->source, AL_POSITION, sourcePos);
-                    validate_openal_error("Failure setting Sound Position");
-                    alSourcefv(sound_info->source, AL_VELOCITY, sourceVel);
-                    validate_openal_error("Failure setting Sound Velocity");
-                    alSourcef(sound_info->source, AL_GAIN, sound_info->volume);
-                    validate_openal_error("Failure setting Sound Gain");
-                    alSourcef(sound_info->source, AL_PITCH, 1.0f);
-                    validate_openal_error("Failure setting Sound Pitch");
-                    alSourcei(sound_info->source, AL_LOOPING, repeat ? AL_TRUE : AL_FALSE);
-                    validate_openal_error("Failure setting Sound Looping");
-                    //alSourcefv(source, AL_DIRECTION, sourceOri);
-
-                    alListenerfv(AL_POSITION, listenerPos);
-                    validate_openal_error("Failure setting Sound Position");
-                    alListenerfv(AL_VELOCITY, listenerVel);
-                    validate_openal_error("Failure setting Listen Sound Velocity");
-                    alListenerfv(AL_ORIENTATION, listenerOri);
-                    validate_openal_error("Failure setting Listen Sound Orientation");
-                    result = 0;
-                }
-            }
+            result = 0;
         }
     }
     return result;
 }
 
-static void clean_audio_items(SOUND_MGR_INFO* sound_info)
+static int create_audio_objects(SOUND_MGR_INFO* sound_info)
 {
-    if (sound_info->source != 0)
-    {
-        alDeleteSources(1, &sound_info->source);
-    }
-    if (sound_info->sound_buf != 0)
-    {
-        alDeleteBuffers(1, &sound_info->sound_buf);
-    }
-}
+    int result;
 
-SOUND_MGR_HANDLE sound_mgr_create(void)
-{
-    SOUND_MGR_INFO* result;
-    if ((result = (SOUND_MGR_INFO*)malloc(sizeof(SOUND_MGR_INFO))) == NULL)
+    // The source, its placement and the stream ring live as long as the
+    // manager, a play only swaps the buffers attached to the source
+    alGenSources(1, &sound_info->source);
+    if (!validate_openal_error("Failure generating sources") )
     {
-        log_error("Failure unable to allocate alarm scheduler");
+        sound_info->source = 0;
+        result = __LINE__;
     }
     else
     {
-        memset(result, 0, sizeof(SOUND_MGR_INFO));
+        ALfloat sourcePos[] = { -2.0, 0.0, 0.0};
+        ALfloat sourceVel[] = { 0.0, 0.0, 0.0};
 
-        // Initialize the environment
-        if (initialize_openai(result) != 0)
+        ALfloat listenerPos[] = {0.0,0.0,4.0};
+        ALfloat listenerVel[] = {0.0,0.0,0.0};
+        ALfloat listenerOri[] = {0.0,0.0,1.0, 0.0,1.0,0.0};
+
+        alSourcefv(sound_info->source, AL_POSITION, sourcePos);
+        validate_openal_error("Failure setting Sound Position");
+        alSourcefv(sound_info->source, AL_VELOCITY, sourceVel);
+        validate_openal_error("Failure setting Sound Velocity");
+        alSourcef(sound_info->source, AL_PITCH, 1.0f);
+        validate_openal_error("Failure setting Sound Pitch");
+        //alSourcefv(source, AL_DIRECTION, sourceOri);
+
+        alListenerfv(AL_POSITION, listenerPos);
+        validate_openal_error("Failure setting Sound Position");
+        alListenerfv(AL_VELOCITY, listenerVel);
+        validate_openal_error("Failure setting Listen Sound Velocity");
+        alListenerfv(AL_ORIENTATION, listenerOri);
+        validate_openal_error("Failure setting Listen Sound Orientation");
+
+        alGenBuffers(STREAM_BUFFER_COUNT, sound_info->stream_bufs);
+        if (!validate_openal_error("Failure generating stream buffers"))
         {
-            log_error("Failure initializing audio system");
-            free(result);
-            result = NULL;
+            memset(sound_info->stream_bufs, 0, sizeof(sound_info->stream_bufs));
+            alDeleteSources(1, &sound_info->source);
+            sound_info->source = 0;
+            result = __LINE__;
         }
         else
         {
-            result->volume = 1.0;
+            result = 0;
         }
     }
     return result;
 }
 
-void sound_mgr_destroy(SOUND_MGR_HANDLE handle)
+static void destroy_audio_objects(SOUND_MGR_INFO* sound_info)
 {
-    if (handle != NULL)
-    {
-        clean_audio_items(handle);
+    alDeleteSources(1, &sound_info->source);
+    sound_info->source = 0;
+    alDeleteBuffers(STREAM_BUFFER_COUNT, sound_info->stream_bufs);
+    memset(sound_info->stream_bufs, 0, sizeof(sound_info->stream_bufs));
+}
 
-        // Exit everything
-        deinitialize_openai(handle);
+static int construct_sound_source(SOUND_MGR_INFO* sound_info, ALuint sound_buf)
+{
+    int result;
 
-        free(handle);
+    // Attach the buffers to the source
+    sound_info->sound_buf = sound_buf;
+    alSourcei(sound_info->source, AL_BUFFER, sound_info->sound_buf);
+    if (!validate_openal_error("Failure setting up source buffer") )
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
     }
+    return result;
 }
 
-int sound_mgr_play(SOUND_MGR_HANDLE handle, const char* sound_file, bool set_repeat, bool crescendo)
+static int initialize_gain_ramp(SOUND_MGR_INFO* sound_info)
 {
     int result;
-    if (handle == NULL || sound_file == NULL)
+    pthread_condattr_t cond_attr;
+    if (pthread_condattr_init(&cond_attr) != 0)
     {
-        log_error("Invalid argument specified: handle: %p, sound_file: %p", handle, sound_file);
+        log_error("Failure initializing gain ramp condition attributes");
         result = __LINE__;
     }
     else
     {
-        // If we're playing a wav then we need to stop playing it
-        // before we play another
-        if (handle->sound_state == SOUND_STATE_PLAYING)
-        {
-
-        }
-
-        if (crescendo)
+        // Timed waits use the monotonic clock so a clock change can't stall the ramp
+        if (pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC) != 0)
         {
-            handle->volume = 0.1;
-        }
-        else
-        {
-            handle->volume = 1.0;
+            log_error("Failure setting gain ramp clock");
+            result = __LINE__;
         }
-
-        unsigned char* wav_buffer;
-        format_info fmt_info = {0};
-        int swapped;
-        if ((wav_buffer = retrieve_wav_data(sound_file, (long*)&handle->wav_size)) == NULL)
+        else if (pthread_cond_init(&sound_info->gain_cond, &cond_attr) != 0)
         {
-            log_error("Failure opening wav file");
+            log_error("Failure initializing gain ramp condition");
             result = __LINE__;
         }
-        else if (validate_wav_data(wav_buffer, handle->wav_size, &fmt_info, &handle->wav_data, &swapped) != 0)
+        else if (pthread_mutex_init(&sound_info->gain_lock, NULL) != 0)
         {
-            free(wav_buffer);
-            log_error("Failure validating wav data");
+            log_error("Failure initializing gain ramp lock");
+            pthread_cond_destroy(&sound_info->gain_cond);
             result = __LINE__;
         }
         else
         {
-            int sample_size = fmt_info.num_channels * fmt_info.bits_per_sample / 8;
-            handle->wav_size = chunk_end((const char*)handle->wav_data, swapped) - (const char*)handle->wav_data;
-            int data_samples = handle->wav_size / sample_size;
-
-            // If the file is swapped and we have 16-bit audio, we need to endian-swap the audio too or we'll
-            // get something that sounds just astoundingly bad!
-            if (fmt_info.bits_per_sample == 16 && swapped)
-            {
-                short* ptr = (short*)handle->wav_data;
-                int words = data_samples * fmt_info.num_channels;
-                while(words--)
-                {
-                    *ptr = SWAP_16(*ptr);
-                    ++ptr;
-                }
-            }
-
-            if (construct_buffer_data(handle, &fmt_info, set_repeat) != 0)
-            {
-                log_error("Failure construting buffer data");
-                result = __LINE__;
-            }
-            else
-            {
-                alSourcePlay(handle->source);
-                handle->sound_state = SOUND_STATE_PLAYING;
-                result = 0;
-            }
-            free(wav_buffer);
+            result = 0;
         }
+        pthread_condattr_destroy(&cond_attr);
     }
     return result;
 }
 
-int sound_mgr_stop(SOUND_MGR_HANDLE handle)
+static float get_crescendo_gain(SOUND_CRESCENDO_CURVE curve, float progress)
 {
-    int result;
-    if (handle == NULL)
+    float shape;
+    switch (curve)
     {
-        log_error("Invalid argument specified: handle: %p", handle);
-        result = __LINE__;
-    }
-    else if (handle->sound_state != SOUND_STATE_PLAYING)
-    {
-        log_error("Sound is no longer playing");
-        handle->sound_state = SOUND_STATE_IDLE;
-        result = __LINE__;
+        case SOUND_CRESCENDO_LOUDNESS:
+            // Loudness follows roughly the cube root of the amplitude, so this
+            // rises evenly to the ear where a linear ramp jumps out early
+            shape = progress*progress*progress;
+            break;
+        case SOUND_CRESCENDO_S_CURVE:
+            shape = progress*progress*(3.0f - 2.0f*progress);
+            break;
+        case SOUND_CRESCENDO_LINEAR:
+        default:
+            shape = progress;
+            break;
     }
-    else
+    return CRESCENDO_START_GAIN + (1.0f - CRESCENDO_START_GAIN)*shape;
+}
+
+static void* gain_ramp_thread(void* context)
+{
+    SOUND_MGR_INFO* sound_info = (SOUND_MGR_INFO*)context;
+    uint32_t step_count = sound_info->crescendo_time/GAIN_RAMP_INTERVAL_MS;
+    struct timespec wake_time;
+    clock_gettime(CLOCK_MONOTONIC, &wake_time);
+
+    pthread_mutex_lock(&sound_info->gain_lock);
+    for (uint32_t step = 1; step <= step_count && !sound_info->gain_stop; step++)
     {
-        //ALenum current_playing_state;
-        //alGetSourcei(handle->source, AL_SOURCE_STATE, &current_playing_state);
-        //alSourcei(handle->sourceId, AL_BUFFER, AL_NONE);
-        alSourceStop(handle->source);
-        clean_audio_items(handle);
-        handle->sound_state = SOUND_STATE_IDLE;
-        result = 0;
+        // Absolute deadlines so late wake ups don't stretch the ramp
+        wake_time.tv_nsec += GAIN_RAMP_INTERVAL_MS*1000000L;
+        if (wake_time.tv_nsec >= 1000000000L)
+        {
+            wake_time.tv_sec++;
+            wake_time.tv_nsec -= 1000000000L;
+        }
+        while (!sound_info->gain_stop &&
+            pthread_cond_timedwait(&sound_info->gain_cond, &sound_info->gain_lock, &wake_time) != ETIMEDOUT)
+        {
+        }
+        if (!sound_info->gain_stop)
+        {
+            alSourcef(sound_info->source, AL_GAIN, sound_info->volume*get_crescendo_gain(sound_info->crescendo_curve, (float)step/step_count));
+        }
     }
-    return result;
+    // Marks the ramp finished so volume changes go straight to the source
+    sound_info->gain_stop = true;
+    pthread_mutex_unlock(&sound_info->gain_lock);
+    return NULL;
 }
 
-SOUND_MGR_STATE sound_mgr_get_current_state(SOUND_MGR_HANDLE handle)
+static void start_gain_ramp(SOUND_MGR_INFO* sound_info)
 {
-    SOUND_MGR_STATE result;
-    if (handle == NULL)
+    sound_info->gain_stop = false;
+    if (pthread_create(&sound_info->gain_thread, NULL, gain_ramp_thread, sound_info) != 0)
     {
-        log_error("Invalid argument specified: handle: %p", handle);
-        result = SOUND_STATE_ERROR;
+        log_warning("Failure starting the crescendo, playing at full volume");
+        alSourcef(sound_info->source, AL_GAIN, sound_info->volume);
     }
     else
     {
-        result = handle->sound_state;
+        sound_info->gain_running = true;
     }
-    return result;
 }
 
-int sound_mgr_set_volume(SOUND_MGR_HANDLE handle, float volume)
+static void stop_gain_ramp(SOUND_MGR_INFO* sound_info)
 {
-    int result;
-    if (handle == NULL)
+    if (sound_info->gain_running)
     {
-        log_error("Invalid argument specified handle: NULL");
-        result = __LINE__;
+        pthread_mutex_lock(&sound_info->gain_lock);
+        sound_info->gain_stop = true;
+        pthread_cond_signal(&sound_info->gain_cond);
+        pthread_mutex_unlock(&sound_info->gain_lock);
+        pthread_join(sound_info->gain_thread, NULL);
+        sound_info->gain_running = false;
     }
-    else if (volume < 0.0 || volume > 1.0)
+}
+
+static void close_sound_stream(SOUND_MGR_INFO* sound_info)
+{
+    if (sound_info->stream_file != NULL)
     {
-        log_error("The volume is not within range of 0.0 - 1.0");
-        result = __LINE__;
+        file_mgr_close(sound_info->stream_file);
+        sound_info->stream_file = NULL;
+    }
+    if (sound_info->stream_chunk != NULL)
+    {
+        free(sound_info->stream_chunk);
+        sound_info->stream_chunk = NULL;
+    }
+}
+
+static void clean_audio_items(SOUND_MGR_INFO* sound_info)
+{
+    // The ramp thread uses the source, so it has to be gone first
+    stop_gain_ramp(sound_info);
+    if (sound_info->sound_buf != 0 || sound_info->stream_chunk != NULL)
+    {
+        // Detaching also drops any queued stream buffers, the source is
+        // stopped or was never started
+        alSourcei(sound_info->source, AL_BUFFER, AL_NONE);
+        validate_openal_error("Failure detaching source buffer");
+    }
+    close_sound_stream(sound_info);
+    // The buffer stays in the cache for the next play
+    sound_info->sound_buf = 0;
+    if (sound_info->prepared_file != NULL)
+    {
+        free(sound_info->prepared_file);
+        sound_info->prepared_file = NULL;
+    }
+    trim_sound_cache(sound_info, sound_info->cache_limit);
+}
+
+// file_mgr can't seek, so skipping means reading through
+static int skip_stream_bytes(SOUND_MGR_INFO* sound_info, size_t skip_len)
+{
+    int result = 0;
+    while (skip_len > 0 && result == 0)
+    {
+        size_t read_len = skip_len < STREAM_BUFFER_SIZE ? skip_len : STREAM_BUFFER_SIZE;
+        if (file_mgr_read(sound_info->stream_file, sound_info->stream_chunk, read_len) != read_len)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            skip_len -= read_len;
+        }
+    }
+    return result;
+}
+
+static int rewind_sound_stream(SOUND_MGR_INFO* sound_info)
+{
+    int result;
+    // file_mgr can't seek, so reopen the file and read past the header
+    file_mgr_close(sound_info->stream_file);
+    if ((sound_info->stream_file = file_mgr_open(sound_info->prepared_file, "rb")) == NULL)
+    {
+        log_error("Failure reopening sound stream %s", sound_info->prepared_file);
+        result = __LINE__;
+    }
+    else if (skip_stream_bytes(sound_info, sound_info->stream_data_offset) != 0)
+    {
+        log_error("Failure skipping the sound stream header");
+        result = __LINE__;
+    }
+    else
+    {
+        sound_info->stream_remaining = sound_info->stream_data_size;
+        sound_info->stream_pending = 0;
+        result = 0;
+    }
+    return result;
+}
+
+static size_t fill_stream_chunk(SOUND_MGR_INFO* sound_info)
+{
+    size_t result = sound_info->stream_pending;
+    size_t read_len = STREAM_BUFFER_SIZE - result;
+    if (read_len > sound_info->stream_remaining)
+    {
+        read_len = sound_info->stream_remaining;
+    }
+    if (read_len > 0)
+    {
+        size_t bytes_read = file_mgr_read(sound_info->stream_file, sound_info->stream_chunk + result, read_len);
+        // A short read means the file is shorter than its data chunk claims
+        sound_info->stream_remaining = bytes_read < read_len ? 0 : sound_info->stream_remaining - bytes_read;
+        result += bytes_read;
+    }
+    sound_info->stream_pending = 0;
+    return result;
+}
+
+static size_t read_sound_stream(SOUND_MGR_INFO* sound_info)
+{
+    size_t result = fill_stream_chunk(sound_info);
+    // Start over once a repeating track runs out of whole frames
+    if (result < (size_t)sound_info->stream_block_align && sound_info->stream_remaining == 0 && sound_info->stream_repeat &&
+        sound_info->stream_data_size >= (size_t)sound_info->stream_block_align && rewind_sound_stream(sound_info) == 0)
+    {
+        result = fill_stream_chunk(sound_info);
+    }
+    return result;
+}
+
+static int queue_stream_buffer(SOUND_MGR_INFO* sound_info, ALuint stream_buf)
+{
+    int result;
+    size_t chunk_len = read_sound_stream(sound_info);
+    // Only whole sample frames go to OpenAL, the rest starts the next buffer
+    size_t frame_len = chunk_len - (chunk_len % sound_info->stream_block_align);
+    if (frame_len == 0)
+    {
+        // End of the track
+        result = __LINE__;
+    }
+    else
+    {
+        if (sound_info->stream_swapped)
+        {
+            sample_convert_swap_16((int16_t*)sound_info->stream_chunk, frame_len/sizeof(int16_t));
+        }
+        alBufferData(stream_buf, sound_info->stream_format, sound_info->stream_chunk, frame_len, sound_info->stream_sample_rate);
+        if (!validate_openal_error("Failure filling stream buffer"))
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            alSourceQueueBuffers(sound_info->source, 1, &stream_buf);
+            if (!validate_openal_error("Failure queuing stream buffer"))
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        sound_info->stream_pending = chunk_len - frame_len;
+        memmove(sound_info->stream_chunk, sound_info->stream_chunk + frame_len, sound_info->stream_pending);
+    }
+    return result;
+}
+
+// Queues free buffers until the track runs dry, a buffer that could not be
+// filled stays on the free list for the next call
+static size_t refill_stream_buffers(SOUND_MGR_INFO* sound_info)
+{
+    size_t result = 0;
+    while (sound_info->stream_free_count > 0 &&
+        queue_stream_buffer(sound_info, sound_info->stream_free[sound_info->stream_free_count - 1]) == 0)
+    {
+        sound_info->stream_free_count--;
+        result++;
+    }
+    return result;
+}
+
+// Reads the chunk headers one at a time up to the samples, so metadata of
+// any size in front of them is skipped instead of failing the parse
+static int read_stream_header(SOUND_MGR_INFO* sound_info, format_info* fmt_info, int* swapped)
+{
+    int result;
+    chunk_header header;
+    size_t riff_len = sizeof(chunk_header) + 4;
+
+    if (file_mgr_read(sound_info->stream_file, sound_info->stream_chunk, riff_len) != riff_len)
+    {
+        log_error("Failure reading wav header");
+        result = __LINE__;
+    }
+    else
+    {
+        // Same endian detection as validate_wav_data
+        memcpy(&header, sound_info->stream_chunk, sizeof(chunk_header));
+        *swapped = header.id == (int)SWAP_32(RIFF_ID);
+        if (header.id != RIFF_ID && !*swapped)
+        {
+            log_error("Could not find RIFF chunk in wave file");
+            result = __LINE__;
+        }
+        else if (memcmp(sound_info->stream_chunk + sizeof(chunk_header), "WAVE", 4) != 0)
+        {
+            log_error("Could not find WAVE signature in wave file");
+            result = __LINE__;
+        }
+        else
+        {
+            bool has_format = false;
+            result = __LINE__;
+            sound_info->stream_data_offset = riff_len;
+            while (file_mgr_read(sound_info->stream_file, (unsigned char*)&header, sizeof(chunk_header)) == sizeof(chunk_header))
+            {
+                int chunk_id = *swapped ? (int)SWAP_32(header.id) : header.id;
+                size_t chunk_size = *swapped ? SWAP_32(header.size) : (unsigned int)header.size;
+                sound_info->stream_data_offset += sizeof(chunk_header);
+                if (chunk_id == DATA_ID)
+                {
+                    if (!has_format)
+                    {
+                        log_error("Could not find FMT chunk in wave file");
+                    }
+                    else
+                    {
+                        sound_info->stream_data_size = chunk_size;
+                        result = 0;
+                    }
+                    break;
+                }
+
+                // Chunks are padded to an even length
+                chunk_size += chunk_size & 1;
+                if (chunk_id == FMT_ID && chunk_size >= sizeof(format_info) && chunk_size <= STREAM_BUFFER_SIZE)
+                {
+                    if (file_mgr_read(sound_info->stream_file, sound_info->stream_chunk, chunk_size) != chunk_size ||
+                        read_wav_format((const char*)sound_info->stream_chunk, *swapped, fmt_info) != 0)
+                    {
+                        log_error("Failure reading the FMT chunk");
+                        break;
+                    }
+                    has_format = true;
+                }
+                else if (skip_stream_bytes(sound_info, chunk_size) != 0)
+                {
+                    log_error("Failure skipping wav chunk");
+                    break;
+                }
+                sound_info->stream_data_offset += chunk_size;
+            }
+            if (result != 0 && has_format)
+            {
+                log_error("Could not find the DATA chunk");
+            }
+        }
+    }
+    return result;
+}
+
+static int open_sound_stream(SOUND_MGR_INFO* sound_info, FILE_MGR_HANDLE file_mgr, size_t file_size)
+{
+    int result;
+    format_info fmt_info = {0};
+    int swapped;
+
+    sound_info->stream_file = file_mgr;
+    // Rewinding needs prepared_file, which isn't set until the stream is open
+    sound_info->stream_repeat = false;
+    if ((sound_info->stream_chunk = (unsigned char*)malloc(STREAM_BUFFER_SIZE)) == NULL)
+    {
+        log_error("Failure allocating stream buffer");
+        result = __LINE__;
+    }
+    else if (read_stream_header(sound_info, &fmt_info, &swapped) != 0)
+    {
+        log_error("Failure validating wav data");
+        result = __LINE__;
+    }
+    else
+    {
+        sound_info->stream_format = get_openal_format(&fmt_info);
+        sound_info->stream_sample_rate = fmt_info.sample_rate;
+        sound_info->stream_block_align = fmt_info.num_channels * fmt_info.bits_per_sample / 8;
+        sound_info->stream_swapped = swapped != 0 && fmt_info.bits_per_sample == 16;
+        if (sound_info->stream_data_size > file_size - sound_info->stream_data_offset)
+        {
+            // Don't trust a data chunk that claims more than the file holds
+            sound_info->stream_data_size = file_size - sound_info->stream_data_offset;
+        }
+        sound_info->stream_remaining = sound_info->stream_data_size;
+        sound_info->stream_pending = 0;
+
+        if (construct_sound_source(sound_info, 0) != 0)
+        {
+            log_error("Failure constructing stream source");
+            result = __LINE__;
+        }
+        else
+        {
+            // Filled in ring order, a track shorter than the ring leaves the
+            // last buffers free
+            for (sound_info->stream_free_count = 0; sound_info->stream_free_count < STREAM_BUFFER_COUNT; sound_info->stream_free_count++)
+            {
+                sound_info->stream_free[sound_info->stream_free_count] = sound_info->stream_bufs[STREAM_BUFFER_COUNT - 1 - sound_info->stream_free_count];
+            }
+            if (refill_stream_buffers(sound_info) == 0)
+            {
+                log_error("Failure queuing the first stream buffer");
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static unsigned char* map_wav_file(const char* sound_file, size_t* wav_size)
+{
+    unsigned char* result;
+    int file_fd;
+    struct stat file_stat;
+    if ((file_fd = open(sound_file, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        // Streamed files are read a chunk at a time instead
+        if (fstat(file_fd, &file_stat) != 0 || file_stat.st_size <= 0 || file_stat.st_size > STREAM_MIN_FILE_SIZE)
+        {
+            result = NULL;
+        }
+        // Private and writable so byte swapping only copies the pages it touches,
+        // populated so parsing and alBufferData don't fault page by page
+        else if ((result = (unsigned char*)mmap(NULL, (size_t)file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, file_fd, 0)) == MAP_FAILED)
+        {
+            log_warning("Failure mapping wav file %s, reading it instead", sound_file);
+            result = NULL;
+        }
+        else
+        {
+            (void)madvise(result, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+            *wav_size = (size_t)file_stat.st_size;
+        }
+        (void)close(file_fd);
+    }
+    return result;
+}
+
+static SOUND_CACHE_ENTRY* decode_sound_buffer(SOUND_MGR_INFO* sound_info, unsigned char* wav_buffer, size_t wav_size, const char* sound_file, time_t modify_time)
+{
+    SOUND_CACHE_ENTRY* result;
+    format_info fmt_info = {0};
+    int swapped;
+    if (validate_wav_data(wav_buffer, wav_size, &fmt_info, &sound_info->wav_data, &swapped) != 0)
+    {
+        log_error("Failure validating wav data");
+        result = NULL;
+    }
+    else
+    {
+        ALuint sound_buf;
+        sound_info->wav_size = get_chunk_size((const char*)sound_info->wav_data, swapped);
+        if (sound_info->wav_size > (size_t)(wav_buffer + wav_size - sound_info->wav_data))
+        {
+            // Don't trust a data chunk that claims more than the file holds
+            sound_info->wav_size = wav_buffer + wav_size - sound_info->wav_data;
+        }
+
+        if (fmt_info.bits_per_sample == 16 && swapped)
+        {
+            // If the file is swapped and we have 16-bit audio, we need to endian-swap the audio too or we'll
+            // get something that sounds just astoundingly bad!
+            sample_convert_swap_16((int16_t*)sound_info->wav_data, sound_info->wav_size/sizeof(int16_t));
+        }
+
+        if (create_sound_buffer(sound_info, &fmt_info, &sound_buf) != 0)
+        {
+            log_error("Failure construting buffer data");
+            result = NULL;
+        }
+        else if ((result = add_cached_sound(sound_info, sound_file, modify_time, sound_buf, sound_info->wav_size)) == NULL)
+        {
+            log_error("Failure caching buffer data");
+            alDeleteBuffers(1, &sound_buf);
+        }
+        // OpenAL keeps its own copy of the samples
+        sound_info->wav_data = NULL;
+    }
+    return result;
+}
+
+static SOUND_CACHE_ENTRY* load_sound_buffer(SOUND_MGR_INFO* sound_info, FILE_MGR_HANDLE file_mgr, size_t file_size, const char* sound_file, time_t modify_time)
+{
+    SOUND_CACHE_ENTRY* result;
+    unsigned char* wav_buffer = retrieve_wav_data(file_mgr, file_size);
+    file_mgr_close(file_mgr);
+    if (wav_buffer == NULL)
+    {
+        log_error("Failure opening wav file");
+        result = NULL;
+    }
+    else
+    {
+        result = decode_sound_buffer(sound_info, wav_buffer, file_size, sound_file, modify_time);
+        free(wav_buffer);
+    }
+    return result;
+}
+
+static int load_sound_file(SOUND_MGR_INFO* sound_info, const char* sound_file, time_t modify_time)
+{
+    int result;
+    FILE_MGR_HANDLE file_mgr;
+    int64_t file_size;
+    SOUND_CACHE_ENTRY* cache_entry;
+    unsigned char* wav_map;
+    size_t map_size;
+    if ((wav_map = map_wav_file(sound_file, &map_size)) != NULL)
+    {
+        // Parse and upload straight from the mapped file, no heap copy
+        cache_entry = decode_sound_buffer(sound_info, wav_map, map_size, sound_file, modify_time);
+        (void)munmap(wav_map, map_size);
+        if (cache_entry == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            result = construct_sound_source(sound_info, cache_entry->sound_buf);
+        }
+    }
+    else if ((file_mgr = file_mgr_open(sound_file, "rb")) == NULL)
+    {
+        log_error("Failure loading wav");
+        result = __LINE__;
+    }
+    else if ((file_size = file_mgr_get_length(file_mgr)) <= 0)
+    {
+        log_error("Invalid file size found");
+        file_mgr_close(file_mgr);
+        result = __LINE__;
+    }
+    else if (file_size > STREAM_MIN_FILE_SIZE)
+    {
+        // Long tracks would cost their full size in memory, stream them instead
+        result = open_sound_stream(sound_info, file_mgr, (size_t)file_size);
+    }
+    else if ((cache_entry = load_sound_buffer(sound_info, file_mgr, (size_t)file_size, sound_file, modify_time)) == NULL)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        result = construct_sound_source(sound_info, cache_entry->sound_buf);
+    }
+    return result;
+}
+
+static int prepare_sound_file(SOUND_MGR_INFO* sound_info, const char* sound_file)
+{
+    int result;
+    if (sound_info->prepared_file != NULL && strcmp(sound_info->prepared_file, sound_file) == 0)
+    {
+        // Already decoded and attached to the source
+        result = 0;
+    }
+    else
+    {
+        SOUND_CACHE_ENTRY* cache_entry;
+        time_t modify_time = get_file_modify_time(sound_file);
+
+        clean_audio_items(sound_info);
+        if ((cache_entry = find_cached_sound(sound_info, sound_file, modify_time)) != NULL)
+        {
+            result = construct_sound_source(sound_info, cache_entry->sound_buf);
+        }
+        else
+        {
+            result = load_sound_file(sound_info, sound_file, modify_time);
+        }
+
+        if (result != 0)
+        {
+            log_error("Failure loading sound file %s", sound_file);
+            clean_audio_items(sound_info);
+            result = __LINE__;
+        }
+        else if (clone_string(&sound_info->prepared_file, sound_file) != 0)
+        {
+            log_error("Failure copying sound file name");
+            clean_audio_items(sound_info);
+            result = __LINE__;
+        }
+        else
+        {
+            // Make room for the new buffer now that the source holds it
+            trim_sound_cache(sound_info, sound_info->cache_limit);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+SOUND_MGR_HANDLE sound_mgr_create(void)
+{
+    SOUND_MGR_INFO* result;
+    if ((result = (SOUND_MGR_INFO*)malloc(sizeof(SOUND_MGR_INFO))) == NULL)
+    {
+        log_error("Failure unable to allocate alarm scheduler");
+    }
+    else
+    {
+        memset(result, 0, sizeof(SOUND_MGR_INFO));
+
+        // Initialize the environment
+        if (initialize_openai(result) != 0)
+        {
+            log_error("Failure initializing audio system");
+            free(result);
+            result = NULL;
+        }
+        else if (initialize_gain_ramp(result) != 0)
+        {
+            log_error("Failure initializing crescendo");
+            deinitialize_openai(result);
+            free(result);
+            result = NULL;
+        }
+        else if (create_audio_objects(result) != 0)
+        {
+            log_error("Failure creating audio source");
+            pthread_cond_destroy(&result->gain_cond);
+            pthread_mutex_destroy(&result->gain_lock);
+            deinitialize_openai(result);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->volume = 1.0;
+            result->cache_limit = DEFAULT_SOUND_CACHE_LIMIT;
+            result->crescendo_curve = SOUND_CRESCENDO_LOUDNESS;
+            result->crescendo_time = DEFAULT_CRESCENDO_TIME;
+        }
+    }
+    return result;
+}
+
+void sound_mgr_destroy(SOUND_MGR_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        clean_audio_items(handle);
+        trim_sound_cache(handle, 0);
+        destroy_audio_objects(handle);
+
+        // Exit everything
+        deinitialize_openai(handle);
+        pthread_cond_destroy(&handle->gain_cond);
+        pthread_mutex_destroy(&handle->gain_lock);
+
+        free(handle);
+    }
+}
+
+int sound_mgr_prepare(SOUND_MGR_HANDLE handle, const char* sound_file)
+{
+    int result;
+    if (handle == NULL || sound_file == NULL)
+    {
+        log_error("Invalid argument specified: handle: %p, sound_file: %p", handle, sound_file);
+        result = __LINE__;
+    }
+    else if (handle->sound_state == SOUND_STATE_PLAYING)
+    {
+        log_error("Unable to prepare a sound while another one is playing");
+        result = __LINE__;
+    }
+    else
+    {
+        result = prepare_sound_file(handle, sound_file);
+    }
+    return result;
+}
+
+int sound_mgr_set_cache_limit(SOUND_MGR_HANDLE handle, size_t cache_limit)
+{
+    int result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument specified handle: NULL");
+        result = __LINE__;
+    }
+    else
+    {
+        handle->cache_limit = cache_limit;
+        trim_sound_cache(handle, handle->cache_limit);
+        result = 0;
+    }
+    return result;
+}
+
+int sound_mgr_set_crescendo(SOUND_MGR_HANDLE handle, SOUND_CRESCENDO_CURVE curve, uint32_t crescendo_time)
+{
+    int result;
+    if (handle == NULL || curve > SOUND_CRESCENDO_S_CURVE)
+    {
+        log_error("Invalid argument specified: handle: %p, curve: %d", handle, (int)curve);
+        result = __LINE__;
+    }
+    else
+    {
+        // Takes effect on the next sound_mgr_play
+        handle->crescendo_curve = curve;
+        handle->crescendo_time = crescendo_time;
+        result = 0;
+    }
+    return result;
+}
+
+int sound_mgr_play(SOUND_MGR_HANDLE handle, const char* sound_file, bool set_repeat, bool crescendo)
+{
+    int result;
+    if (handle == NULL || sound_file == NULL)
+    {
+        log_error("Invalid argument specified: handle: %p, sound_file: %p", handle, sound_file);
+        result = __LINE__;
     }
     else
     {
-        //handle->volume = volume;
+        // Only one sound plays at a time, so stop whatever is playing
         if (handle->sound_state == SOUND_STATE_PLAYING)
         {
-            //alSourcef(handle->source, AL_PITCH, handle->volume);
+            alSourceStop(handle->source);
+            clean_audio_items(handle);
+            handle->sound_state = SOUND_STATE_IDLE;
+        }
+
+        // A prepared sound skips straight to playing
+        if (prepare_sound_file(handle, sound_file) != 0)
+        {
+            log_error("Failure preparing sound file");
+            result = __LINE__;
+        }
+        else
+        {
+            // A crescendo starts quiet and the ramp thread takes it up to the volume
+            bool ramp_gain = crescendo && handle->crescendo_time >= GAIN_RAMP_INTERVAL_MS;
+            alSourcef(handle->source, AL_GAIN, ramp_gain ? handle->volume*CRESCENDO_START_GAIN : handle->volume);
+            validate_openal_error("Failure setting Sound Gain");
+            // A streamed sound loops by rereading the file
+            handle->stream_repeat = set_repeat;
+            alSourcei(handle->source, AL_LOOPING, set_repeat && handle->stream_chunk == NULL ? AL_TRUE : AL_FALSE);
+            validate_openal_error("Failure setting Sound Looping");
+            alSourcePlay(handle->source);
+            if (ramp_gain)
+            {
+                start_gain_ramp(handle);
+            }
+            handle->sound_state = SOUND_STATE_PLAYING;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+int sound_mgr_process(SOUND_MGR_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument specified: handle: NULL");
+        result = __LINE__;
+    }
+    else
+    {
+        if (handle->sound_state == SOUND_STATE_PLAYING && handle->stream_chunk != NULL)
+        {
+            ALint processed = 0;
+            ALint source_state = 0;
+
+            // Take every finished buffer off the queue before refilling any, a
+            // stopped source would replay whatever is still queued
+            alGetSourcei(handle->source, AL_BUFFERS_PROCESSED, &processed);
+            if (processed > (ALint)(STREAM_BUFFER_COUNT - handle->stream_free_count))
+            {
+                processed = (ALint)(STREAM_BUFFER_COUNT - handle->stream_free_count);
+            }
+            if (processed > 0)
+            {
+                alSourceUnqueueBuffers(handle->source, processed, &handle->stream_free[handle->stream_free_count]);
+                if (validate_openal_error("Failure unqueuing stream buffers"))
+                {
+                    handle->stream_free_count += processed;
+                }
+            }
+            (void)refill_stream_buffers(handle);
+
+            alGetSourcei(handle->source, AL_SOURCE_STATE, &source_state);
+            if (source_state != AL_PLAYING)
+            {
+                // Everything still queued is unplayed, so the source ran dry and
+                // only needs a restart
+                ALint queued = 0;
+                alGetSourcei(handle->source, AL_BUFFERS_QUEUED, &queued);
+                if (queued > 0)
+                {
+                    alSourcePlay(handle->source);
+                }
+                else if (handle->stream_remaining == 0 && !handle->stream_repeat)
+                {
+                    // End of the track
+                    clean_audio_items(handle);
+                    handle->sound_state = SOUND_STATE_IDLE;
+                }
+            }
+        }
+        result = 0;
+    }
+    return result;
+}
+
+int sound_mgr_stop(SOUND_MGR_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument specified: handle: %p", handle);
+        result = __LINE__;
+    }
+    else if (handle->sound_state != SOUND_STATE_PLAYING)
+    {
+        log_error("Sound is no longer playing");
+        handle->sound_state = SOUND_STATE_IDLE;
+        result = __LINE__;
+    }
+    else
+    {
+        //ALenum current_playing_state;
+        //alGetSourcei(handle->source, AL_SOURCE_STATE, &current_playing_state);
+        //alSourcei(handle->sourceId, AL_BUFFER, AL_NONE);
+        alSourceStop(handle->source);
+        clean_audio_items(handle);
+        handle->sound_state = SOUND_STATE_IDLE;
+        result = 0;
+    }
+    return result;
+}
+
+SOUND_MGR_STATE sound_mgr_get_current_state(SOUND_MGR_HANDLE handle)
+{
+    SOUND_MGR_STATE result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument specified: handle: %p", handle);
+        result = SOUND_STATE_ERROR;
+    }
+    else
+    {
+        result = handle->sound_state;
+    }
+    return result;
+}
+
+int sound_mgr_set_volume(SOUND_MGR_HANDLE handle, float volume)
+{
+    int result;
+    if (handle == NULL)
+    {
+        log_error("Invalid argument specified handle: NULL");
+        result = __LINE__;
+    }
+    else if (volume < 0.0 || volume > 1.0)
+    {
+        log_error("The volume is not within range of 0.0 - 1.0");
+        result = __LINE__;
+    }
+    else
+    {
+        // A running crescendo picks the new volume up on its next step
+        pthread_mutex_lock(&handle->gain_lock);
+        handle->volume = volume;
+        if (handle->sound_state == SOUND_STATE_PLAYING && (!handle->gain_running || handle->gain_stop))
+        {
+            alSourcef(handle->source, AL_GAIN, handle->volume);
+            validate_openal_error("Failure setting Sound Gain");
         }
+        pthread_mutex_unlock(&handle->gain_lock);
         result = 0;
     }
     return result;
@@ -22,6 +22,11 @@ static void* my_mem_shim_malloc(size_t size)
     return malloc(size);
 }
 
+static void* my_mem_shim_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
 static void my_mem_shim_free(void* ptr)
 {
     free(ptr);
@@ -29,25 +34,25 @@ static void my_mem_shim_free(void* ptr)
 
 #define ENABLE_MOCKS
 #include "lib-util-c/sys_debug_shim.h"
-#include "lib-util-c/item_list.h"
-#include "lib-util-c/crt_extensions.h"
 #include "time_mgr.h"
 #undef ENABLE_MOCKS
 
 #include "alarm_scheduler.h"
 
 static ALARM_INFO g_alarm_info;
-static size_t insert_item_index = 0;
-static const void* g_insert_item[3];
-
-static ITEM_LIST_DESTROY_ITEM g_list_destroy_item;
-static void* g_destroy_user_ctx;
 static const char* TEST_ALARM_TEXT = "test alarm text";
 static const char* TEST_TEST_SOUND_FILE = "test sound text";
 static const char* TEST_ALARM_1_TEXT = "alarm_1_text";
 static const char* TEST_ALARM_2_TEXT = "alarm_2_text";
 static const char* TEST_ALARM_3_TEXT = "alarm_3_text";
 static const uint8_t TEST_SNOOZE_VALUE = 1;
+// 2021-03-14 02:30 PST does not exist, 2021-11-07 01:30 PST happens twice
+static const char* TEST_DST_TIMEZONE = "PST8PDT,M3.2.0,M11.1.0";
+static const time_t TEST_DST_SPRING_FIRE_TIME = 1615716000;
+static const time_t TEST_DST_FALL_FIRE_TIME = 1636273800;
+// 2021-06-01 23:59 UTC
+static const char* TEST_UTC_TIMEZONE = "UTC0";
+static const time_t TEST_MIDNIGHT_FIRE_TIME = 1622591940;
 
 static void set_tm_struct(struct tm* curr_time)
 {
@@ -63,6 +68,19 @@ static void set_tm_struct(struct tm* curr_time)
     curr_time->tm_sec = 0;
 }
 
+static void set_test_timezone(const char* timezone)
+{
+    if (timezone == NULL)
+    {
+        unsetenv("TZ");
+    }
+    else
+    {
+        setenv("TZ", timezone, 1);
+    }
+    tzset();
+}
+
 static void setup_alarm_time_info(ALARM_INFO* alarm_info, struct tm* curr_time)
 {
     switch (curr_time->tm_wday)
@@ -100,79 +118,29 @@ static void setup_alarm_time_info(ALARM_INFO* alarm_info, struct tm* curr_time)
     alarm_info->alarm_id = 0;
 }
 
-static ITEM_LIST_HANDLE my_item_list_create(ITEM_LIST_DESTROY_ITEM destroy_cb, void* user_ctx)
-{
-    g_list_destroy_item = destroy_cb;
-    g_destroy_user_ctx = user_ctx;
-    return my_mem_shim_malloc(1);
-}
-
-static void my_item_list_destroy(ITEM_LIST_HANDLE handle)
-{
-    if (g_insert_item[0] != NULL)
-    {
-        g_list_destroy_item(g_destroy_user_ctx, (void*)g_insert_item[0]);
-        g_insert_item[0] = NULL;
-        insert_item_index--;
-    }
-    if (g_insert_item[1] != NULL)
-    {
-        g_list_destroy_item(g_destroy_user_ctx, (void*)g_insert_item[1]);
-        g_insert_item[1] = NULL;
-        insert_item_index--;
-    }
-    if (g_insert_item[2] != NULL)
-    {
-        g_list_destroy_item(g_destroy_user_ctx, (void*)g_insert_item[2]);
-        g_insert_item[2] = NULL;
-        insert_item_index--;
-    }
-    my_mem_shim_free(handle);
-}
-
-static int my_item_list_add_item(ITEM_LIST_HANDLE handle, const void* item)
+// Walks forward a day at a time to find when the alarm fires next
+static uint32_t reference_minutes_till_trigger(uint32_t trigger_days, const TIME_INFO* trigger_time, int week_minute)
 {
-    (void)handle;
-    if (g_insert_item[0] == NULL)
-    {
-        g_insert_item[0] = item;
-        insert_item_index++;
-    }
-    else if (g_insert_item[1] == NULL)
-    {
-        g_insert_item[1] = item;
-        insert_item_index++;
-    }
-    else
-    {
-        g_insert_item[2] = item;
-        insert_item_index++;
-    }
-    return 0;
-}
-
-static const void* my_item_list_get_item(ITEM_LIST_HANDLE handle, size_t item_index)
-{
-    const void* result;
-    if (item_index >= insert_item_index++)
-    {
-        result = NULL;
-    }
-    else
-    {
-        result = g_insert_item[item_index];
+    static const uint32_t DAY_VALUES[] = { Sunday, Monday, Tuesday, Wednesday, Thursday, Friday, Saturday };
+    uint32_t result = ALARM_NO_TRIGGER;
+    int trigger_minute = trigger_time->hour*60 + trigger_time->min;
+    int day_minute = week_minute % (24*60);
+    int wday = week_minute / (24*60);
+    for (int days = 0; days <= 7; days++)
+    {
+        if (days == 0 && trigger_minute <= day_minute)
+        {
+            continue;
+        }
+        if (trigger_days & DAY_VALUES[(wday + days) % 7])
+        {
+            result = (uint32_t)(days*24*60 + trigger_minute - day_minute);
+            break;
+        }
     }
     return result;
 }
 
-static int my_clone_string(char** target, const char* source)
-{
-    size_t len = strlen(source);
-    *target = my_mem_shim_malloc(len+1);
-    strcpy(*target, source);
-    return 0;
-}
-
 MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
@@ -188,27 +156,15 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)umock_c_init(on_umock_c_error);
 
         REGISTER_UMOCK_ALIAS_TYPE(time_t, long);
-        REGISTER_UMOCK_ALIAS_TYPE(ITEM_LIST_DESTROY_ITEM, void*);
-        REGISTER_UMOCK_ALIAS_TYPE(ITEM_LIST_HANDLE, void*);
 
         result = umocktypes_charptr_register_types();
         CTEST_ASSERT_ARE_EQUAL(int, 0, result);
 
         REGISTER_GLOBAL_MOCK_HOOK(mem_shim_malloc, my_mem_shim_malloc);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(mem_shim_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(mem_shim_realloc, my_mem_shim_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(mem_shim_realloc, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(mem_shim_free, my_mem_shim_free);
-
-        REGISTER_GLOBAL_MOCK_HOOK(item_list_create, my_item_list_create);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(item_list_create, NULL);
-        REGISTER_GLOBAL_MOCK_HOOK(item_list_destroy, my_item_list_destroy);
-        REGISTER_GLOBAL_MOCK_HOOK(item_list_add_item, my_item_list_add_item);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(item_list_add_item, __LINE__);
-        REGISTER_GLOBAL_MOCK_RETURN(item_list_item_count, 0);
-        REGISTER_GLOBAL_MOCK_HOOK(item_list_get_item, my_item_list_get_item);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(item_list_get_item, NULL);
-
-        REGISTER_GLOBAL_MOCK_HOOK(clone_string, my_clone_string);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(clone_string, __LINE__);
     }
 
     CTEST_SUITE_CLEANUP()
@@ -219,12 +175,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
     CTEST_FUNCTION_INITIALIZE()
     {
         umock_c_reset_all_calls();
-        g_list_destroy_item = NULL;
-        g_destroy_user_ctx = NULL;
-
-        insert_item_index = 0;
-        g_insert_item[0] = NULL;
-        g_insert_item[1] = NULL;
     }
 
     CTEST_FUNCTION_CLEANUP()
@@ -234,15 +184,16 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
     static void setup_alarm_scheduler_create_mocks(void)
     {
         STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_create(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
     }
 
+    // The first alarm added allocates the item chunk, string table and string block
     static void setup_alarm_scheduler_add_alarm_info_mocks(void)
     {
         STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_add_item(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
     }
 
     CTEST_FUNCTION(alarm_scheduler_create_success)
@@ -296,7 +247,9 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         SCHEDULER_HANDLE handle = alarm_scheduler_create();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_destroy(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
         STRICT_EXPECTED_CALL(free(IGNORED_ARG));
 
         // act
@@ -357,6 +310,30 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         alarm_scheduler_destroy(handle);
     }
 
+    CTEST_FUNCTION(alarm_scheduler_add_alarm_info_shared_strings_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&g_alarm_info, &test_tm);
+        (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
+        umock_c_reset_all_calls();
+
+        // act
+        ALARM_INFO alarm_info1 = g_alarm_info;
+        int result = alarm_scheduler_add_alarm_info(handle, &alarm_info1);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_IS_TRUE(alarm_scheduler_get_alarm(handle, 0)->sound_file == alarm_scheduler_get_alarm(handle, 1)->sound_file);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_TEST_SOUND_FILE, alarm_scheduler_get_alarm(handle, 1)->sound_file);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
     CTEST_FUNCTION(alarm_scheduler_add_alarm_info_invalid_fail)
     {
         // arrange
@@ -383,13 +360,15 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         // arrange
         struct tm test_tm = {0};
         set_tm_struct(&test_tm);
-        SCHEDULER_HANDLE handle = alarm_scheduler_create();
         setup_alarm_time_info(&g_alarm_info, &test_tm);
         umock_c_reset_all_calls();
 
         int negativeTestsInitResult = umock_c_negative_tests_init();
         CTEST_ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
+        // The pool and string table keep their allocations once made, so
+        // every run starts from a new scheduler
+        setup_alarm_scheduler_create_mocks();
         setup_alarm_scheduler_add_alarm_info_mocks();
         umock_c_negative_tests_snapshot();
 
@@ -402,15 +381,186 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
                 umock_c_negative_tests_fail_call(index);
 
                 // act
-                int result = alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
+                SCHEDULER_HANDLE handle = alarm_scheduler_create();
+                int result = handle == NULL ? __LINE__ : alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
 
                 // assert
-                CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+                CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result, "alarm_scheduler_add_alarm_info_fail failure %d/%d", (int)index, (int)count);
+
+                alarm_scheduler_destroy(handle);
             }
         }
 
+        // cleanup
+        umock_c_negative_tests_deinit();
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_handle_NULL_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        setup_alarm_time_info(&g_alarm_info, &test_tm);
+
+        // act
+        int result = alarm_scheduler_add_alarms(NULL, &g_alarm_info, 1);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_list_NULL_fail)
+    {
+        // arrange
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        umock_c_reset_all_calls();
+
+        // act
+        int result = alarm_scheduler_add_alarms(handle, NULL, 1);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_list[3];
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 3; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+            alarm_list[index].trigger_time.min = (uint8_t)index;
+        }
+        alarm_list[1].alarm_text = (char*)TEST_ALARM_1_TEXT;
+        umock_c_reset_all_calls();
+
+        setup_alarm_scheduler_add_alarm_info_mocks();
+
+        // act
+        int result = alarm_scheduler_add_alarms(handle, alarm_list, 3);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, 3, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_1_TEXT, alarm_scheduler_get_alarm(handle, 1)->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
         // cleanup
         alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_invalid_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_list[3];
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 3; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+        }
+        alarm_list[2].trigger_time.hour = 55;
+        umock_c_reset_all_calls();
+
+        setup_alarm_scheduler_add_alarm_info_mocks();
+
+        // act
+        int result = alarm_scheduler_add_alarms(handle, alarm_list, 3);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_IS_NULL(alarm_scheduler_is_triggered(handle, &test_tm));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_invalid_restores_id_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_list[3];
+        uint8_t alarm_id = 0;
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 3; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+        }
+        alarm_list[2].trigger_time.min = 75;
+        umock_c_reset_all_calls();
+
+        setup_alarm_scheduler_add_alarm_info_mocks();
+
+        // act
+        int batch_result = alarm_scheduler_add_alarms(handle, alarm_list, 3);
+        int result = alarm_scheduler_add_alarm(handle, TEST_ALARM_TEXT, &alarm_list[0].trigger_time, Everyday, TEST_TEST_SOUND_FILE, TEST_SNOOZE_VALUE, &alarm_id);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, batch_result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        // The ids handed out by the failed batch are given out again
+        CTEST_ASSERT_ARE_EQUAL(int, MIN_ID_VALUE, alarm_id);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_add_alarms_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        ALARM_INFO alarm_list[2];
+        setup_alarm_time_info(&alarm_list[0], &test_tm);
+        setup_alarm_time_info(&alarm_list[1], &test_tm);
+        umock_c_reset_all_calls();
+
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        CTEST_ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        // The pool and string table keep their allocations once made, so
+        // every run starts from a new scheduler
+        setup_alarm_scheduler_create_mocks();
+        setup_alarm_scheduler_add_alarm_info_mocks();
+        umock_c_negative_tests_snapshot();
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            if (umock_c_negative_tests_can_call_fail(index))
+            {
+                umock_c_negative_tests_reset();
+                umock_c_negative_tests_fail_call(index);
+
+                // act
+                SCHEDULER_HANDLE handle = alarm_scheduler_create();
+                int result = handle == NULL ? __LINE__ : alarm_scheduler_add_alarms(handle, alarm_list, 2);
+
+                // assert
+                CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result, "alarm_scheduler_add_alarms_fail failure %d/%d", (int)index, (int)count);
+                CTEST_ASSERT_ARE_EQUAL(int, 0, alarm_scheduler_get_alarm_count(handle));
+
+                alarm_scheduler_destroy(handle);
+            }
+        }
+
+        // cleanup
         umock_c_negative_tests_deinit();
     }
 
@@ -479,13 +629,15 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         // arrange
         struct tm test_tm = {0};
         set_tm_struct(&test_tm);
-        SCHEDULER_HANDLE handle = alarm_scheduler_create();
-        setup_alarm_time_info(&g_alarm_info, &test_tm);
+        TIME_INFO tm_info = { 4, 5 };
         umock_c_reset_all_calls();
 
         int negativeTestsInitResult = umock_c_negative_tests_init();
         CTEST_ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
+        // The pool and string table keep their allocations once made, so
+        // every run starts from a new scheduler
+        setup_alarm_scheduler_create_mocks();
         setup_alarm_scheduler_add_alarm_info_mocks();
         umock_c_negative_tests_snapshot();
 
@@ -498,16 +650,17 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
                 umock_c_negative_tests_fail_call(index);
 
                 // act
-                TIME_INFO tm_info = { 4, 5 };
-                int result = alarm_scheduler_add_alarm(handle, TEST_ALARM_TEXT, &tm_info, Monday|Tuesday, TEST_TEST_SOUND_FILE, TEST_SNOOZE_VALUE, NULL);
+                SCHEDULER_HANDLE handle = alarm_scheduler_create();
+                int result = handle == NULL ? __LINE__ : alarm_scheduler_add_alarm(handle, TEST_ALARM_TEXT, &tm_info, Monday|Tuesday, TEST_TEST_SOUND_FILE, TEST_SNOOZE_VALUE, NULL);
 
                 // assert
-                CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result, "alarm_scheduler_add_alarm failure %d/%d", (int)index, (int)count);
+                CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result, "alarm_scheduler_add_alarm_fail failure %d/%d", (int)index, (int)count);
+
+                alarm_scheduler_destroy(handle);
             }
         }
 
         // cleanup
-        alarm_scheduler_destroy(handle);
         umock_c_negative_tests_deinit();
     }
 
@@ -555,9 +708,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_iterator(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_is_triggered(handle, &test_tm);
@@ -599,9 +749,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_is_triggered(handle, &test_tm);
@@ -634,9 +781,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_is_triggered(handle, &test_tm);
@@ -677,10 +821,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_iterator(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_is_triggered(handle, &test_tm);
@@ -694,6 +834,250 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         alarm_scheduler_destroy(handle);
     }
 
+    CTEST_FUNCTION(alarm_scheduler_get_triggered_alarms_handle_NULL_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        const ALARM_INFO* triggered_list[2];
+        set_tm_struct(&test_tm);
+
+        // act
+        size_t result = alarm_scheduler_get_triggered_alarms(NULL, &test_tm, triggered_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_triggered_alarms_list_NULL_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        umock_c_reset_all_calls();
+
+        // act
+        size_t result = alarm_scheduler_get_triggered_alarms(handle, &test_tm, NULL, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_triggered_alarms_same_minute_success)
+    {
+        // arrange
+        ALARM_INFO alarm_list[3];
+        const ALARM_INFO* triggered_list[2];
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        test_tm.tm_hour = 4;
+        test_tm.tm_min = 50;
+        test_tm.tm_wday = 1;
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 3; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+            alarm_list[index].trigger_days = Monday|Wednesday|Friday;
+            alarm_list[index].trigger_time.hour = 4;
+            alarm_list[index].trigger_time.min = 50;
+        }
+        alarm_list[0].alarm_text = (char*)TEST_ALARM_1_TEXT;
+        alarm_list[1].alarm_text = (char*)TEST_ALARM_2_TEXT;
+        alarm_list[2].alarm_text = (char*)TEST_ALARM_3_TEXT;
+        (void)alarm_scheduler_add_alarms(handle, alarm_list, 3);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t first_count = alarm_scheduler_get_triggered_alarms(handle, &test_tm, triggered_list, 2);
+        const ALARM_INFO* first_alarm = triggered_list[0];
+        const ALARM_INFO* second_alarm = triggered_list[1];
+        size_t second_count = alarm_scheduler_get_triggered_alarms(handle, &test_tm, triggered_list, 2);
+        size_t third_count = alarm_scheduler_get_triggered_alarms(handle, &test_tm, triggered_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 2, first_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_1_TEXT, first_alarm->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_2_TEXT, second_alarm->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, second_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_3_TEXT, triggered_list[0]->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, third_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_is_triggered_snooze_expired_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&g_alarm_info, &test_tm);
+        (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
+        (void)alarm_scheduler_snooze_alarm(handle, alarm_scheduler_get_alarm(handle, 0));
+        test_tm.tm_min++;
+        const ALARM_INFO* snooze_info = alarm_scheduler_is_triggered(handle, &test_tm);
+        test_tm.tm_yday++;
+        test_tm.tm_wday++;
+        umock_c_reset_all_calls();
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_is_triggered(handle, &test_tm);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(snooze_info);
+        CTEST_ASSERT_IS_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_due_alarms_handle_NULL_fail)
+    {
+        // arrange
+        const ALARM_INFO* triggered_list[2];
+
+        // act
+        size_t result = alarm_scheduler_get_due_alarms(NULL, TEST_DST_SPRING_FIRE_TIME, triggered_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_due_alarm_handle_NULL_fail)
+    {
+        // arrange
+        time_t fire_time = 0;
+
+        // act
+        const ALARM_INFO* result = alarm_scheduler_get_next_due_alarm(NULL, &fire_time);
+
+        // assert
+        CTEST_ASSERT_IS_NULL(result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_due_alarms_dst_gap_success)
+    {
+        // arrange
+        const ALARM_INFO* triggered_list[2];
+        TIME_INFO time_info = { 2, 30, 0 };
+        set_test_timezone(TEST_DST_TIMEZONE);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        (void)alarm_scheduler_add_alarm(handle, TEST_ALARM_1_TEXT, &time_info, Everyday, TEST_TEST_SOUND_FILE, 5, NULL);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t before_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_SPRING_FIRE_TIME - 3600, triggered_list, 2);
+        size_t gap_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_SPRING_FIRE_TIME, triggered_list, 2);
+        size_t after_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_SPRING_FIRE_TIME + 60, triggered_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, before_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, gap_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, after_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+        set_test_timezone(NULL);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_due_alarms_dst_overlap_success)
+    {
+        // arrange
+        const ALARM_INFO* triggered_list[2];
+        TIME_INFO time_info = { 1, 30, 0 };
+        set_test_timezone(TEST_DST_TIMEZONE);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        (void)alarm_scheduler_add_alarm(handle, TEST_ALARM_1_TEXT, &time_info, Everyday, TEST_TEST_SOUND_FILE, 5, NULL);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t before_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_FALL_FIRE_TIME - 5400, triggered_list, 2);
+        size_t first_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_FALL_FIRE_TIME, triggered_list, 2);
+        size_t repeat_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_FALL_FIRE_TIME + 3600, triggered_list, 2);
+        size_t next_day_count = alarm_scheduler_get_due_alarms(handle, TEST_DST_FALL_FIRE_TIME + 90000, triggered_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, before_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, first_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, repeat_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, next_day_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+        set_test_timezone(NULL);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_release_alarm_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        alarm_scheduler_release_alarm(NULL, &g_alarm_info);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_release_alarm_snooze_after_midnight_success)
+    {
+        // arrange
+        const ALARM_INFO* triggered_list[2];
+        ALARM_INFO alarm_info = { { 23, 58, 0 }, Everyday, 1, (char*)TEST_ALARM_1_TEXT, (char*)TEST_TEST_SOUND_FILE, 0 };
+        set_test_timezone(TEST_UTC_TIMEZONE);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        (void)alarm_scheduler_snooze_alarm(handle, &alarm_info);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t fired_count = alarm_scheduler_get_due_alarms(handle, TEST_MIDNIGHT_FIRE_TIME, triggered_list, 2);
+        const ALARM_INFO* fired_alarm = triggered_list[0];
+        size_t next_day_count = alarm_scheduler_get_due_alarms(handle, TEST_MIDNIGHT_FIRE_TIME + 90, triggered_list, 2);
+        size_t held_count = alarm_scheduler_get_alarm_count(handle);
+        int result = alarm_scheduler_snooze_alarm(handle, fired_alarm);
+        const ALARM_INFO* snooze_alarm = alarm_scheduler_get_alarm(handle, 1);
+        alarm_scheduler_release_alarm(handle, fired_alarm);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 1, fired_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, next_day_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 1, held_count);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_1_TEXT, snooze_alarm->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, snooze_alarm->trigger_time.hour);
+        // The fired snooze expires once it is released
+        CTEST_ASSERT_ARE_EQUAL(int, 1, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+        set_test_timezone(NULL);
+    }
+
     CTEST_FUNCTION(alarm_scheduler_remove_alarm_handle_NULL_fail)
     {
         // arrange
@@ -718,7 +1102,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(0);
 
         // act
         int result = alarm_scheduler_remove_alarm(handle, 2);
@@ -741,9 +1124,6 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_remove_item(IGNORED_ARG, IGNORED_ARG));
-
         // act
         int result = alarm_scheduler_remove_alarm(handle, 0);
 
@@ -755,31 +1135,29 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         alarm_scheduler_destroy(handle);
     }
 
-    CTEST_FUNCTION(alarm_scheduler_remove_alarm_remove_fail)
+    CTEST_FUNCTION(alarm_scheduler_delete_alarm_success)
     {
         // arrange
         struct tm test_tm = {0};
+        ALARM_INFO alarm_info;
         set_tm_struct(&test_tm);
         SCHEDULER_HANDLE handle = alarm_scheduler_create();
-        setup_alarm_time_info(&g_alarm_info, &test_tm);
-        (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
+        setup_alarm_time_info(&alarm_info, &test_tm);
+        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_remove_item(IGNORED_ARG, IGNORED_ARG)).SetReturn(__LINE__);
-
         // act
-        int result = alarm_scheduler_remove_alarm(handle, 0);
+        int result = alarm_scheduler_delete_alarm(handle, alarm_info.alarm_id);
 
         // assert
-        CTEST_ASSERT_ARE_NOT_EQUAL(int, result, 0);
+        CTEST_ASSERT_ARE_EQUAL(int, result, 0);
         CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         // cleanup
         alarm_scheduler_destroy(handle);
     }
 
-    CTEST_FUNCTION(alarm_scheduler_delete_alarm_success)
+    CTEST_FUNCTION(alarm_scheduler_delete_alarm_not_triggered_success)
     {
         // arrange
         struct tm test_tm = {0};
@@ -787,18 +1165,18 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
         set_tm_struct(&test_tm);
         SCHEDULER_HANDLE handle = alarm_scheduler_create();
         setup_alarm_time_info(&alarm_info, &test_tm);
-        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info);
+        uint8_t alarm_id;
+        (void)alarm_scheduler_add_alarm(handle, TEST_ALARM_TEXT, &alarm_info.trigger_time, alarm_info.trigger_days, TEST_TEST_SOUND_FILE, TEST_SNOOZE_VALUE, &alarm_id);
+        (void)alarm_scheduler_delete_alarm(handle, alarm_id);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_remove_item(IGNORED_ARG, IGNORED_ARG));
-
         // act
-        int result = alarm_scheduler_delete_alarm(handle, alarm_info.alarm_id);
+        const ALARM_INFO* result = alarm_scheduler_is_triggered(handle, &test_tm);
 
         // assert
-        CTEST_ASSERT_ARE_EQUAL(int, result, 0);
+        CTEST_ASSERT_IS_NULL(result);
+        CTEST_ASSERT_IS_NULL(alarm_scheduler_get_alarm_by_id(handle, alarm_id));
+        CTEST_ASSERT_ARE_EQUAL(int, 0, alarm_scheduler_get_alarm_count(handle));
         CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         // cleanup
@@ -846,10 +1224,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -891,10 +1267,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -937,10 +1311,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -984,10 +1356,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1028,10 +1398,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1072,10 +1440,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1125,11 +1491,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(3);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1180,11 +1543,8 @@ CTEST_BEGIN_TEST_SUITE(alarm_scheduler_ut)
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(3);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1232,12 +1592,8 @@ static const struct
             umock_c_reset_all_calls();
 
             struct tm time_value = test_alarm_value[index].curr_time;
+            STRICT_EXPECTED_CALL(get_time());
             STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&time_value);
-            STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(alarm_cnt);
-            for (size_t inner = 0; inner < alarm_cnt; inner++)
-            {
-               STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-            }
 
             // act
             const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1288,10 +1644,8 @@ static const struct
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(2);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1328,9 +1682,8 @@ static const struct
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1380,11 +1733,8 @@ static const struct
 
         umock_c_reset_all_calls();
 
+        STRICT_EXPECTED_CALL(get_time());
         STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(3);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
@@ -1398,6 +1748,254 @@ static const struct
         alarm_scheduler_destroy(handle);
     }
 
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_grown_slots_success)
+    {
+        // arrange
+        struct tm curr_time = {0};
+        curr_time.tm_hour = 17;
+        curr_time.tm_min = 8;
+        curr_time.tm_wday = 5;
+        ALARM_INFO alarm_list[20];
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 20; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+            alarm_list[index].trigger_days = Everyday;
+            alarm_list[index].trigger_time.hour = 22;
+            alarm_list[index].trigger_time.min = (uint8_t)index;
+        }
+        alarm_list[0].trigger_time.hour = 17;
+        alarm_list[0].trigger_time.min = 9;
+        alarm_list[15].trigger_time.hour = 17;
+        alarm_list[15].trigger_time.min = 30;
+        alarm_list[15].alarm_text = (char*)TEST_ALARM_1_TEXT;
+        (void)alarm_scheduler_add_alarms(handle, alarm_list, 20);
+        (void)alarm_scheduler_remove_alarm(handle, 0);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(get_time());
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_1_TEXT, alarm_info->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(int, 19, alarm_scheduler_get_alarm_count(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_tie_success)
+    {
+        // arrange
+        struct tm curr_time = {0};
+        curr_time.tm_hour = 17;
+        curr_time.tm_min = 8;
+        curr_time.tm_wday = 5;
+        ALARM_INFO alarm_list[11];
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 11; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+            alarm_list[index].trigger_days = Everyday;
+            alarm_list[index].trigger_time.hour = 22;
+            alarm_list[index].trigger_time.min = 0;
+        }
+        alarm_list[0].alarm_text = (char*)TEST_ALARM_1_TEXT;
+        (void)alarm_scheduler_add_alarms(handle, alarm_list, 11);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(get_time());
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_1_TEXT, alarm_info->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_last_slot_success)
+    {
+        // arrange
+        struct tm curr_time = {0};
+        curr_time.tm_hour = 17;
+        curr_time.tm_min = 8;
+        curr_time.tm_wday = 5;
+        ALARM_INFO alarm_list[11];
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        for (size_t index = 0; index < 11; index++)
+        {
+            setup_alarm_time_info(&alarm_list[index], &test_tm);
+            alarm_list[index].trigger_days = Everyday;
+            alarm_list[index].trigger_time.hour = 22;
+            alarm_list[index].trigger_time.min = 0;
+        }
+        alarm_list[10].trigger_days = Friday;
+        alarm_list[10].trigger_time.hour = 17;
+        alarm_list[10].trigger_time.min = 30;
+        alarm_list[10].alarm_text = (char*)TEST_ALARM_2_TEXT;
+        (void)alarm_scheduler_add_alarms(handle, alarm_list, 11);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(get_time());
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&curr_time);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_2_TEXT, alarm_info->alarm_text);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_cached_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_info1 = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&alarm_info1, &test_tm);
+        alarm_info1.trigger_days = Everyday;
+        alarm_info1.trigger_time.hour = 21;
+        alarm_info1.alarm_text = (char*)TEST_ALARM_1_TEXT;
+        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
+
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1000);
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&test_tm);
+        const ALARM_INFO* first_alarm = alarm_scheduler_get_next_alarm(handle);
+        uint32_t first_generation = alarm_scheduler_get_next_alarm_generation(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1060);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_TRUE(first_alarm == alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, first_generation, alarm_scheduler_get_next_alarm_generation(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_add_alarm_recalc_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_info1 = {0};
+        ALARM_INFO alarm_info2 = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&alarm_info1, &test_tm);
+        alarm_info1.trigger_days = Everyday;
+        alarm_info1.trigger_time.hour = 21;
+        alarm_info1.alarm_text = (char*)TEST_ALARM_1_TEXT;
+        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
+
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1000);
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&test_tm);
+        (void)alarm_scheduler_get_next_alarm(handle);
+        uint32_t first_generation = alarm_scheduler_get_next_alarm_generation(handle);
+
+        setup_alarm_time_info(&alarm_info2, &test_tm);
+        alarm_info2.trigger_days = Everyday;
+        alarm_info2.trigger_time.hour = 11;
+        alarm_info2.alarm_text = (char*)TEST_ALARM_2_TEXT;
+        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info2);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1060);
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&test_tm);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_ALARM_2_TEXT, alarm_info->alarm_text);
+        CTEST_ASSERT_ARE_NOT_EQUAL(uint32_t, first_generation, alarm_scheduler_get_next_alarm_generation(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_expired_recalc_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_info1 = {0};
+        set_tm_struct(&test_tm);
+
+        SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&alarm_info1, &test_tm);
+        alarm_info1.trigger_days = Everyday;
+        alarm_info1.trigger_time.min = 11;
+        alarm_info1.alarm_text = (char*)TEST_ALARM_1_TEXT;
+        (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
+
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1000);
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&test_tm);
+        (void)alarm_scheduler_get_next_alarm(handle);
+        umock_c_reset_all_calls();
+
+        // The alarm is due a minute later
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(1060);
+        STRICT_EXPECTED_CALL(get_time_value()).SetReturn(&test_tm);
+
+        // act
+        const ALARM_INFO* alarm_info = alarm_scheduler_get_next_alarm(handle);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(alarm_info);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        alarm_scheduler_destroy(handle);
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_next_alarm_generation_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        uint32_t result = alarm_scheduler_get_next_alarm_generation(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
 
     CTEST_FUNCTION(alarm_scheduler_get_next_day_success)
     {
@@ -1562,9 +2160,10 @@ static const struct
         struct tm test_tm = {0};
         set_tm_struct(&test_tm);
         SCHEDULER_HANDLE handle = alarm_scheduler_create();
+        setup_alarm_time_info(&g_alarm_info, &test_tm);
+        (void)alarm_scheduler_add_alarm_info(handle, &g_alarm_info);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
 
         // act
         size_t result = alarm_scheduler_get_alarm_count(handle);
@@ -1592,7 +2191,6 @@ static const struct
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* result = alarm_scheduler_get_alarm(handle, 0);
@@ -1620,8 +2218,6 @@ static const struct
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* result = alarm_scheduler_get_alarm_by_id(handle, 100);
@@ -1685,9 +2281,6 @@ static const struct
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info3);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(3);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* result = alarm_scheduler_get_alarm_by_id(handle, 101);
@@ -1715,8 +2308,6 @@ static const struct
         (void)alarm_scheduler_add_alarm_info(handle, &alarm_info1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(item_list_item_count(IGNORED_ARG)).SetReturn(1);
-        STRICT_EXPECTED_CALL(item_list_get_item(IGNORED_ARG, IGNORED_ARG));
 
         // act
         const ALARM_INFO* result = alarm_scheduler_get_alarm_by_id(handle, 90);
@@ -1751,6 +2342,96 @@ static const struct
         alarm_scheduler_destroy(handle);
     }
 
+    CTEST_FUNCTION(alarm_scheduler_get_minutes_till_trigger_alarm_info_NULL_fail)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        set_tm_struct(&test_tm);
+
+        // act
+        uint32_t result = alarm_scheduler_get_minutes_till_trigger(NULL, &test_tm);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, ALARM_NO_TRIGGER, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_minutes_till_trigger_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_info1 = {0};
+        set_tm_struct(&test_tm);
+        alarm_info1.trigger_days = Friday;
+        alarm_info1.trigger_time.hour = 9;
+        alarm_info1.trigger_time.min = 0;
+
+        // act
+        uint32_t result = alarm_scheduler_get_minutes_till_trigger(&alarm_info1, &test_tm);
+
+        // assert
+        // Thursday 10:10 to Friday 9:00
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, 22*60+50, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_minutes_till_trigger_same_minute_success)
+    {
+        // arrange
+        struct tm test_tm = {0};
+        ALARM_INFO alarm_info1 = {0};
+        set_tm_struct(&test_tm);
+        setup_alarm_time_info(&alarm_info1, &test_tm);
+
+        // act
+        uint32_t result = alarm_scheduler_get_minutes_till_trigger(&alarm_info1, &test_tm);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, 7*24*60, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(alarm_scheduler_get_minutes_till_trigger_all_masks_success)
+    {
+        // arrange
+        static const TIME_INFO TRIGGER_TIMES[] = { {0, 0, 0}, {7, 30, 0}, {23, 59, 0} };
+        int mismatch_count = 0;
+
+        // act
+        for (size_t time_index = 0; time_index < sizeof(TRIGGER_TIMES)/sizeof(TRIGGER_TIMES[0]); time_index++)
+        {
+            for (uint32_t trigger_days = 0; trigger_days <= Everyday; trigger_days++)
+            {
+                ALARM_INFO alarm_info1 = {0};
+                alarm_info1.trigger_days = trigger_days;
+                alarm_info1.trigger_time = TRIGGER_TIMES[time_index];
+                for (int week_minute = 0; week_minute < 7*24*60; week_minute++)
+                {
+                    struct tm test_tm = {0};
+                    test_tm.tm_wday = week_minute / (24*60);
+                    test_tm.tm_hour = (week_minute % (24*60)) / 60;
+                    test_tm.tm_min = week_minute % 60;
+                    if (alarm_scheduler_get_minutes_till_trigger(&alarm_info1, &test_tm) != reference_minutes_till_trigger(trigger_days, &TRIGGER_TIMES[time_index], week_minute))
+                    {
+                        mismatch_count++;
+                    }
+                }
+            }
+        }
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, mismatch_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
     CTEST_FUNCTION(alarm_scheduler_is_morning_success)
     {
         // arrange
@@ -36,6 +36,7 @@ MOCKABLE_FUNCTION(, JSON_Value*, json_parse_string, const char *, string);
 MOCKABLE_FUNCTION(, JSON_Object*, json_value_get_object, const JSON_Value *, value);
 MOCKABLE_FUNCTION(, JSON_Array*, json_object_get_array, const JSON_Object*, object, const char*, name);
 MOCKABLE_FUNCTION(, size_t, json_array_get_count, const JSON_Array*, array);
+MOCKABLE_FUNCTION(, const char*, json_array_get_string, const JSON_Array*, array, size_t, index);
 MOCKABLE_FUNCTION(, JSON_Status, json_serialize_to_file, const JSON_Value*, value, const char *, filename);
 MOCKABLE_FUNCTION(, JSON_Value*, json_parse_file, const char*, string);
 MOCKABLE_FUNCTION(, double, json_object_get_number, const JSON_Object*, object, const char*, name);
@@ -100,6 +101,7 @@ static const char* TEST_ZIPCODE_NODE = "zipcode";
 static const char* TEST_ZIPCODE = "12345";
 static const char* TEST_NEW_ZIPCODE = "67890";
 static const char* TEST_NTP_ADDRESS = "127.0.0.1";
+static const char* TEST_NTP_SERVERS_NODE = "ntpServers";
 static const char* TEST_AUDIO_DIR = "/audio/directory";
 static const char* TEST_SHADE_START = "shadeStart";
 static const char* TEST_SHADE_END = "shadeEnd";
@@ -114,6 +116,14 @@ static TIME_VALUE_STORAGE TEST_ALARM_ARRAY = { 12, 30, 0 };
 static TIME_VALUE_STORAGE TEST_INVALID_ALARM_ARRAY = { 25, 30, 0 };
 static uint32_t TEST_DIGIT_COLOR = 3;
 static uint32_t TEST_DEFAULT_DIGIT_COLOR = 0;
+static const char* TEST_ALARM_PREPARE_NODE = "alarmPrepareTime";
+static uint32_t TEST_ALARM_PREPARE_TIME = 30;
+static uint32_t TEST_DEFAULT_ALARM_PREPARE_TIME = 60;
+static const char* TEST_SOUND_CACHE_NODE = "soundCacheSize";
+static uint32_t TEST_SOUND_CACHE_SIZE = 1024;
+static uint32_t TEST_DEFAULT_SOUND_CACHE_SIZE = 8192;
+static const char* TEST_CRESCENDO_TIME_NODE = "crescendoTime";
+static uint32_t TEST_CRESCENDO_TIME = 45;
 
 static int load_alarms_cb(void* context, const CONFIG_ALARM_INFO* cfg_alarm)
 {
@@ -187,6 +197,8 @@ CTEST_BEGIN_TEST_SUITE(config_mgr_ut)
         REGISTER_GLOBAL_MOCK_RETURN(json_serialize_to_file_pretty, JSONSuccess);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_serialize_to_file_pretty, JSONFailure);
         REGISTER_GLOBAL_MOCK_RETURN(json_array_get_count, 1);
+        REGISTER_GLOBAL_MOCK_RETURN(json_array_get_string, TEST_NODE_STRING);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_array_get_string, NULL);
         REGISTER_GLOBAL_MOCK_RETURN(json_array_get_object, TEST_JSON_OBJECT);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_array_get_object, NULL);
         REGISTER_GLOBAL_MOCK_RETURN(json_object_get_boolean, 1);
@@ -836,6 +848,143 @@ CTEST_BEGIN_TEST_SUITE(config_mgr_ut)
         config_mgr_destroy(handle);
     }
 
+    CTEST_FUNCTION(config_mgr_get_alarm_prepare_time_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        uint32_t result = config_mgr_get_alarm_prepare_time(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_DEFAULT_ALARM_PREPARE_TIME, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(config_mgr_get_alarm_prepare_time_success)
+    {
+        // arrange
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_ARG, TEST_ALARM_PREPARE_NODE)).SetReturn(TEST_ALARM_PREPARE_TIME);
+
+        // act
+        uint32_t result = config_mgr_get_alarm_prepare_time(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_ALARM_PREPARE_TIME, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_alarm_prepare_time_missing_success)
+    {
+        // arrange
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_ARG, TEST_ALARM_PREPARE_NODE)).SetReturn(0);
+
+        // act
+        uint32_t result = config_mgr_get_alarm_prepare_time(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_DEFAULT_ALARM_PREPARE_TIME, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_sound_cache_size_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        uint32_t result = config_mgr_get_sound_cache_size(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_DEFAULT_SOUND_CACHE_SIZE, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(config_mgr_get_sound_cache_size_success)
+    {
+        // arrange
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_ARG, TEST_SOUND_CACHE_NODE)).SetReturn(TEST_SOUND_CACHE_SIZE);
+
+        // act
+        uint32_t result = config_mgr_get_sound_cache_size(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_SOUND_CACHE_SIZE, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_crescendo_time_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        uint32_t result = config_mgr_get_crescendo_time(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(config_mgr_get_crescendo_time_success)
+    {
+        // arrange
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_ARG, TEST_CRESCENDO_TIME_NODE)).SetReturn(TEST_CRESCENDO_TIME);
+
+        // act
+        uint32_t result = config_mgr_get_crescendo_time(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, TEST_CRESCENDO_TIME, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_crescendo_time_missing_success)
+    {
+        // arrange
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_ARG, TEST_CRESCENDO_TIME_NODE)).SetReturn(0);
+
+        // act
+        uint32_t result = config_mgr_get_crescendo_time(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(uint32_t, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
     CTEST_FUNCTION(config_mgr_set_digit_color_success)
     {
         // arrange
@@ -967,6 +1116,110 @@ CTEST_BEGIN_TEST_SUITE(config_mgr_ut)
         config_mgr_destroy(handle);
     }
 
+    CTEST_FUNCTION(config_mgr_get_ntp_servers_handle_NULL_fail)
+    {
+        // arrange
+        const char* server_list[4];
+
+        // act
+        size_t result = config_mgr_get_ntp_servers(NULL, server_list, 4);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(config_mgr_get_ntp_servers_list_NULL_fail)
+    {
+        // arrange
+        const char* server_list[4];
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t list_result = config_mgr_get_ntp_servers(handle, NULL, 4);
+        size_t count_result = config_mgr_get_ntp_servers(handle, server_list, 0);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, list_result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, count_result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_ntp_servers_success)
+    {
+        // arrange
+        const char* server_list[4];
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_array(IGNORED_ARG, TEST_NTP_SERVERS_NODE));
+        STRICT_EXPECTED_CALL(json_array_get_count(IGNORED_ARG)).SetReturn(2);
+        STRICT_EXPECTED_CALL(json_array_get_string(IGNORED_ARG, 0)).SetReturn(TEST_NTP_ADDRESS);
+        STRICT_EXPECTED_CALL(json_array_get_string(IGNORED_ARG, 1)).SetReturn(TEST_NTP_ADDRESS);
+
+        // act
+        size_t result = config_mgr_get_ntp_servers(handle, server_list, 4);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 2, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_NTP_ADDRESS, server_list[1]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_ntp_servers_list_full_success)
+    {
+        // arrange
+        const char* server_list[2];
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_array(IGNORED_ARG, TEST_NTP_SERVERS_NODE));
+        STRICT_EXPECTED_CALL(json_array_get_count(IGNORED_ARG)).SetReturn(5);
+        STRICT_EXPECTED_CALL(json_array_get_string(IGNORED_ARG, 0));
+        STRICT_EXPECTED_CALL(json_array_get_string(IGNORED_ARG, 1));
+
+        // act
+        size_t result = config_mgr_get_ntp_servers(handle, server_list, 2);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 2, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(config_mgr_get_ntp_servers_address_fallback_success)
+    {
+        // arrange
+        const char* server_list[4];
+        CONFIG_MGR_HANDLE handle = config_mgr_create(TEST_CONFIG_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(json_object_get_array(IGNORED_ARG, TEST_NTP_SERVERS_NODE)).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_ARG, "ntpAddress")).SetReturn(TEST_NTP_ADDRESS);
+
+        // act
+        size_t result = config_mgr_get_ntp_servers(handle, server_list, 4);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 1, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, TEST_NTP_ADDRESS, server_list[0]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        config_mgr_destroy(handle);
+    }
+
     CTEST_FUNCTION(config_mgr_get_audio_dir_handle_NULL_fail)
     {
         // arrange
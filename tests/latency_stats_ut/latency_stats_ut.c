@@ -0,0 +1,175 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "ctest.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+
+#include "umock_c/umocktypes_charptr.h"
+
+#include "latency_stats.h"
+
+static LATENCY_HISTOGRAM g_histogram;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    CTEST_ASSERT_FAIL("umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+CTEST_BEGIN_TEST_SUITE(latency_stats_ut)
+
+    CTEST_SUITE_INITIALIZE()
+    {
+        int result;
+
+        (void)umock_c_init(on_umock_c_error);
+
+        result = umocktypes_charptr_register_types();
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+    }
+
+    CTEST_SUITE_CLEANUP()
+    {
+        umock_c_deinit();
+    }
+
+    CTEST_FUNCTION_INITIALIZE()
+    {
+        umock_c_reset_all_calls();
+        latency_stats_init(&g_histogram);
+    }
+
+    CTEST_FUNCTION_CLEANUP()
+    {
+    }
+
+    CTEST_FUNCTION(latency_stats_get_percentile_empty_succeed)
+    {
+        // arrange
+
+        // act
+        uint64_t result = latency_stats_get_percentile(&g_histogram, 50);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, latency_stats_get_count(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)latency_stats_get_mean(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_get_percentile_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        uint64_t result = latency_stats_get_percentile(NULL, 50);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_get_percentile_invalid_percentile_fail)
+    {
+        // arrange
+        latency_stats_add(&g_histogram, 100);
+
+        // act
+        uint64_t zero_result = latency_stats_get_percentile(&g_histogram, 0);
+        uint64_t over_result = latency_stats_get_percentile(&g_histogram, 101);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)zero_result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)over_result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_get_percentile_small_values_exact_succeed)
+    {
+        // arrange
+        for (uint64_t index = 0; index < LATENCY_SUB_BUCKET_COUNT; index++)
+        {
+            latency_stats_add(&g_histogram, index);
+        }
+
+        // act
+        uint64_t p50 = latency_stats_get_percentile(&g_histogram, 50);
+        uint64_t p100 = latency_stats_get_percentile(&g_histogram, 100);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 3, (int)p50);
+        CTEST_ASSERT_ARE_EQUAL(int, 7, (int)p100);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_get_percentile_succeed)
+    {
+        // arrange
+        for (uint64_t index = 1; index <= 1000; index++)
+        {
+            latency_stats_add(&g_histogram, index*1000);
+        }
+
+        // act
+        uint64_t p50 = latency_stats_get_percentile(&g_histogram, 50);
+        uint64_t p99 = latency_stats_get_percentile(&g_histogram, 99);
+
+        // assert
+        CTEST_ASSERT_IS_TRUE(p50 >= 500000 && p50 <= 500000 + 500000/LATENCY_SUB_BUCKET_COUNT);
+        CTEST_ASSERT_IS_TRUE(p99 >= 990000 && p99 <= 1000000);
+        CTEST_ASSERT_ARE_EQUAL(int, 1000, latency_stats_get_count(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(int, 500500, (int)latency_stats_get_mean(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(int, 1000000, (int)latency_stats_get_max(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_add_clamps_max_succeed)
+    {
+        // arrange
+
+        // act
+        latency_stats_add(&g_histogram, UINT64_MAX);
+
+        // assert
+        CTEST_ASSERT_IS_TRUE(latency_stats_get_max(&g_histogram) == LATENCY_MAX_USEC);
+        CTEST_ASSERT_IS_TRUE(latency_stats_get_percentile(&g_histogram, 100) == LATENCY_MAX_USEC);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(latency_stats_add_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        latency_stats_add(NULL, 100);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, latency_stats_get_count(&g_histogram));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+CTEST_END_TEST_SUITE(latency_stats_ut)
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #endif
+#include <arpa/inet.h>
 
 static void* my_mem_shim_malloc(size_t size)
 {
@@ -41,14 +42,20 @@ static void my_mem_shim_free(void* ptr)
 
 #define ENABLE_MOCKS
 MOCKABLE_FUNCTION(, void, ntp_time_callback, void*, user_ctx, NTP_OPERATION_RESULT, ntp_result, time_t, current_time);
+MOCKABLE_FUNCTION(, void, ntp_offset_callback, void*, user_ctx, NTP_OPERATION_RESULT, ntp_result, const struct timespec*, offset, const struct timespec*, delay);
 #undef ENABLE_MOCKS
 
 static const char* TEST_NTP_SERVER_ADDRESS = "test_server.org";
+static const char* TEST_NTP_SERVER_LIST[] = { "0.test_server.org", "1.test_server.org", "127.0.0.1:12300" };
+static const unsigned long long TEST_NTP_TIMESTAMP_DELTA = 2208988800ull;
+static const uint32_t TEST_SERVER_TIME = 133102800; // Thursday, March 21, 1974 1:00:00 PM
 
 #define TEST_cord_socket_INTERFACE_DESCRIPTION     (const IO_INTERFACE_DESCRIPTION*)0x4242
 #define TEST_IO_HANDLE                            (CORD_HANDLE)0x4243
 
 #define NTP_TEST_PACKET_SIZE                    48
+#define TEST_SERVER_COUNT                       3
+#define TEST_MAX_RESPONDERS                     4
 
 typedef struct TEST_NTP_PACKET_TAG
 {
@@ -98,12 +105,40 @@ static void* g_on_io_error_context;
 static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
 static void* g_on_io_close_complete_context;
 static int g_call_completion = 0;
+static NTP_OPERATION_RESULT g_callback_result;
+static time_t g_callback_time;
+static bool g_callback_has_offset;
+static struct timespec g_callback_offset;
+static struct timespec g_callback_delay;
+
+// Stands in for the time servers, one entry per socket the client opens
+typedef struct TEST_RESPONDER_TAG
+{
+    CORD_HANDLE socket_io;
+    ON_IO_OPEN_COMPLETE on_open_complete;
+    void* on_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    // Transmit time of the last request, a server echoes it as the originate time
+    uint32_t request_tm_s;
+    uint32_t request_tm_f;
+} TEST_RESPONDER;
+
+static TEST_RESPONDER g_responder_list[TEST_MAX_RESPONDERS];
+static size_t g_responder_count;
 
 static int my_socket_open(CORD_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context)
 {
-    (void)socket_io;
     g_on_io_open_complete = on_io_open_complete;
     g_on_io_open_complete_context = on_io_open_complete_context;
+    for (size_t index = 0; index < g_responder_count; index++)
+    {
+        if (g_responder_list[index].socket_io == socket_io)
+        {
+            g_responder_list[index].on_open_complete = on_io_open_complete;
+            g_responder_list[index].on_open_complete_context = on_io_open_complete_context;
+        }
+    }
     return 0;
 }
 
@@ -122,7 +157,34 @@ static CORD_HANDLE my_socket_create(const void* create_parameters, const PATCHCO
     g_on_bytes_received_context = client_cb->on_bytes_received_ctx;
     g_on_io_error = client_cb->on_io_error;
     g_on_io_error_context = client_cb->on_io_error_ctx;
-    return my_mem_shim_malloc(1);
+    CORD_HANDLE result = my_mem_shim_malloc(1);
+    if (g_responder_count < TEST_MAX_RESPONDERS)
+    {
+        g_responder_list[g_responder_count].socket_io = result;
+        g_responder_list[g_responder_count].on_bytes_received = client_cb->on_bytes_received;
+        g_responder_list[g_responder_count].on_bytes_received_context = client_cb->on_bytes_received_ctx;
+        g_responder_count++;
+    }
+    return result;
+}
+
+static int my_cord_socket_send(CORD_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* context)
+{
+    const TEST_NTP_PACKET* request = (const TEST_NTP_PACKET*)buffer;
+    (void)size;
+    (void)on_send_complete;
+    (void)context;
+    g_test_recv_packet.origTm_s = request->txTm_s;
+    g_test_recv_packet.origTm_f = request->txTm_f;
+    for (size_t index = 0; index < g_responder_count; index++)
+    {
+        if (g_responder_list[index].socket_io == socket_io)
+        {
+            g_responder_list[index].request_tm_s = request->txTm_s;
+            g_responder_list[index].request_tm_f = request->txTm_f;
+        }
+    }
+    return 0;
 }
 
 static void my_socket_destroy(CORD_HANDLE socket_io)
@@ -164,10 +226,88 @@ static void my_ntp_time_callback(void* user_ctx, NTP_OPERATION_RESULT ntp_result
 {
 }
 
+static void my_ntp_time_callback_hook(void* user_ctx, NTP_OPERATION_RESULT ntp_result, time_t current_time)
+{
+    (void)user_ctx;
+    g_callback_result = ntp_result;
+    g_callback_time = current_time;
+}
+
+static void my_ntp_offset_callback_hook(void* user_ctx, NTP_OPERATION_RESULT ntp_result, const struct timespec* offset, const struct timespec* delay)
+{
+    (void)user_ctx;
+    g_callback_result = ntp_result;
+    g_callback_has_offset = offset != NULL && delay != NULL;
+    if (g_callback_has_offset)
+    {
+        g_callback_offset = *offset;
+        g_callback_delay = *delay;
+    }
+}
+
+static int64_t get_timespec_ms(const struct timespec* value)
+{
+    return (int64_t)value->tv_sec*1000 + value->tv_nsec/1000000;
+}
+
+// Builds a server reply that held the request for hold_ms before answering
+static void setup_reply_packet(TEST_NTP_PACKET* packet, uint32_t server_time, uint32_t hold_ms)
+{
+    uint64_t transmit = (uint64_t)(server_time + TEST_NTP_TIMESTAMP_DELTA) << 32;
+    uint64_t receive = transmit - (((uint64_t)hold_ms << 32)/1000);
+    memset(packet, 0, sizeof(TEST_NTP_PACKET));
+    packet->li_vn_mode = 0x24;
+    packet->stratum = 2;
+    packet->rxTm_s = htonl((uint32_t)(receive >> 32));
+    packet->rxTm_f = htonl((uint32_t)receive);
+    packet->txTm_s = htonl((uint32_t)(transmit >> 32));
+    packet->txTm_f = htonl((uint32_t)transmit);
+}
+
+// Builds a reply from a server whose clock runs offset_ms ahead of ours
+static void setup_offset_reply_packet(TEST_NTP_PACKET* packet, int64_t offset_ms)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t server_ms = (int64_t)now.tv_sec*1000 + now.tv_nsec/1000000 + offset_ms;
+    setup_reply_packet(packet, (uint32_t)(server_ms/1000), 0);
+    packet->rxTm_f = packet->txTm_f = htonl((uint32_t)((((uint64_t)(server_ms % 1000)) << 32)/1000));
+}
+
+static void respond_to_client(size_t index, const TEST_NTP_PACKET* packet)
+{
+    TEST_NTP_PACKET reply = *packet;
+    reply.origTm_s = g_responder_list[index].request_tm_s;
+    reply.origTm_f = g_responder_list[index].request_tm_f;
+    g_responder_list[index].on_bytes_received(g_responder_list[index].on_bytes_received_context, (const unsigned char*)&reply, NTP_TEST_PACKET_SIZE);
+}
+
+// Runs a whole query against a single server running offset_ms ahead
+static void run_offset_query(NTP_CLIENT_HANDLE handle, int64_t offset_ms)
+{
+    TEST_NTP_PACKET reply;
+    g_responder_count = 0;
+    (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, 20, ntp_offset_callback, NULL);
+    g_responder_list[0].on_open_complete(g_responder_list[0].on_open_complete_context, IO_OPEN_OK);
+    ntp_client_process(handle);
+    setup_offset_reply_packet(&reply, offset_ms);
+    respond_to_client(0, &reply);
+    ntp_client_process(handle);
+}
+
+static void open_responders(void)
+{
+    for (size_t index = 0; index < g_responder_count; index++)
+    {
+        g_responder_list[index].on_open_complete(g_responder_list[index].on_open_complete_context, IO_OPEN_OK);
+    }
+}
+
 static void setup_ntp_client_get_time_mocks(NTP_CLIENT_HANDLE handle, size_t ntp_timeout)
 {
     STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG));
-    STRICT_EXPECTED_CALL(cord_socket_open(IGNORED_ARG, IGNORED_ARG, handle));
+    (void)handle;
+    STRICT_EXPECTED_CALL(cord_socket_open(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
     STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, ntp_timeout));
 }
 
@@ -191,6 +331,7 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(NTP_OPERATION_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(time_t, long);
+        REGISTER_UMOCK_ALIAS_TYPE(const struct timespec*, void*);
         //REGISTER_TYPE(const cord_socket_CONFIG*, const_cord_socket_CONFIG_ptr);
         //REGISTER_UMOCK_ALIAS_TYPE(cord_socket_CONFIG*, const cord_socket_CONFIG*);
 
@@ -212,19 +353,18 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         REGISTER_GLOBAL_MOCK_HOOK(cord_socket_open, my_socket_open);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(cord_socket_open, __LINE__);
         REGISTER_GLOBAL_MOCK_HOOK(cord_socket_close, my_socket_close);
-        REGISTER_GLOBAL_MOCK_RETURN(cord_socket_send, 0);
+        REGISTER_GLOBAL_MOCK_HOOK(cord_socket_send, my_cord_socket_send);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(cord_socket_send, __LINE__);
 
-        //REGISTER_GLOBAL_MOCK_HOOK(ntp_time_callback, my_ntp_time_callback);
+        REGISTER_GLOBAL_MOCK_HOOK(ntp_time_callback, my_ntp_time_callback_hook);
+        REGISTER_GLOBAL_MOCK_HOOK(ntp_offset_callback, my_ntp_offset_callback_hook);
 
         result = umocktypes_charptr_register_types();
         CTEST_ASSERT_ARE_EQUAL(int, 0, result);
 
         REGISTER_UMOCK_ALIAS_TYPE(ALARM_TIMER_HANDLE, void*);
 
-        memset(&g_test_recv_packet, 0, sizeof(TEST_NTP_PACKET) );
-        g_test_recv_packet.li_vn_mode = 0x1b;
-        g_test_recv_packet.txTm_s = 133102800; // Thursday, March 21, 1974 1:00:00 PM
+        setup_reply_packet(&g_test_recv_packet, TEST_SERVER_TIME, 0);
     }
 
     CTEST_SUITE_CLEANUP()
@@ -236,6 +376,10 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
     {
         umock_c_reset_all_calls();
         g_call_completion = 0;
+        g_responder_count = 0;
+        g_callback_result = NTP_OP_RESULT_COMM_ERR;
+        g_callback_time = 0;
+        g_callback_has_offset = false;
     }
 
     CTEST_FUNCTION_CLEANUP()
@@ -417,6 +561,7 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_send(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alarm_timer_reset(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG));
 
         // act
         ntp_client_process(handle);
@@ -440,6 +585,7 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_send(IGNORED_ARG, IGNORED_ARG, 48, IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alarm_timer_reset(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG));
 
         // act
         ntp_client_process(handle);
@@ -519,6 +665,434 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         ntp_client_destroy(handle);
     }
 
+    CTEST_FUNCTION(ntp_client_get_time_multi_invalid_args_fail)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        umock_c_reset_all_calls();
+
+        // act
+        int list_result = ntp_client_get_time_multi(handle, NULL, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+        int empty_result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, 0, ntp_timeout, ntp_time_callback, NULL);
+        int count_result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, NTP_CLIENT_MAX_SERVERS + 1, ntp_timeout, ntp_time_callback, NULL);
+        int callback_result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, NULL, NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, list_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, empty_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, count_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, callback_result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_time_multi_succeed)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        umock_c_reset_all_calls();
+
+        for (size_t index = 0; index < TEST_SERVER_COUNT; index++)
+        {
+            STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG));
+            STRICT_EXPECTED_CALL(cord_socket_open(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        }
+        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, ntp_timeout));
+
+        // act
+        int result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, TEST_SERVER_COUNT, g_responder_count);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_time_multi_unreachable_server_succeed)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_open(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_open(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, ntp_timeout));
+
+        // act
+        int result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_time_multi_in_progress_fail)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+        umock_c_reset_all_calls();
+
+        // act
+        int result = ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_multi_lowest_delay_succeed)
+    {
+        size_t ntp_timeout = 20;
+        TEST_NTP_PACKET invalid_reply;
+        TEST_NTP_PACKET slow_reply;
+        TEST_NTP_PACKET best_reply;
+
+        // arrange
+        setup_reply_packet(&invalid_reply, TEST_SERVER_TIME + 500, 0);
+        // Stratum 0 is a kiss-o'-death reply and gets thrown out
+        invalid_reply.stratum = 0;
+        setup_reply_packet(&slow_reply, TEST_SERVER_TIME, 0);
+        // Answers last but held the request for most of its round trip
+        setup_reply_packet(&best_reply, TEST_SERVER_TIME + 100, 35);
+
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        // act
+        respond_to_client(2, &invalid_reply);
+        sleep_for_now(20);
+        respond_to_client(0, &slow_reply);
+        ntp_client_process(handle);
+        sleep_for_now(20);
+        respond_to_client(1, &best_reply);
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_SUCCESS, g_callback_result);
+        CTEST_ASSERT_ARE_EQUAL(int, TEST_SERVER_TIME + 100, (int)g_callback_time);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_multi_invalid_replies_fail)
+    {
+        size_t ntp_timeout = 20;
+        TEST_NTP_PACKET invalid_reply;
+
+        // arrange
+        setup_reply_packet(&invalid_reply, TEST_SERVER_TIME, 0);
+        // Leap indicator 3 is a server that is not synchronized
+        invalid_reply.li_vn_mode = 0xE4;
+
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_time_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        // act
+        for (size_t index = 0; index < TEST_SERVER_COUNT; index++)
+        {
+            respond_to_client(index, &invalid_reply);
+        }
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_INVALID_DATA_ERR, g_callback_result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)g_callback_time);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_stale_reply_fail)
+    {
+        size_t ntp_timeout = 20;
+        TEST_NTP_PACKET stale_reply;
+
+        // arrange
+        setup_reply_packet(&stale_reply, TEST_SERVER_TIME, 0);
+
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_time_multi(handle, TEST_NTP_SERVER_LIST, 1, ntp_timeout, ntp_time_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        // An answer to an earlier request carries a different originate time
+        g_responder_list[0].request_tm_f ^= htonl(1);
+        umock_c_reset_all_calls();
+
+        // act
+        respond_to_client(0, &stale_reply);
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_INVALID_DATA_ERR, g_callback_result);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, (int)g_callback_time);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_offset_invalid_args_fail)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        umock_c_reset_all_calls();
+
+        // act
+        int handle_result = ntp_client_get_offset(NULL, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, ntp_offset_callback, NULL);
+        int list_result = ntp_client_get_offset(handle, NULL, TEST_SERVER_COUNT, ntp_timeout, ntp_offset_callback, NULL);
+        int count_result = ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, NTP_CLIENT_MAX_SERVERS + 1, ntp_timeout, ntp_offset_callback, NULL);
+        int callback_result = ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, TEST_SERVER_COUNT, ntp_timeout, NULL, NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, handle_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, list_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, count_result);
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, callback_result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_offset_ahead_succeed)
+    {
+        size_t ntp_timeout = 20;
+        TEST_NTP_PACKET reply;
+
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, ntp_timeout, ntp_offset_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        // act
+        setup_offset_reply_packet(&reply, 10250);
+        respond_to_client(0, &reply);
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_SUCCESS, g_callback_result);
+        CTEST_ASSERT_IS_TRUE(g_callback_has_offset);
+        CTEST_ASSERT_ARE_EQUAL(int, 10, (int)g_callback_offset.tv_sec);
+        // Half the round trip is taken off the reply time
+        CTEST_ASSERT_IS_TRUE(get_timespec_ms(&g_callback_offset) >= 10200 && get_timespec_ms(&g_callback_offset) <= 10251);
+        CTEST_ASSERT_IS_TRUE(get_timespec_ms(&g_callback_delay) >= 0 && get_timespec_ms(&g_callback_delay) < 100);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_offset_behind_succeed)
+    {
+        size_t ntp_timeout = 20;
+        TEST_NTP_PACKET reply;
+
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, ntp_timeout, ntp_offset_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        // act
+        setup_offset_reply_packet(&reply, -2500);
+        respond_to_client(0, &reply);
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_SUCCESS, g_callback_result);
+        CTEST_ASSERT_IS_TRUE(g_callback_has_offset);
+        // A negative offset keeps tv_nsec positive
+        CTEST_ASSERT_ARE_EQUAL(int, -3, (int)g_callback_offset.tv_sec);
+        CTEST_ASSERT_IS_TRUE(g_callback_offset.tv_nsec >= 0 && g_callback_offset.tv_nsec < 1000000000);
+        CTEST_ASSERT_IS_TRUE(get_timespec_ms(&g_callback_offset) >= -2550 && get_timespec_ms(&g_callback_offset) <= -2499);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_offset_timeout_fail)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, ntp_timeout, ntp_offset_callback, NULL);
+        open_responders();
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG)).SetReturn(true);
+        STRICT_EXPECTED_CALL(cord_socket_close(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_destroy(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(ntp_offset_callback(IGNORED_ARG, NTP_OP_RESULT_TIMEOUT, NULL, NULL));
+
+        // act
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        CTEST_ASSERT_IS_FALSE(g_callback_has_offset);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_poll_interval_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        size_t result = ntp_client_get_poll_interval(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_CLIENT_MIN_POLL_SEC, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(ntp_client_get_poll_interval_initial_succeed)
+    {
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        umock_c_reset_all_calls();
+
+        // act
+        size_t result = ntp_client_get_poll_interval(handle);
+
+        // assert
+        CTEST_ASSERT_IS_TRUE(result >= NTP_CLIENT_MIN_POLL_SEC && result <= NTP_CLIENT_MIN_POLL_SEC + NTP_CLIENT_MIN_POLL_SEC/8);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_poll_interval_steady_clock_succeed)
+    {
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        run_offset_query(handle, 0);
+        run_offset_query(handle, 0);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t result = ntp_client_get_poll_interval(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_SUCCESS, g_callback_result);
+        CTEST_ASSERT_IS_TRUE(result >= 2*NTP_CLIENT_MIN_POLL_SEC && result <= 2*NTP_CLIENT_MIN_POLL_SEC + NTP_CLIENT_MIN_POLL_SEC/4);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_poll_interval_large_offset_succeed)
+    {
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        run_offset_query(handle, 0);
+        run_offset_query(handle, 0);
+        // The clock jumped, polling starts over from the shortest interval
+        run_offset_query(handle, 10250);
+        umock_c_reset_all_calls();
+
+        // act
+        size_t result = ntp_client_get_poll_interval(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, NTP_OP_RESULT_SUCCESS, g_callback_result);
+        CTEST_ASSERT_IS_TRUE(result >= NTP_CLIENT_MIN_POLL_SEC && result <= NTP_CLIENT_MIN_POLL_SEC + NTP_CLIENT_MIN_POLL_SEC/8);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_get_poll_interval_backoff_succeed)
+    {
+        size_t first_result;
+        size_t second_result;
+
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+        (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, 20, ntp_offset_callback, NULL);
+        first_result = ntp_client_get_poll_interval(handle);
+        STRICT_EXPECTED_CALL(cord_socket_create(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+        (void)ntp_client_get_offset(handle, TEST_NTP_SERVER_LIST, 1, 20, ntp_offset_callback, NULL);
+        umock_c_reset_all_calls();
+
+        // act
+        second_result = ntp_client_get_poll_interval(handle);
+
+        // assert
+        // Retries come well before the regular poll and double each time
+        CTEST_ASSERT_IS_TRUE(first_result >= 8 && first_result <= 16);
+        CTEST_ASSERT_IS_TRUE(second_result >= 16 && second_result <= 32);
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
+    CTEST_FUNCTION(ntp_client_process_timeout_fail)
+    {
+        size_t ntp_timeout = 20;
+        // arrange
+        NTP_CLIENT_HANDLE handle = ntp_client_create();
+        (void)ntp_client_get_time(handle, TEST_NTP_SERVER_ADDRESS, ntp_timeout, ntp_time_callback, NULL);
+        g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+        ntp_client_process(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG)).SetReturn(true);
+        STRICT_EXPECTED_CALL(cord_socket_close(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(cord_socket_destroy(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(ntp_time_callback(IGNORED_ARG, NTP_OP_RESULT_TIMEOUT, 0));
+
+        // act
+        ntp_client_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        ntp_client_destroy(handle);
+    }
+
     CTEST_FUNCTION(ntp_client_set_time_server_NULL_fail)
     {
         size_t ntp_timeout = 20;
@@ -549,6 +1123,7 @@ CTEST_BEGIN_TEST_SUITE(ntp_client_ut)
         STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_send(IGNORED_ARG, IGNORED_ARG, 48, IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alarm_timer_reset(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_close(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(cord_socket_process_item(IGNORED_ARG));
@@ -0,0 +1,247 @@
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include "ctest.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+
+#include "umock_c/umocktypes_charptr.h"
+
+#include "sample_convert.h"
+
+// Odd length so every vector kernel also runs its scalar tail
+#define TEST_SAMPLE_COUNT       1027
+#define TEST_FRAME_COUNT        (TEST_SAMPLE_COUNT/2)
+#define TEST_GAIN               0.35f
+
+static int16_t g_samples[TEST_SAMPLE_COUNT];
+static int16_t g_expected[TEST_SAMPLE_COUNT];
+static uint8_t g_bytes[TEST_SAMPLE_COUNT];
+
+static const SAMPLE_CONVERT_IMPL g_vector_impls[] = { SAMPLE_CONVERT_SSSE3, SAMPLE_CONVERT_AVX2 };
+
+static void fill_test_samples(void)
+{
+    uint32_t seed = 0x12345678;
+    for (size_t index = 0; index < TEST_SAMPLE_COUNT; index++)
+    {
+        seed = seed*1103515245 + 12345;
+        g_samples[index] = (int16_t)(seed >> 16);
+        g_bytes[index] = (uint8_t)(seed >> 24);
+    }
+    // Make sure the extremes are covered
+    g_samples[0] = INT16_MIN;
+    g_samples[1] = INT16_MIN;
+    g_samples[2] = INT16_MAX;
+    g_samples[3] = INT16_MAX;
+    g_bytes[0] = 0;
+    g_bytes[1] = 0xFF;
+}
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    CTEST_ASSERT_FAIL("umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+CTEST_BEGIN_TEST_SUITE(sample_convert_ut)
+
+    CTEST_SUITE_INITIALIZE()
+    {
+        int result;
+
+        (void)umock_c_init(on_umock_c_error);
+
+        result = umocktypes_charptr_register_types();
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+    }
+
+    CTEST_SUITE_CLEANUP()
+    {
+        umock_c_deinit();
+    }
+
+    CTEST_FUNCTION_INITIALIZE()
+    {
+        umock_c_reset_all_calls();
+        fill_test_samples();
+        (void)sample_convert_set_impl(SAMPLE_CONVERT_SCALAR);
+    }
+
+    CTEST_FUNCTION_CLEANUP()
+    {
+    }
+
+    CTEST_FUNCTION(sample_convert_set_impl_scalar_succeed)
+    {
+        // arrange
+
+        // act
+        int result = sample_convert_set_impl(SAMPLE_CONVERT_SCALAR);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SAMPLE_CONVERT_SCALAR, sample_convert_get_impl());
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_swap_16_succeed)
+    {
+        // arrange
+        int16_t samples[] = { 0x0102, (int16_t)0xFF00, 0x7F80 };
+
+        // act
+        sample_convert_swap_16(samples, 3);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0x0201, samples[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, 0x00FF, samples[1]);
+        CTEST_ASSERT_ARE_EQUAL(int, (int16_t)0x807F, samples[2]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_widen_8_succeed)
+    {
+        // arrange
+        uint8_t source[] = { 0, 0x80, 0xFF };
+        int16_t target[3];
+
+        // act
+        sample_convert_widen_8(source, target, 3);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, INT16_MIN, target[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, target[1]);
+        CTEST_ASSERT_ARE_EQUAL(int, 0x7F00, target[2]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_downmix_stereo_in_place_succeed)
+    {
+        // arrange
+        int16_t samples[] = { INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN, 100, -300 };
+
+        // act
+        sample_convert_downmix_stereo(samples, samples, 3);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, INT16_MAX, samples[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, INT16_MIN, samples[1]);
+        CTEST_ASSERT_ARE_EQUAL(int, -100, samples[2]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_apply_gain_succeed)
+    {
+        // arrange
+        int16_t samples[] = { 1000, -1000, INT16_MIN };
+
+        // act
+        sample_convert_apply_gain(samples, 3, 0.5f);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 500, samples[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, -500, samples[1]);
+        CTEST_ASSERT_ARE_EQUAL(int, -16384, samples[2]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_apply_gain_clamped_succeed)
+    {
+        // arrange
+        int16_t loud[] = { 1000, -1000 };
+        int16_t quiet[] = { 1000, -1000 };
+
+        // act
+        sample_convert_apply_gain(loud, 2, 2.0f);
+        sample_convert_apply_gain(quiet, 2, -1.0f);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 1000, loud[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, -1000, loud[1]);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, quiet[0]);
+        CTEST_ASSERT_ARE_EQUAL(int, 0, quiet[1]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sample_convert_vector_impl_matches_scalar_succeed)
+    {
+        // arrange
+        int16_t* actual = (int16_t*)malloc(sizeof(g_samples));
+        int16_t* widened = (int16_t*)malloc(sizeof(g_samples));
+
+        for (size_t index = 0; index < sizeof(g_vector_impls)/sizeof(g_vector_impls[0]); index++)
+        {
+            // Not every cpu has every kernel, there is nothing to compare then
+            if (sample_convert_set_impl(g_vector_impls[index]) != 0)
+            {
+                continue;
+            }
+
+            // act
+            memcpy(actual, g_samples, sizeof(g_samples));
+            sample_convert_swap_16(actual, TEST_SAMPLE_COUNT);
+            sample_convert_apply_gain(actual, TEST_SAMPLE_COUNT, TEST_GAIN);
+            sample_convert_downmix_stereo(actual, actual, TEST_FRAME_COUNT);
+            sample_convert_widen_8(g_bytes, widened, TEST_SAMPLE_COUNT);
+
+            (void)sample_convert_set_impl(SAMPLE_CONVERT_SCALAR);
+            memcpy(g_expected, g_samples, sizeof(g_samples));
+            sample_convert_swap_16(g_expected, TEST_SAMPLE_COUNT);
+            sample_convert_apply_gain(g_expected, TEST_SAMPLE_COUNT, TEST_GAIN);
+            sample_convert_downmix_stereo(g_expected, g_expected, TEST_FRAME_COUNT);
+
+            // assert
+            CTEST_ASSERT_ARE_EQUAL(int, 0, memcmp(g_expected, actual, TEST_FRAME_COUNT*sizeof(int16_t)));
+            sample_convert_widen_8(g_bytes, g_expected, TEST_SAMPLE_COUNT);
+            CTEST_ASSERT_ARE_EQUAL(int, 0, memcmp(g_expected, widened, sizeof(g_samples)));
+        }
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        free(actual);
+        free(widened);
+    }
+
+    CTEST_FUNCTION(sample_convert_swap_16_samples_NULL_fail)
+    {
+        // arrange
+        int16_t samples[] = { 0x0102 };
+
+        // act
+        sample_convert_swap_16(NULL, 1);
+        sample_convert_apply_gain(NULL, 1, 0.5f);
+        sample_convert_downmix_stereo(NULL, samples, 1);
+        sample_convert_widen_8(NULL, samples, 1);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0x0102, samples[0]);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+CTEST_END_TEST_SUITE(sample_convert_ut)
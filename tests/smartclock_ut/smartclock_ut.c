@@ -37,6 +37,8 @@ static void my_mem_shim_free(void* ptr)
 #include "sound_mgr.h"
 #include "gui_mgr.h"
 #include "time_mgr.h"
+#include "event_loop.h"
+#include "latency_stats.h"
 
 #undef ENABLE_MOCKS
 
@@ -59,6 +61,11 @@ static void* g_alarm_cb_ctx;
 static size_t g_iteration;
 static size_t g_close_iteration;
 static struct tm g_time_value = {0};
+static uint32_t g_next_alarm_generation = 0;
+static const time_t TEST_FIRE_TIME = 1615716000;
+static const uint32_t TEST_PREPARE_TIME = 60;
+static const char* TEST_AUDIO_DIR = "/audio/";
+static const char* TEST_SOUND_PATH = "/audio/alarm_sound.wav";
 
 #ifdef __cplusplus
 extern "C"
@@ -107,6 +114,12 @@ static void my_alarm_scheduler_destroy(SCHEDULER_HANDLE handle)
     my_mem_shim_free(handle);
 }
 
+static uint32_t my_alarm_scheduler_get_next_alarm_generation(SCHEDULER_HANDLE handle)
+{
+    (void)handle;
+    return ++g_next_alarm_generation;
+}
+
 static SOUND_MGR_HANDLE my_sound_mgr_create(void)
 {
     return (SOUND_MGR_HANDLE)my_mem_shim_malloc(1);
@@ -164,14 +177,27 @@ static void my_weather_client_destroy(WEATHER_CLIENT_HANDLE handle)
     my_mem_shim_free(handle);
 }
 
-static void my_thread_mgr_sleep(size_t milliseconds)
+static EVENT_LOOP_HANDLE my_event_loop_create(void)
+{
+    return (EVENT_LOOP_HANDLE)my_mem_shim_malloc(1);
+}
+
+static void my_event_loop_destroy(EVENT_LOOP_HANDLE handle)
+{
+    my_mem_shim_free(handle);
+}
+
+static int my_event_loop_wait(EVENT_LOOP_HANDLE handle, time_t wake_time, size_t max_wait_ms)
 {
-    (void)milliseconds;
+    (void)handle;
+    (void)wake_time;
+    (void)max_wait_ms;
     g_iteration++;
-    if (g_close_iteration >= g_iteration)
+    if (g_iteration >= g_close_iteration)
     {
         g_gui_notification(g_gui_notification_ctx, NOTIFICATION_APPLICATION_RESULT, NULL);
     }
+    return 0;
 }
 
 MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
@@ -194,9 +220,12 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         REGISTER_UMOCK_ALIAS_TYPE(WEATHER_CLIENT_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(ALARM_TIMER_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(GUI_MGR_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(EVENT_LOOP_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(GUI_MGR_NOTIFICATION_CB, void*);
         REGISTER_UMOCK_ALIAS_TYPE(ON_ALARM_LOAD_CALLBACK, void*);
         REGISTER_UMOCK_ALIAS_TYPE(TEMPERATURE_UNITS, int);
+        REGISTER_UMOCK_ALIAS_TYPE(SOUND_CRESCENDO_CURVE, int);
+        REGISTER_UMOCK_ALIAS_TYPE(time_t, long);
 
         //REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
         REGISTER_GLOBAL_MOCK_HOOK(mem_shim_malloc, my_mem_shim_malloc);
@@ -212,9 +241,9 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         REGISTER_GLOBAL_MOCK_HOOK(alarm_scheduler_create, my_alarm_scheduler_create);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(alarm_scheduler_create, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(alarm_scheduler_destroy, my_alarm_scheduler_destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(alarm_scheduler_get_next_alarm_generation, my_alarm_scheduler_get_next_alarm_generation);
 
         REGISTER_GLOBAL_MOCK_RETURN(alarm_timer_init, 0);
-        REGISTER_GLOBAL_MOCK_HOOK(thread_mgr_sleep, my_thread_mgr_sleep);
         REGISTER_GLOBAL_MOCK_RETURN(get_time_value, &g_time_value);
 
         REGISTER_GLOBAL_MOCK_HOOK(sound_mgr_create, my_sound_mgr_create);
@@ -236,6 +265,11 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(weather_client_create, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(weather_client_destroy, my_weather_client_destroy);
 
+        REGISTER_GLOBAL_MOCK_HOOK(event_loop_create, my_event_loop_create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(event_loop_create, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(event_loop_destroy, my_event_loop_destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(event_loop_wait, my_event_loop_wait);
+
         result = umocktypes_charptr_register_types();
         CTEST_ASSERT_ARE_EQUAL(int, 0, result);
     }
@@ -269,6 +303,8 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         STRICT_EXPECTED_CALL(ntp_client_create());
 #endif
         STRICT_EXPECTED_CALL(weather_client_create(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(event_loop_create());
+        STRICT_EXPECTED_CALL(alarm_timer_init(IGNORED_ARG)).CallCannotFail();
         STRICT_EXPECTED_CALL(alarm_timer_init(IGNORED_ARG)).CallCannotFail();
         STRICT_EXPECTED_CALL(alarm_timer_init(IGNORED_ARG)).CallCannotFail();
         STRICT_EXPECTED_CALL(alarm_timer_init(IGNORED_ARG)).CallCannotFail();
@@ -288,20 +324,94 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
 
     static void setup_check_alarm_operation_mocks(const ALARM_INFO* triggered)
     {
-        STRICT_EXPECTED_CALL(get_time_value());
-        STRICT_EXPECTED_CALL(alarm_scheduler_is_triggered(IGNORED_ARG, IGNORED_ARG)).SetReturn(triggered);
-        if (triggered != NULL)
+        STRICT_EXPECTED_CALL(get_time());
+        if (triggered == NULL)
         {
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_due_alarms(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG)).SetReturn(0);
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_next_due_alarm(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+        }
+        else
+        {
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_due_alarms(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG))
+                .CopyOutArgumentBuffer_triggered_list(&triggered, sizeof(triggered))
+                .SetReturn(1);
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_fire_time(IGNORED_ARG, triggered)).SetReturn(TEST_FIRE_TIME);
+            STRICT_EXPECTED_CALL(get_time_usec());
+            STRICT_EXPECTED_CALL(latency_stats_add(IGNORED_ARG, IGNORED_ARG));
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_fire_time(IGNORED_ARG, triggered)).SetReturn(TEST_FIRE_TIME);
             STRICT_EXPECTED_CALL(gui_mgr_set_alarm_triggered(IGNORED_ARG, IGNORED_ARG));
+            STRICT_EXPECTED_CALL(get_time_usec());
+            STRICT_EXPECTED_CALL(latency_stats_add(IGNORED_ARG, IGNORED_ARG));
             STRICT_EXPECTED_CALL(config_mgr_get_audio_dir(IGNORED_ARG));
-            STRICT_EXPECTED_CALL(sound_mgr_play(IGNORED_ARG, IGNORED_ARG, true, true));
+            STRICT_EXPECTED_CALL(sound_mgr_play(IGNORED_ARG, IGNORED_ARG, true, false));
+            STRICT_EXPECTED_CALL(get_time_usec());
+            STRICT_EXPECTED_CALL(latency_stats_add(IGNORED_ARG, IGNORED_ARG));
             STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
 
+            STRICT_EXPECTED_CALL(sound_mgr_process(IGNORED_ARG));
             STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG));
             STRICT_EXPECTED_CALL(gui_mgr_set_alarm_triggered(IGNORED_ARG, IGNORED_ARG));
             STRICT_EXPECTED_CALL(alarm_scheduler_get_next_alarm(IGNORED_ARG));
+            STRICT_EXPECTED_CALL(alarm_scheduler_get_next_alarm_generation(IGNORED_ARG));
             STRICT_EXPECTED_CALL(gui_mgr_set_next_alarm(IGNORED_ARG, IGNORED_ARG));
         }
+        // The latency histograms are only logged once a day
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG)).SetReturn(false);
+    }
+
+    static void setup_prepare_alarm_loop_mocks(const ALARM_INFO* next_alarm, const time_t* fire_time, bool prepare)
+    {
+        STRICT_EXPECTED_CALL(get_time_value());
+        setup_check_ntp_operation_mocks();
+        setup_check_weather_operation_mocks();
+        STRICT_EXPECTED_CALL(get_time()).SetReturn(*fire_time - TEST_PREPARE_TIME);
+        STRICT_EXPECTED_CALL(alarm_scheduler_get_due_alarms(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG)).SetReturn(0);
+        STRICT_EXPECTED_CALL(alarm_scheduler_get_next_due_alarm(IGNORED_ARG, IGNORED_ARG))
+            .CopyOutArgumentBuffer_fire_time(fire_time, sizeof(*fire_time))
+            .SetReturn(next_alarm);
+        if (prepare)
+        {
+            STRICT_EXPECTED_CALL(config_mgr_get_audio_dir(IGNORED_ARG)).SetReturn(TEST_AUDIO_DIR);
+            STRICT_EXPECTED_CALL(sound_mgr_prepare(IGNORED_ARG, TEST_SOUND_PATH));
+        }
+        STRICT_EXPECTED_CALL(alarm_timer_is_expired(IGNORED_ARG)).SetReturn(false);
+        STRICT_EXPECTED_CALL(gui_mgr_set_time_item(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(gui_mgr_process_items(IGNORED_ARG));
+        setup_wait_for_next_event_mocks();
+    }
+
+    static void setup_run_application_start_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(config_mgr_create(IGNORED_ARG));
+        setup_initialize_mocks();
+        STRICT_EXPECTED_CALL(config_mgr_load_alarm(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(gui_mgr_create_win(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(get_time_value());
+        STRICT_EXPECTED_CALL(config_mgr_get_shade_times(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(config_mgr_is_demo_mode(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(config_mgr_get_alarm_prepare_time(IGNORED_ARG)).SetReturn(TEST_PREPARE_TIME);
+        STRICT_EXPECTED_CALL(config_mgr_get_sound_cache_size(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(sound_mgr_set_cache_limit(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(config_mgr_get_crescendo_time(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(gui_mgr_get_input_fd(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(event_loop_add_fd(IGNORED_ARG, IGNORED_ARG));
+        setup_check_ntp_operation_mocks();
+        setup_check_weather_operation_mocks();
+        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_scheduler_get_next_alarm(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_scheduler_get_next_alarm_generation(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(gui_mgr_set_next_alarm(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(gui_mgr_get_refresh_resolution());
+    }
+
+    static void setup_wait_for_next_event_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(get_time());
+        STRICT_EXPECTED_CALL(config_mgr_show_seconds(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alarm_scheduler_get_next_due_time(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(event_loop_wait(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
     }
 
     static void setup_cleanup_mocks(void)
@@ -314,6 +424,7 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         STRICT_EXPECTED_CALL(alarm_scheduler_destroy(IGNORED_ARG));
         STRICT_EXPECTED_CALL(config_mgr_destroy(IGNORED_ARG));
         STRICT_EXPECTED_CALL(weather_client_destroy(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(event_loop_destroy(IGNORED_ARG));
         STRICT_EXPECTED_CALL(free(IGNORED_ARG));
     }
 
@@ -327,27 +438,14 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
             "1a2b3c4d5e6f7g8h9i0j"
             };
 
-        STRICT_EXPECTED_CALL(config_mgr_create(IGNORED_ARG));
-        setup_initialize_mocks();
-        STRICT_EXPECTED_CALL(config_mgr_load_alarm(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(gui_mgr_create_win(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(get_time_value());
-        STRICT_EXPECTED_CALL(config_mgr_get_shade_times(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(config_mgr_is_demo_mode(IGNORED_ARG));
-        setup_check_ntp_operation_mocks();
-        setup_check_weather_operation_mocks();
-        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alarm_timer_start(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alarm_scheduler_get_next_alarm(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(gui_mgr_set_next_alarm(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(gui_mgr_get_refresh_resolution());
+        setup_run_application_start_mocks();
         STRICT_EXPECTED_CALL(get_time_value());
         setup_check_ntp_operation_mocks();
         setup_check_weather_operation_mocks();
         setup_check_alarm_operation_mocks(NULL);
         STRICT_EXPECTED_CALL(gui_mgr_set_time_item(IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(gui_mgr_process_items(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(thread_mgr_sleep(IGNORED_ARG));
+        setup_wait_for_next_event_mocks();
         setup_cleanup_mocks();
 
         // act
@@ -361,6 +459,70 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         // cleanup
     }
 
+    CTEST_FUNCTION(run_application_prepare_alarm_sound_succeed)
+    {
+        // arrange
+        int argc = 3;
+        char* argv[] = {
+            "/usr/bin/smartclock_exe",
+            "--weather_appid",
+            "1a2b3c4d5e6f7g8h9i0j"
+            };
+        ALARM_INFO next_alarm = {0};
+        next_alarm.alarm_text = "alarm text";
+        next_alarm.sound_file = "alarm_sound.wav";
+        time_t fire_time = TEST_FIRE_TIME;
+
+        setup_run_application_start_mocks();
+        setup_prepare_alarm_loop_mocks(&next_alarm, &fire_time, true);
+        setup_cleanup_mocks();
+
+        // act
+        g_close_iteration = 1;
+        int result = run_application(argc, argv);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(run_application_prepare_alarm_sound_next_day_succeed)
+    {
+        // arrange
+        int argc = 3;
+        char* argv[] = {
+            "/usr/bin/smartclock_exe",
+            "--weather_appid",
+            "1a2b3c4d5e6f7g8h9i0j"
+            };
+        ALARM_INFO next_alarm = {0};
+        next_alarm.alarm_text = "alarm text";
+        next_alarm.sound_file = "alarm_sound.wav";
+        next_alarm.alarm_id = MIN_ID_VALUE;
+        time_t fire_time = TEST_FIRE_TIME;
+        time_t next_fire_time = TEST_FIRE_TIME + 24*60*60;
+
+        setup_run_application_start_mocks();
+        setup_prepare_alarm_loop_mocks(&next_alarm, &fire_time, true);
+        // Already prepared for today's alarm
+        setup_prepare_alarm_loop_mocks(&next_alarm, &fire_time, false);
+        // The same recurring alarm is prepared again for tomorrow
+        setup_prepare_alarm_loop_mocks(&next_alarm, &next_fire_time, true);
+        setup_cleanup_mocks();
+
+        // act
+        g_close_iteration = 3;
+        int result = run_application(argc, argv);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
     CTEST_FUNCTION(run_application_no_arg_fail)
     {
         // arrange
@@ -421,4 +583,38 @@ CTEST_BEGIN_TEST_SUITE(smartclock_ut)
         umock_c_negative_tests_deinit();
     }
 
+    CTEST_FUNCTION(smartclock_get_alarm_latency_succeed)
+    {
+        // arrange
+
+        // act
+        const LATENCY_HISTOGRAM* detected = smartclock_get_alarm_latency(ALARM_LATENCY_DETECTED);
+        const LATENCY_HISTOGRAM* audible = smartclock_get_alarm_latency(ALARM_LATENCY_AUDIBLE);
+        const LATENCY_HISTOGRAM* queued = smartclock_get_alarm_latency(ALARM_LATENCY_QUEUED);
+
+        // assert
+        CTEST_ASSERT_IS_NOT_NULL(detected);
+        CTEST_ASSERT_IS_NOT_NULL(audible);
+        CTEST_ASSERT_IS_NOT_NULL(queued);
+        CTEST_ASSERT_IS_TRUE(detected != audible);
+        CTEST_ASSERT_IS_TRUE(queued != audible);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(smartclock_get_alarm_latency_invalid_stage_fail)
+    {
+        // arrange
+
+        // act
+        const LATENCY_HISTOGRAM* result = smartclock_get_alarm_latency(ALARM_LATENCY_STAGE_COUNT);
+
+        // assert
+        CTEST_ASSERT_IS_NULL(result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
 CTEST_END_TEST_SUITE(smartclock_ut)
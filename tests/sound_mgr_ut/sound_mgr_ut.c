@@ -6,8 +6,11 @@
 #else
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #endif
+#include <unistd.h>
 
 static void* my_mem_shim_malloc(size_t size)
 {
@@ -23,6 +26,7 @@ static void my_mem_shim_free(void* ptr)
 #include "lib-util-c/sys_debug_shim.h"
 #include "lib-util-c/crt_extensions.h"
 #include "lib-util-c/file_mgr.h"
+#include "sample_convert.h"
 
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -49,6 +53,9 @@ MOCKABLE_FUNCTION(, void, alDeleteSources, ALsizei, n, const ALuint*, sources);
 MOCKABLE_FUNCTION(, void, alSourcef, ALuint, source, ALenum, param, ALfloat, value);
 MOCKABLE_FUNCTION(, void, alSourcefv, ALuint, source, ALenum, param, const ALfloat*, values);
 MOCKABLE_FUNCTION(, void, alSourcei, ALuint, source, ALenum, param, ALint, value);
+MOCKABLE_FUNCTION(, void, alGetSourcei, ALuint, source, ALenum, param, ALint*, value);
+MOCKABLE_FUNCTION(, void, alSourceQueueBuffers, ALuint, source, ALsizei, nb, const ALuint*, buffers);
+MOCKABLE_FUNCTION(, void, alSourceUnqueueBuffers, ALuint, source, ALsizei, nb, ALuint*, buffers);
 
 MOCKABLE_FUNCTION(, void, alListenerfv, ALenum, param, const ALfloat*, values);
 
@@ -75,6 +82,17 @@ MOCKABLE_FUNCTION(, ALenum, alGetError);
 
 static const char* TEST_DEVICE_NAME = "test_device_name";
 static const char* TEST_SOUND_FILE = "test_sound_file";
+static const uint32_t TEST_CRESCENDO_TIME = 30000;
+static const float TEST_VOLUME = 0.5f;
+static const int64_t TEST_STREAM_FILE_SIZE = 1024*1024;
+// Matches the stream ring in sound_mgr_openal.c
+#define TEST_STREAM_BUFFER_SIZE     (32*1024)
+#define TEST_STREAM_HEADER_LEN      44
+#define TEST_STREAM_FORMAT_LEN      16
+// Bigger than the block the stream header used to be parsed from
+#define TEST_STREAM_METADATA_SIZE   (8*1024)
+// Two buffers longer than the ring
+#define TEST_STREAM_DATA_SIZE       (8*TEST_STREAM_BUFFER_SIZE)
 
 /* chunk size 2084*/
 static const unsigned char TEST_WAV_FILE[] = {
@@ -88,9 +106,21 @@ static const unsigned char TEST_WAV_FILE[] = {
     0x16, 0xf9, 0x18, 0xf9, 0x34, 0xe7, 0x23, 0xa6,
     0x3c, 0xf2, 0x24, 0xf2, 0x11, 0xce, 0x1a, 0x0d
 };
+// The samples actually in TEST_WAV_FILE after its 44 byte header
+#define TEST_WAV_SAMPLE_LEN     (sizeof(TEST_WAV_FILE) - 44)
+static const int TEST_WAV_SAMPLE_RATE = 22050;
 static size_t g_buffer_values = 0;
 static size_t g_source_values = 0;
 
+// Stream tests read a header, an optional LIST chunk of g_stream_metadata_size
+// and then TEST_STREAM_DATA_SIZE of silence
+static bool g_stream_file;
+static size_t g_stream_position;
+static uint32_t g_stream_metadata_size;
+static ALint g_buffers_processed;
+static ALint g_buffers_queued;
+static ALint g_source_state;
+
 #define TEST_xio_socket_INTERFACE_DESCRIPTION     (const IO_INTERFACE_DESCRIPTION*)0x4242
 
 static ALCdevice* my_alcOpenDevice(const ALCchar *devicename)
@@ -141,8 +171,25 @@ static void my_alDeleteSources(ALsizei n, const ALuint *sources)
     g_source_values--;
 }
 
+static void my_alGetSourcei(ALuint source, ALenum param, ALint* value)
+{
+    if (param == AL_BUFFERS_PROCESSED)
+    {
+        *value = g_buffers_processed;
+    }
+    else if (param == AL_BUFFERS_QUEUED)
+    {
+        *value = g_buffers_queued;
+    }
+    else if (param == AL_SOURCE_STATE)
+    {
+        *value = g_source_state;
+    }
+}
+
 static FILE_MGR_HANDLE my_file_mgr_open(const char* filename, const char* param)
 {
+    g_stream_position = 0;
     return (FILE_MGR_HANDLE)my_mem_shim_malloc(1);
 }
 
@@ -151,14 +198,74 @@ static void my_file_mgr_close(FILE_MGR_HANDLE handle)
     my_mem_shim_free(handle);
 }
 
+static int64_t my_file_mgr_get_length(FILE_MGR_HANDLE handle)
+{
+    return g_stream_file ? TEST_STREAM_FILE_SIZE : (int64_t)(sizeof(TEST_WAV_FILE)/sizeof(TEST_WAV_FILE[0]));
+}
+
+static size_t read_test_stream(unsigned char* buffer, size_t read_len)
+{
+    // RIFF and fmt chunks, then the LIST header, then the data header
+    unsigned char header[TEST_STREAM_HEADER_LEN + 8];
+    size_t format_end = TEST_STREAM_HEADER_LEN - 8;
+    size_t metadata_len = g_stream_metadata_size > 0 ? 8 + g_stream_metadata_size : 0;
+    size_t data_offset = TEST_STREAM_HEADER_LEN + metadata_len;
+    size_t stream_len = data_offset + TEST_STREAM_DATA_SIZE;
+    uint32_t riff_size = (uint32_t)(stream_len - 8);
+    uint32_t data_size = TEST_STREAM_DATA_SIZE;
+
+    memcpy(header, TEST_WAV_FILE, TEST_STREAM_HEADER_LEN);
+    memcpy(header + 4, &riff_size, sizeof(riff_size));
+    memcpy(header + format_end + 4, &data_size, sizeof(data_size));
+    memcpy(header + TEST_STREAM_HEADER_LEN, "LIST", 4);
+    memcpy(header + TEST_STREAM_HEADER_LEN + 4, &g_stream_metadata_size, sizeof(g_stream_metadata_size));
+
+    if (read_len > stream_len - g_stream_position)
+    {
+        read_len = stream_len - g_stream_position;
+    }
+    for (size_t index = 0; index < read_len; index++, g_stream_position++)
+    {
+        if (g_stream_position < format_end)
+        {
+            buffer[index] = header[g_stream_position];
+        }
+        else if (metadata_len > 0 && g_stream_position < format_end + 8)
+        {
+            buffer[index] = header[TEST_STREAM_HEADER_LEN + g_stream_position - format_end];
+        }
+        else if (g_stream_position >= data_offset - 8 && g_stream_position < data_offset)
+        {
+            buffer[index] = header[format_end + g_stream_position - (data_offset - 8)];
+        }
+        else
+        {
+            buffer[index] = 0;
+        }
+    }
+    return read_len;
+}
+
 static size_t my_file_mgr_read(FILE_MGR_HANDLE handle, unsigned char* buffer, size_t read_len)
 {
+    if (g_stream_file)
+    {
+        return read_test_stream(buffer, read_len);
+    }
     size_t test_wav_file_len = sizeof(TEST_WAV_FILE)/sizeof(TEST_WAV_FILE[0]);
     size_t total_size = read_len < test_wav_file_len ? read_len : test_wav_file_len;
     memcpy(buffer, TEST_WAV_FILE, total_size);
     return total_size;
 }
 
+static int my_clone_string(char** target, const char* source)
+{
+    size_t len = strlen(source);
+    *target = my_mem_shim_malloc(len+1);
+    strcpy(*target, source);
+    return 0;
+}
+
 MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 {
@@ -206,7 +313,9 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         REGISTER_GLOBAL_MOCK_RETURN(alcMakeContextCurrent, 1);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(alcMakeContextCurrent, 0);
 
-        REGISTER_GLOBAL_MOCK_RETURN(file_mgr_get_length, sizeof(TEST_WAV_FILE)/sizeof(TEST_WAV_FILE[0]));
+        REGISTER_GLOBAL_MOCK_HOOK(alGetSourcei, my_alGetSourcei);
+
+        REGISTER_GLOBAL_MOCK_HOOK(file_mgr_get_length, my_file_mgr_get_length);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(file_mgr_get_length, 0);
         REGISTER_GLOBAL_MOCK_HOOK(file_mgr_open, my_file_mgr_open);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(file_mgr_open, NULL);
@@ -214,6 +323,9 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         REGISTER_GLOBAL_MOCK_HOOK(file_mgr_read, my_file_mgr_read);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(file_mgr_read, __LINE__);
 
+        REGISTER_GLOBAL_MOCK_HOOK(clone_string, my_clone_string);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(clone_string, __LINE__);
+
         result = umocktypes_charptr_register_types();
         CTEST_ASSERT_ARE_EQUAL(int, 0, result);
     }
@@ -228,6 +340,12 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         umock_c_reset_all_calls();
         g_buffer_values = 0;
         g_source_values = 0;
+        g_stream_file = false;
+        g_stream_position = 0;
+        g_stream_metadata_size = 0;
+        g_buffers_processed = 0;
+        g_buffers_queued = 0;
+        g_source_state = AL_PLAYING;
     }
 
     CTEST_FUNCTION_CLEANUP()
@@ -251,36 +369,25 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         STRICT_EXPECTED_CALL(alcCreateContext(IGNORED_ARG, NULL));
         STRICT_EXPECTED_CALL(alcMakeContextCurrent(IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-    }
-
-    static void setup_construct_data_buffer_mocks(bool failure)
-    {
-        STRICT_EXPECTED_CALL(alGenBuffers(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alBufferData(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        setup_validate_al_error_mocks(failure);
-        STRICT_EXPECTED_CALL(alGenSources(IGNORED_ARG, IGNORED_ARG));
-        setup_validate_al_error_mocks(failure);
-        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        setup_validate_al_error_mocks(failure);
-        STRICT_EXPECTED_CALL(alSourcefv(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alSourcefv(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGenSources(1, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError());
+        STRICT_EXPECTED_CALL(alSourcefv(IGNORED_ARG, AL_POSITION, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcefv(IGNORED_ARG, AL_VELOCITY, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, AL_PITCH, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alListenerfv(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alListenerfv(AL_POSITION, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alListenerfv(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alListenerfv(AL_VELOCITY, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
-        STRICT_EXPECTED_CALL(alListenerfv(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alListenerfv(AL_ORIENTATION, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(alGenBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError());
     }
 
-    static void setup_play_mocks(bool failure)
+    static void setup_load_sound_file_mocks(bool failure)
     {
         STRICT_EXPECTED_CALL(file_mgr_open(TEST_SOUND_FILE, "rb"));
         STRICT_EXPECTED_CALL(file_mgr_get_length(IGNORED_ARG));
@@ -288,12 +395,88 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG)).
             CopyOutArgumentBuffer_buffer(TEST_WAV_FILE, sizeof(unsigned char**));
         STRICT_EXPECTED_CALL(file_mgr_close(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGenBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alBufferData(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        setup_validate_al_error_mocks(failure);
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, TEST_SOUND_FILE));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+    }
 
-        setup_construct_data_buffer_mocks(failure);
+    static void setup_construct_source_mocks(bool failure)
+    {
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_BUFFER, IGNORED_ARG));
+        setup_validate_al_error_mocks(failure);
+    }
 
-        // Construct Data buffer
+    static void setup_prepare_mocks(bool failure)
+    {
+        setup_load_sound_file_mocks(failure);
+        setup_construct_source_mocks(failure);
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, TEST_SOUND_FILE));
+    }
+
+    static void setup_start_source_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, AL_GAIN, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_LOOPING, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
         STRICT_EXPECTED_CALL(alSourcePlay(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+    }
+
+    static void setup_play_mocks(bool failure)
+    {
+        setup_prepare_mocks(failure);
+        setup_start_source_mocks();
+    }
+
+    static void setup_queue_stream_buffer_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alBufferData(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG, TEST_STREAM_BUFFER_SIZE, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError());
+        STRICT_EXPECTED_CALL(alSourceQueueBuffers(IGNORED_ARG, 1, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError());
+    }
+
+    static void setup_open_stream_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(file_mgr_open(TEST_SOUND_FILE, "rb"));
+        STRICT_EXPECTED_CALL(file_mgr_get_length(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
+        // RIFF header and WAVE tag, then the fmt chunk
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 12));
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 8));
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, TEST_STREAM_FORMAT_LEN));
+        if (g_stream_metadata_size > 0)
+        {
+            STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 8));
+            STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, g_stream_metadata_size));
+        }
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 8));
+        setup_construct_source_mocks(false);
+        // The whole ring is filled up front
+        for (size_t index = 0; index < 6; index++)
+        {
+            setup_queue_stream_buffer_mocks();
+        }
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, TEST_SOUND_FILE));
+    }
+
+    static void setup_unqueue_stream_buffers_mocks(ALint processed)
+    {
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_BUFFERS_PROCESSED, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourceUnqueueBuffers(IGNORED_ARG, processed, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError());
+    }
+
+    static SOUND_MGR_HANDLE create_playing_stream(bool set_repeat)
+    {
+        SOUND_MGR_HANDLE result = sound_mgr_create();
+        g_stream_file = true;
+        (void)sound_mgr_play(result, TEST_SOUND_FILE, set_repeat, false);
+        umock_c_reset_all_calls();
+        return result;
     }
 
     CTEST_FUNCTION(sound_mgr_create_succeed)
@@ -358,8 +541,8 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         SOUND_MGR_HANDLE handle = sound_mgr_create();
         umock_c_reset_all_calls();
 
-        //STRICT_EXPECTED_CALL(alDeleteSources(IGNORED_ARG, IGNORED_ARG));
-        //STRICT_EXPECTED_CALL(alDeleteBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alDeleteSources(1, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alDeleteBuffers(IGNORED_ARG, IGNORED_ARG));
         STRICT_EXPECTED_CALL(alcMakeContextCurrent(IGNORED_ARG));
         STRICT_EXPECTED_CALL(alcDestroyContext(IGNORED_ARG));
         STRICT_EXPECTED_CALL(alcCloseDevice(IGNORED_ARG));
@@ -414,6 +597,10 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         SOUND_MGR_HANDLE handle = sound_mgr_create();
         umock_c_reset_all_calls();
 
+        // Keep every failed attempt from leaving a cached buffer behind
+        (void)sound_mgr_set_cache_limit(handle, 0);
+        umock_c_reset_all_calls();
+
         int negativeTestsInitResult = umock_c_negative_tests_init();
         CTEST_ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
 
@@ -440,6 +627,431 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         umock_c_negative_tests_deinit();
     }
 
+    CTEST_FUNCTION(sound_mgr_play_prepared_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_prepare(handle, TEST_SOUND_FILE);
+        umock_c_reset_all_calls();
+
+        setup_start_source_mocks();
+
+        // act
+        int result = sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_play_cached_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+        (void)sound_mgr_stop(handle);
+        umock_c_reset_all_calls();
+
+        setup_construct_source_mocks(false);
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, TEST_SOUND_FILE));
+        setup_start_source_mocks();
+
+        // act
+        int result = sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_cache_limit_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        int result = sound_mgr_set_cache_limit(NULL, 0);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_cache_limit_evicts_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+        (void)sound_mgr_stop(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(alDeleteBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_set_cache_limit(handle, 0);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        int result = sound_mgr_prepare(NULL, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        setup_prepare_mocks(false);
+
+        // act
+        int result = sound_mgr_prepare(handle, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_IDLE, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    static void create_test_wav_file(char* wav_path, const unsigned char* wav_file, size_t wav_len)
+    {
+        int wav_fd = mkstemp(wav_path);
+        CTEST_ASSERT_IS_TRUE(wav_fd >= 0);
+        CTEST_ASSERT_ARE_EQUAL(int, (int)wav_len, (int)write(wav_fd, wav_file, wav_len));
+        (void)close(wav_fd);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_mapped_file_succeed)
+    {
+        // arrange
+        char wav_path[] = "/tmp/sound_mgr_ut_XXXXXX";
+        create_test_wav_file(wav_path, TEST_WAV_FILE, sizeof(TEST_WAV_FILE));
+
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        // Parsed from the mapping without file_mgr, the data chunk claims more
+        // than the file holds so only the samples in the file are uploaded
+        STRICT_EXPECTED_CALL(alGenBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alBufferData(IGNORED_ARG, AL_FORMAT_STEREO16, IGNORED_ARG, TEST_WAV_SAMPLE_LEN, TEST_WAV_SAMPLE_RATE));
+        STRICT_EXPECTED_CALL(alGetError());
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, wav_path));
+        setup_construct_source_mocks(false);
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, wav_path));
+
+        // act
+        int result = sound_mgr_prepare(handle, wav_path);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+        (void)unlink(wav_path);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_mapped_file_max_chunk_size_succeed)
+    {
+        // arrange
+        char wav_path[] = "/tmp/sound_mgr_ut_XXXXXX";
+        unsigned char wav_file[sizeof(TEST_WAV_FILE)];
+        memcpy(wav_file, TEST_WAV_FILE, sizeof(TEST_WAV_FILE));
+        // RIFF and DATA sizes that wrap a signed int or the data pointer
+        memset(&wav_file[4], 0xFF, 4);
+        memset(&wav_file[40], 0xFF, 4);
+        create_test_wav_file(wav_path, wav_file, sizeof(wav_file));
+
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(alGenBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alBufferData(IGNORED_ARG, AL_FORMAT_STEREO16, IGNORED_ARG, TEST_WAV_SAMPLE_LEN, TEST_WAV_SAMPLE_RATE));
+        STRICT_EXPECTED_CALL(alGetError());
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, wav_path));
+        setup_construct_source_mocks(false);
+        STRICT_EXPECTED_CALL(clone_string(IGNORED_ARG, wav_path));
+
+        // act
+        int result = sound_mgr_prepare(handle, wav_path);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+        (void)unlink(wav_path);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_playing_fail)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+        umock_c_reset_all_calls();
+
+        // act
+        int result = sound_mgr_prepare(handle, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_stream_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        g_stream_file = true;
+        umock_c_reset_all_calls();
+
+        setup_open_stream_mocks();
+
+        // act
+        int result = sound_mgr_prepare(handle, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_stream_large_metadata_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        g_stream_file = true;
+        g_stream_metadata_size = TEST_STREAM_METADATA_SIZE;
+        umock_c_reset_all_calls();
+
+        setup_open_stream_mocks();
+
+        // act
+        int result = sound_mgr_prepare(handle, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_prepare_stream_no_data_fail)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(file_mgr_open(TEST_SOUND_FILE, "rb"));
+        STRICT_EXPECTED_CALL(file_mgr_get_length(IGNORED_ARG)).SetReturn(TEST_STREAM_FILE_SIZE);
+        STRICT_EXPECTED_CALL(malloc(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 12));
+        // Every read hands back the RIFF header, so the file ends while
+        // skipping it as an unknown chunk
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, 8));
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_BUFFER, AL_NONE));
+        STRICT_EXPECTED_CALL(alGetError());
+        STRICT_EXPECTED_CALL(file_mgr_close(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_prepare(handle, TEST_SOUND_FILE);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_IDLE, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        int result = sound_mgr_process(NULL);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_not_streaming_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+        umock_c_reset_all_calls();
+
+        // act
+        int result = sound_mgr_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_stream_refill_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = create_playing_stream(false);
+        g_buffers_processed = 2;
+
+        setup_unqueue_stream_buffers_mocks(2);
+        setup_queue_stream_buffer_mocks();
+        setup_queue_stream_buffer_mocks();
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_SOURCE_STATE, IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_PLAYING, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_stream_repeat_rewinds_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = create_playing_stream(true);
+        g_buffers_processed = 3;
+
+        setup_unqueue_stream_buffers_mocks(3);
+        setup_queue_stream_buffer_mocks();
+        setup_queue_stream_buffer_mocks();
+        // The third buffer starts the track over
+        STRICT_EXPECTED_CALL(file_mgr_close(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(file_mgr_open(TEST_SOUND_FILE, "rb"));
+        STRICT_EXPECTED_CALL(file_mgr_read(IGNORED_ARG, IGNORED_ARG, TEST_STREAM_HEADER_LEN));
+        setup_queue_stream_buffer_mocks();
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_SOURCE_STATE, IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_PLAYING, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_stream_underrun_restarts_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = create_playing_stream(false);
+        g_buffers_processed = 6;
+        g_buffers_queued = 2;
+        g_source_state = AL_STOPPED;
+
+        setup_unqueue_stream_buffers_mocks(6);
+        setup_queue_stream_buffer_mocks();
+        setup_queue_stream_buffer_mocks();
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_SOURCE_STATE, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_BUFFERS_QUEUED, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcePlay(IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_PLAYING, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_process_stream_end_of_track_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = create_playing_stream(false);
+        // Queue the rest of the track
+        g_buffers_processed = 2;
+        (void)sound_mgr_process(handle);
+        umock_c_reset_all_calls();
+
+        g_buffers_processed = 6;
+        g_buffers_queued = 0;
+        g_source_state = AL_STOPPED;
+
+        setup_unqueue_stream_buffers_mocks(6);
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_SOURCE_STATE, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetSourcei(IGNORED_ARG, AL_BUFFERS_QUEUED, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_BUFFER, AL_NONE));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(file_mgr_close(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_process(handle);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(int, SOUND_STATE_IDLE, sound_mgr_get_current_state(handle));
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
     CTEST_FUNCTION(sound_mgr_stop_handle_NULL_fail)
     {
         // arrange
@@ -462,8 +1074,9 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(alSourceStop(IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alDeleteSources(IGNORED_ARG, IGNORED_ARG));
-        STRICT_EXPECTED_CALL(alDeleteBuffers(IGNORED_ARG, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_BUFFER, AL_NONE));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(free(IGNORED_ARG));
 
         // act
         result = sound_mgr_stop(handle);
@@ -497,6 +1110,8 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
     {
         // arrange
         SOUND_MGR_HANDLE handle = sound_mgr_create();
+        // Without a ramp thread calling into the mocks
+        (void)sound_mgr_set_crescendo(handle, SOUND_CRESCENDO_LINEAR, 0);
         int result = sound_mgr_play(handle, TEST_SOUND_FILE, true, true);
         umock_c_reset_all_calls();
 
@@ -548,4 +1163,117 @@ CTEST_BEGIN_TEST_SUITE(sound_mgr_ut)
         sound_mgr_destroy(handle);
     }
 
+    CTEST_FUNCTION(sound_mgr_set_crescendo_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        int result = sound_mgr_set_crescendo(NULL, SOUND_CRESCENDO_LINEAR, TEST_CRESCENDO_TIME);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_crescendo_invalid_curve_fail)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        // act
+        int result = sound_mgr_set_crescendo(handle, (SOUND_CRESCENDO_CURVE)(SOUND_CRESCENDO_S_CURVE + 1), TEST_CRESCENDO_TIME);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_play_crescendo_disabled_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_set_volume(handle, TEST_VOLUME);
+        (void)sound_mgr_set_crescendo(handle, SOUND_CRESCENDO_LOUDNESS, 0);
+        umock_c_reset_all_calls();
+
+        setup_prepare_mocks(false);
+        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, AL_GAIN, TEST_VOLUME));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(alSourcei(IGNORED_ARG, AL_LOOPING, IGNORED_ARG));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+        STRICT_EXPECTED_CALL(alSourcePlay(IGNORED_ARG));
+
+        // act
+        int result = sound_mgr_play(handle, TEST_SOUND_FILE, true, true);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_volume_handle_NULL_fail)
+    {
+        // arrange
+
+        // act
+        int result = sound_mgr_set_volume(NULL, TEST_VOLUME);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_volume_out_of_range_fail)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        umock_c_reset_all_calls();
+
+        // act
+        int result = sound_mgr_set_volume(handle, 1.5f);
+
+        // assert
+        CTEST_ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        CTEST_ASSERT_IS_TRUE(sound_mgr_get_volume(handle) == 1.0f);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_destroy(handle);
+    }
+
+    CTEST_FUNCTION(sound_mgr_set_volume_playing_succeed)
+    {
+        // arrange
+        SOUND_MGR_HANDLE handle = sound_mgr_create();
+        (void)sound_mgr_play(handle, TEST_SOUND_FILE, true, false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(alSourcef(IGNORED_ARG, AL_GAIN, TEST_VOLUME));
+        STRICT_EXPECTED_CALL(alGetError()).CallCannotFail();
+
+        // act
+        int result = sound_mgr_set_volume(handle, TEST_VOLUME);
+
+        // assert
+        CTEST_ASSERT_ARE_EQUAL(int, 0, result);
+        CTEST_ASSERT_IS_TRUE(sound_mgr_get_volume(handle) == TEST_VOLUME);
+        CTEST_ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        sound_mgr_stop(handle);
+        sound_mgr_destroy(handle);
+    }
+
 CTEST_END_TEST_SUITE(sound_mgr_ut)